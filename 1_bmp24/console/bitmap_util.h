@@ -8,7 +8,7 @@ using namespace std;
 
 // important: inputRowBytesCount, outputRowBytesCount - row sizes without padding 
 template<typename T>
-static void increaseResolution(T* inputRow, T* outputRow, uint64_t inputRowPixelsCount, uint64_t outputRowPixelsCount, uint64_t coeff) {
+static void increaseResolution(const T* inputRow, T* outputRow, uint64_t inputRowPixelsCount, uint64_t outputRowPixelsCount, uint64_t coeff) {
     for (uint64_t i = 0; i < inputRowPixelsCount; i++) {
         for (uint64_t j = 0; j < coeff; j++) {
             outputRow[i * coeff + j] = inputRow[i];
@@ -21,7 +21,7 @@ static void increaseResolution(T* inputRow, T* outputRow, uint64_t inputRowPixel
 
 // important: inputRowBytesCount, outputRowBytesCount - row sizes without padding
 template<typename T>
-static void decreaseResolution(T* inputRow, T* outputRow, uint64_t inputRowPixelsCount, uint64_t outputRowPixelsCount, uint64_t coeff) {
+static void decreaseResolution(const T* inputRow, T* outputRow, uint64_t inputRowPixelsCount, uint64_t outputRowPixelsCount, uint64_t coeff) {
     for (uint64_t i = 0, j = 0; i < outputRowPixelsCount; i += 1, j += coeff) {
         outputRow[i] = inputRow[j];
         if (i >= outputRowPixelsCount || j >= inputRowPixelsCount) {
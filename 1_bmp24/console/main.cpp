@@ -3,17 +3,19 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cmath>
-#include <fstream>
 #include <memory>
 #include <utility>
 #include "bitmap.h"
 #include "bitmap_util.h"
+#include "../../common/mappedbitmap.h"
+#include "../../common/areadownscaler.h"
 
 using namespace std;
 
 enum class WorkMode {
     INCREASE,
-    DECREASE
+    DECREASE,
+    AVERAGE
 };
 
 int main(int argc, char** argv) {
@@ -22,29 +24,24 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    ifstream inputStream;
-    inputStream.open(argv[3], std::ios_base::binary);
-
-    ofstream outputStream;
-    outputStream.open(argv[4], std::ios_base::binary);
-
-    if (!inputStream.is_open() || !outputStream.is_open()) {
-        cerr << "Can't open files!" << endl;
+    std::unique_ptr<MappedBitmapReader> input;
+    try {
+        input = std::make_unique<MappedBitmapReader>(argv[3]);
+    } catch (const std::exception& exception) {
+        cerr << exception.what() << endl;
         return 2;
     }
 
     BitmapFileHeader bitmapInputFileHeader;
     BitmapInfoHeader bitmapInputInfoHeader;
-
-    inputStream.read((char*)&bitmapInputFileHeader, sizeof(BitmapFileHeader));
-    if (bitmapInputFileHeader.bfType != 0x4d42) {
-        cerr << "Not BMP file!" << endl;
+    try {
+        input->readHeaders(bitmapInputFileHeader, bitmapInputInfoHeader);
+    } catch (const std::exception& exception) {
+        cerr << exception.what() << endl;
         return 3;
     }
 
-    inputStream.read((char*)&bitmapInputInfoHeader, sizeof(BitmapInfoHeader));
-
-    if (bitmapInputInfoHeader.biBitCount != 24) {
+    if (input->getBitCount() != 24) {
         cerr << "Not 24 bit BMP file!" << endl;
         return 4;
     }
@@ -55,23 +52,35 @@ int main(int argc, char** argv) {
     }
     else if (!strcmp("-dec", argv[1])) {
         workMode = WorkMode::DECREASE;
+    }
+    else if (!strcmp("-avg", argv[1])) {
+        workMode = WorkMode::AVERAGE;
     } else {
         cerr << "Unknown work mode \"" << argv[1] << "\"!" << endl;
         return 5;
     }
 
+    // -avg takes a real factor >= 1
     int32_t coeff = std::atoi(argv[2]);
-    if (coeff <= 0) {
+    double averageFactor = std::atof(argv[2]);
+    if (workMode == WorkMode::AVERAGE ? averageFactor < 1 : coeff <= 0) {
         cerr << "Coefficient is not correct!" << endl;
         return 6;
     }
 
-    int32_t inputWidthPx = bitmapInputInfoHeader.biWidth;
-    int32_t inputHeightPx = bitmapInputInfoHeader.biHeight;
+    int32_t inputWidthPx = input->getWidth();
+    int32_t inputHeightPx = input->getHeight();
 
     int32_t outputWidthPx = workMode == WorkMode::INCREASE? inputWidthPx * coeff : divideWithCeil(inputWidthPx, coeff);
     int32_t outputHeight = workMode == WorkMode::INCREASE? inputHeightPx * coeff : divideWithCeil(inputHeightPx, coeff);
 
+    std::unique_ptr<AreaDownscaler<Bitmap24Pixel>> areaDownscaler;
+    if (workMode == WorkMode::AVERAGE) {
+        areaDownscaler = std::make_unique<AreaDownscaler<Bitmap24Pixel>>(inputWidthPx, inputHeightPx, averageFactor);
+        outputWidthPx = areaDownscaler->getOutputWidth();
+        outputHeight = areaDownscaler->getOutputHeight();
+    }
+
     // if (outputWidth <= 0 || inputWidth <= 0) {
     //     cerr << "Coefficient is too large!" << endl;
     //     return 5;
@@ -80,57 +89,44 @@ int main(int argc, char** argv) {
     BitmapFileHeader bitmapOutputFileHeader = bitmapInputFileHeader;
     BitmapInfoHeader bitmapOutputInfoHeader = bitmapInputInfoHeader;
 
-    uint64_t inputRowBytesCount = inputWidthPx * 3;
     uint64_t outputRowBytesCount = outputWidthPx * 3;
 
-    uint64_t inputRowBytesCountWithPadding = getRowSizeWithPadding(inputRowBytesCount);
-    uint64_t outputRowBytesCountWithPadding = getRowSizeWithPadding(outputRowBytesCount);
-
-    std::unique_ptr<uint8_t[]> inputRow = std::make_unique<uint8_t[]>(inputRowBytesCountWithPadding);
-    std::unique_ptr<uint8_t[]> outputRow = std::make_unique<uint8_t[]>(outputRowBytesCountWithPadding);
-
     bitmapOutputFileHeader.bfSize = sizeof(BitmapFileHeader) + sizeof(BitmapInfoHeader) + outputRowBytesCount * outputHeight;
     bitmapOutputFileHeader.bfOffBits = sizeof(BitmapFileHeader) + sizeof(BitmapInfoHeader);
-    outputStream.write((char*)&bitmapOutputFileHeader, sizeof(BitmapFileHeader));
 
     bitmapOutputInfoHeader.biWidth = outputWidthPx;
     bitmapOutputInfoHeader.biHeight = outputHeight;
-    outputStream.write((char*)&bitmapOutputInfoHeader, sizeof(BitmapInfoHeader));
+
+    std::unique_ptr<MappedBitmapWriter> output;
+    try {
+        output = std::make_unique<MappedBitmapWriter>(argv[4], bitmapOutputFileHeader, bitmapOutputInfoHeader,
+                                                      outputWidthPx, outputHeight);
+    } catch (const std::exception& exception) {
+        cerr << exception.what() << endl;
+        return 7;
+    }
 
     if (workMode == WorkMode::INCREASE) {
         for (int32_t i = 0; i < inputHeightPx; i++) {
-            inputStream.read((char*)inputRow.get(), inputRowBytesCountWithPadding);
-            if (inputStream.fail()) {
-                cerr << "Error reading source image!" << endl;
-                return 6;
-            }
-            increaseResolution((Bitmap24Pixel*)inputRow.get(), (Bitmap24Pixel*)outputRow.get(), inputWidthPx, outputWidthPx, coeff);
-            for (int32_t duplication = 0; duplication < coeff; duplication++) {
-                outputStream.write((char*)outputRow.get(), outputRowBytesCountWithPadding);
-                if (outputStream.fail()) {
-                    cerr << "Error writing to file!" << endl;
-                    return 7;
-                }
+            uint8_t* outputRow = output->getRow(i * coeff);
+            increaseResolution((const Bitmap24Pixel*)input->getRow(i), (Bitmap24Pixel*)outputRow, inputWidthPx, outputWidthPx, coeff);
+            for (int32_t duplication = 1; duplication < coeff; duplication++) {
+                memcpy(output->getRow(i * coeff + duplication), outputRow, outputRowBytesCount);
             }
         }
     } else if (workMode == WorkMode::DECREASE) {
         uint32_t iterationsCount = divideWithCeil(inputHeightPx, coeff);
         for (uint32_t i = 0; i < iterationsCount; i++) {
-            inputStream.read((char*)inputRow.get(), inputRowBytesCountWithPadding);
-            if (inputStream.fail()) {
-                cerr << "Error reading source image!" << endl;
-                return 6;
-            }
-            inputStream.seekg(inputRowBytesCountWithPadding * (coeff - 1), ios_base::cur);
-            decreaseResolution((Bitmap24Pixel*)inputRow.get(), (Bitmap24Pixel*)outputRow.get(), inputWidthPx, outputWidthPx, coeff);
-            outputStream.write((char*)outputRow.get(), outputRowBytesCountWithPadding);
-            if (outputStream.fail()) {
-                cerr << "Error writing to file!" << endl;
-                return 7;
-            }
+            decreaseResolution((const Bitmap24Pixel*)input->getRow(i * coeff), (Bitmap24Pixel*)output->getRow(i), inputWidthPx, outputWidthPx, coeff);
+        }
+    } else if (workMode == WorkMode::AVERAGE) {
+        input->adviseSequential();
+        auto writeRow = [&output, outputRowBytesCount](uint64_t row, const Bitmap24Pixel* pixels) {
+            memcpy(output->getRow(row), pixels, outputRowBytesCount);
+        };
+        for (int32_t i = 0; i < inputHeightPx; i++) {
+            areaDownscaler->addRow((const Bitmap24Pixel*)input->getRow(i), writeRow);
         }
     }
-    outputStream.close();
-    inputStream.close();
     return 0;
 }
\ No newline at end of file
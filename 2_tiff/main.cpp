@@ -8,18 +8,20 @@
 #include "bitmap.h"
 #include "imageutils.h"
 #include "tiff.h"
+#include "../common/areadownscaler.h"
 
 using namespace std;
 
 enum class WorkMode {
     INCREASE,
-    DECREASE
+    DECREASE,
+    AVERAGE
 };
 
 Bitmap24Image getBitmap24ImageWithFilledHeaders(int32_t width, int32_t height);
 
 int main(int argc, char** argv) {
-    if (argc != 7) {
+    if (argc != 7 && argc != 8) {
         cerr << "Wrong parameters count!" << endl;
         return 1;
     }
@@ -27,14 +29,18 @@ int main(int argc, char** argv) {
     WorkMode workMode;
     if (!strcmp("-dec", argv[1])) {
         workMode = WorkMode::DECREASE;
+    } else if (!strcmp("-avg", argv[1])) {
+        workMode = WorkMode::AVERAGE;
     } else {
         cerr << "Unknown work mode \"" << argv[1] << "\"!" << endl;
         return 2;
     }
 
 
+    // -avg takes a real factor >= 1
     int32_t scaleCoeff = std::atoi(argv[2]);
-    if (scaleCoeff <= 0) {
+    double averageFactor = std::atof(argv[2]);
+    if (workMode == WorkMode::AVERAGE ? averageFactor < 1 : scaleCoeff <= 0) {
         cerr << "Coefficient is not correct!" << endl;
         return 3;
     }
@@ -54,6 +60,21 @@ int main(int argc, char** argv) {
         return 3;
     }
 
+    // Borders are estimated from random pixels if the error bound of the discarded pixel fractions is given,
+    // then the statistics pass reads only a part of the image
+    double statisticsErrorBound = 0;
+    if (argc == 8) {
+        try {
+            statisticsErrorBound = std::stod(argv[7]);
+        } catch (...) {
+            statisticsErrorBound = 0;
+        }
+        if (statisticsErrorBound <= 0 || statisticsErrorBound >= 1) {
+            std::cerr << "Statistics error bound is not correct!" << std::endl;
+            return 3;
+        }
+    }
+
     Tiff16RGBImage tiffImage;
     tiffImage.inputStream.open(argv[3], std::ios_base::binary);
 
@@ -65,46 +86,23 @@ int main(int argc, char** argv) {
         return 4;
     }
 
-    TiffFileHeader tiffInputFileHeader;
-    tiffImage.inputStream.read((char*)&tiffInputFileHeader, sizeof(TiffFileHeader));
-    if (tiffInputFileHeader.byteOrder != 0x4949) {
-        cerr << "Not little-endian TIFF!" << endl;
+    try {
+        tiffImage.readDirectory();
+    } catch (const std::runtime_error& e) {
+        cerr << e.what() << endl;
         return 5;
     }
+    tiffImage.mapFile(argv[3]);
 
-    if (tiffInputFileHeader.versionNumber != 42) {
-        cerr << "Unknown TIFF version!" << endl;
-        return 6;
-    }
-
-    tiffImage.inputStream.seekg(tiffInputFileHeader.offsetIFD, std::ios::beg);
-
-
-    uint16_t numberEntries;
-    tiffImage.inputStream.read((char*)&numberEntries, sizeof(uint16_t));
-    if (tiffImage.inputStream.fail()) {
-        cerr << "Error reading source image!" << endl;
-        return 7;
-    };
-    TiffIFD tiffIDF(numberEntries);
-    tiffImage.inputStream.read((char*)tiffIDF.entries.get(), numberEntries * sizeof(TiffIFDEntry));
-    if (tiffImage.inputStream.fail()) {
-        cerr << "Error reading source image!" << endl;
-        return 8;
-    };
-
-    for (int i = 0; i < numberEntries; i++) {
-        auto entry = tiffIDF.entries.get()[i];
-        auto tag = tiffIDF.entries.get()[i].tag;
-        tiffImage.setValueByKey(tag, tiffIDF.entries.get()[i].valueOffset, tiffIDF.entries.get()[i].numberValues);
-        cout << "Tag = " << tag << "; numberValues = " << entry.numberValues;
+    for (const BigTiffIFDEntry& entry : tiffImage.directory.entries) {
+        cout << "Tag = " << entry.tag << "; numberValues = " << entry.numberValues;
         if (entry.numberValues == 1) {
             cout << "; value = " << entry.valueOffset << endl;
         } else {
             cout << "; values = ";
             try {
-                auto data = tiffImage.getValuesVector(entry.tag, entry.valueOffset, entry.numberValues,  static_cast<FieldType>(entry.fieldType));
-                for (int j = 0; j < entry.numberValues; j++) {
+                auto data = tiffImage.getValuesVector(entry);
+                for (uint64_t j = 0; j < entry.numberValues; j++) {
                     cout << data[j] << " ";
                     if (j > 3) {
                         cout << "...";
@@ -134,6 +132,13 @@ int main(int argc, char** argv) {
     int32_t outputWidthPx = workMode == WorkMode::INCREASE? inputWidthPx * scaleCoeff : divideWithCeil(inputWidthPx, scaleCoeff);
     int32_t outputHeight = workMode == WorkMode::INCREASE? inputHeightPx * scaleCoeff : divideWithCeil(inputHeightPx, scaleCoeff);
 
+    std::unique_ptr<AreaDownscaler<Tiff16RGBPixel>> areaDownscaler;
+    if (workMode == WorkMode::AVERAGE) {
+        areaDownscaler = std::make_unique<AreaDownscaler<Tiff16RGBPixel>>(inputWidthPx, inputHeightPx, averageFactor);
+        outputWidthPx = areaDownscaler->getOutputWidth();
+        outputHeight = areaDownscaler->getOutputHeight();
+    }
+
     Bitmap24Image bitmap24Image = getBitmap24ImageWithFilledHeaders(outputWidthPx, outputHeight);
 
     uint64_t outputRowBytesCount = outputWidthPx * sizeof(Bitmap24Pixel);
@@ -151,7 +156,18 @@ int main(int argc, char** argv) {
 
     std::cout << "------------" << std::endl;
     std::cout << "Started statistics evaluating..." << std::endl << std::endl;
-    Tiff16RGBImageStatistics tiffStatistics = tiffImage.getStatistics(discardedPixelFractionCoeffMin, discardedPixelFractionCoeffMax);
+    uint64_t statisticsSampleSize = 0;
+    if (statisticsErrorBound > 0) {
+        statisticsSampleSize = tiffImage.getStatisticsSampleSize(statisticsErrorBound);
+        std::cout << "Statistics are sampled from " << statisticsSampleSize << " random pixels, the discarded pixel fractions are within "
+                  << statisticsErrorBound << " with 99.9% confidence" << std::endl << std::endl;
+    }
+    Tiff16RGBImageStatistics tiffStatistics;
+    try {
+        tiffStatistics = tiffImage.getStatistics(discardedPixelFractionCoeffMin, discardedPixelFractionCoeffMax, statisticsSampleSize);
+    } catch (const std::runtime_error& e) {
+        return 6;
+    }
     std::cout << "Brief statistics:" << std::endl;
     std::cout << tiffStatistics << std::endl;
 
@@ -187,22 +203,37 @@ int main(int argc, char** argv) {
 
     std::unique_ptr<uint8_t[]> inputRow = std::make_unique<uint8_t[]>(inputRowBytesCount);
     std::unique_ptr<uint8_t[]> outputRow = std::make_unique<uint8_t[]>(outputRowBytesCountWithPadding);
-    auto stripOffsets = tiffImage.stripOffsets;
-    tiffImage.inputStream.seekg(stripOffsets[0], ios_base::beg);
-    if (tiffImage.inputStream.fail()) {
-        cerr << "Error reading source image!" << endl;
-        return 11;
-    };
-    uint32_t rowsPerStrip = tiffImage.rowsPerStrip;
-    for (uint64_t i = 0; i < outputHeight; i++) {
-        uint32_t currentStrip = i * scaleCoeff / rowsPerStrip;
-        uint32_t currentRowInStrip = i * scaleCoeff % rowsPerStrip;
-        tiffImage.inputStream.read((char*)inputRow.get(), inputRowBytesCount);
-        if (tiffImage.inputStream.fail()) {
-            cerr << "Error reading source image!" << endl;
+    if (workMode == WorkMode::AVERAGE) {
+        // Every input row is read once and in order, rows of BMP are stored from the bottom up
+        bool isWriteFailed = false;
+        auto writeAveragedRow = [&](uint64_t row, const Tiff16RGBPixel* pixels) {
+            for (int32_t j = 0; j < outputWidthPx; j++) {
+                Tiff16RGBPixel pixel = pixels[j];
+                pixelConvertCallback(pixel, ((Bitmap24Pixel*)outputRow.get())[j]);
+            }
+            outputStream.seekp(bitmap24Image.bitmapFileHeader.bfOffBits + (outputHeight - 1 - row) * outputRowBytesCountWithPadding);
+            outputStream.write((char*)outputRow.get(), outputRowBytesCountWithPadding);
+            isWriteFailed = isWriteFailed || outputStream.fail();
+        };
+        for (int32_t i = 0; i < inputHeightPx; i++) {
+            try {
+                tiffImage.readRow(i, (Tiff16RGBPixel*)inputRow.get());
+            } catch (const std::runtime_error& e) {
+                return 6;
+            }
+            areaDownscaler->addRow((const Tiff16RGBPixel*)inputRow.get(), writeAveragedRow);
+        }
+        if (isWriteFailed) {
+            cerr << "Error writing to file!" << endl;
+            return 13;
+        }
+    }
+    for (uint64_t i = 0; workMode == WorkMode::DECREASE && i < outputHeight; i++) {
+        try {
+            tiffImage.readRow(i * scaleCoeff, (Tiff16RGBPixel*)inputRow.get());
+        } catch (const std::runtime_error& e) {
             return 6;
         }
-        tiffImage.inputStream.seekg(stripOffsets[currentStrip] + currentRowInStrip * inputRowBytesCount, ios_base::beg);
         decreaseResolution((Tiff16RGBPixel*)inputRow.get(), (Bitmap24Pixel*)outputRow.get(), inputWidthPx,
                            outputWidthPx, scaleCoeff, pixelConvertCallback);
         outputStream.seekp(-1 * outputRowBytesCountWithPadding, std::ios::cur);
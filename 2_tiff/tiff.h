@@ -8,6 +8,14 @@
 #include <array>
 #include <cmath>
 #include <numeric>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <random>
+#include "../common/mappedbitmap.h"
+#include "../common/tiffdirectory.h"
 
 #define COLORS_NUM UINT16_MAX + 1
 
@@ -18,60 +26,6 @@ struct Tiff16RGBPixel
     uint16_t blue;
 };
 
-struct TiffFileHeader
-{
-    uint16_t byteOrder;
-    uint16_t versionNumber;
-    uint32_t offsetIFD;
-};
-
-struct TiffIFDEntry {
-    uint16_t tag;
-    uint16_t fieldType;
-    uint32_t numberValues;
-    uint32_t valueOffset;
-};
-
-
-struct TiffIFD {
-    uint16_t numberEntries;
-    std::unique_ptr<TiffIFDEntry[]> entries;
-    uint32_t padding;
-    TiffIFD(uint16_t numberEntries): padding(0) {
-        this->numberEntries = numberEntries;
-        entries = std::make_unique<TiffIFDEntry[]>(numberEntries);
-    }
-};
-
-enum TiffTagEnum : uint16_t {
-    ImageWidth = 256,
-    ImageLength = 257,
-    BitsPerSample = 258,
-    Compression = 259,
-    PhotometricInterpretation = 262,
-    StripOffsets = 273,
-    SamplesPerPixel = 277,
-    RowsPerStrip = 278,
-    StripByteCounts = 279,
-    PlanarConfiguration = 284
-};
-
-enum class FieldType : uint16_t {
-    Byte = 1,
-    Ascii = 2,
-    Short = 3,
-    Long = 4,
-    Rational = 5,
-    /* In Tiff 6.0 additionally */
-    Sbyte = 6,
-    Undefined = 7,
-    Sshort = 8,
-    Slong = 9,
-    Srational = 10,
-    Float = 11,
-    Double = 12
-};
-
 struct ImageChannelStatistics {
     uint16_t max;
     uint16_t min;
@@ -100,6 +54,51 @@ std::ostream& operator<<(std::ostream& os, const Tiff16RGBImageStatistics& obj)
     return os;
 }
 
+// Pixels lying in the file one after another: linesCount lines of pixelsCount pixels, lineBytesCount apart.
+// A strip is one line, a tile is its lines clipped to the image.
+struct PixelSpan {
+    uint64_t offset;
+    uint64_t pixelsCount;
+    uint64_t linesCount;
+    uint64_t lineBytesCount;
+};
+
+// Histograms of the three channels gathered by one thread. 32-bit counters keep all three in L2,
+// they are flushed to 64-bit totals before they can overflow.
+struct alignas(64) ThreadHistograms {
+    uint32_t counts[3][COLORS_NUM];
+    uint64_t pixelsCount;
+
+    ThreadHistograms() {
+        reset();
+    }
+
+    void reset() {
+        memset(counts, 0, sizeof(counts));
+        pixelsCount = 0;
+    }
+
+    void add(const uint8_t* pixels, uint64_t count) {
+        for (uint64_t i = 0; i < count; i++) {
+            Tiff16RGBPixel pixel;
+            memcpy(&pixel, pixels + i * sizeof(Tiff16RGBPixel), sizeof(Tiff16RGBPixel));
+            counts[0][pixel.red]++;
+            counts[1][pixel.green]++;
+            counts[2][pixel.blue]++;
+        }
+        pixelsCount += count;
+    }
+
+    void flush(std::array<uint64_t, COLORS_NUM>* totals) {
+        for (int64_t channel = 0; channel < 3; channel++) {
+            for (uint64_t value = 0; value < COLORS_NUM; value++) {
+                totals[channel][value] += counts[channel][value];
+            }
+        }
+        reset();
+    }
+};
+
 struct Tiff16RGBImage
 {
     std::unique_ptr<TiffFileHeader> tiffFileHeader;
@@ -112,7 +111,22 @@ struct Tiff16RGBImage
     std::vector<uint64_t> bitsPerSample;
     std::vector<uint64_t> stripOffsets;
     uint16_t compression;
-    uint16_t rowsPerStrip;
+    uint32_t rowsPerStrip = 0;
+
+    TiffDirectory directory;
+    uint32_t tileWidth = 0;
+    uint32_t tileLength = 0;
+    std::vector<uint64_t> tileOffsets;
+    std::vector<uint64_t> tileByteCounts;
+
+    // Tiles of one tile row, rows of tiled images are cut from it
+    std::vector<uint8_t> tileRowCache;
+    int64_t cachedTileRow = -1;
+    // Stream position after the last readAt, seekg drops the stream buffer
+    uint64_t nextReadOffset = UINT64_MAX;
+
+    // Whole input file for getStatistics, nullptr if it can't be mapped
+    std::unique_ptr<MappedFile> mappedFile;
 
     Tiff16RGBImage() {
     };
@@ -135,33 +149,71 @@ struct Tiff16RGBImage
         case FieldType::Rational:
         case FieldType::Srational:
         case FieldType::Double:
+        case FieldType::Long8:
+        case FieldType::Slong8:
+        case FieldType::Ifd8:
             return 8;
         default:
             return 1;
         }
     }
 
-    void setValueByKey(uint16_t key, uint64_t valueOffset, uint64_t numberValues = 1) {
+    // Reads the header and the IFD of a classic TIFF or BigTIFF, throws std::runtime_error
+    void readDirectory() {
+        directory = readTiffDirectory(inputStream);
+        for (const BigTiffIFDEntry& entry : directory.entries) {
+            setValueByKey(entry);
+        }
+        if (rowsPerStrip == 0) {
+            rowsPerStrip = height;
+        }
+    }
+
+    void setValueByKey(const BigTiffIFDEntry& entry) {
+        uint16_t key = entry.tag;
         if (key == TiffTagEnum::ImageWidth) {
-            width = valueOffset;
+            width = entry.valueOffset;
         } else if (key == TiffTagEnum::ImageLength) {
-            height = valueOffset;
+            height = entry.valueOffset;
         } else if (key == TiffTagEnum::BitsPerSample) {
-            bitsPerSample = getValuesVector(key, valueOffset, numberValues, FieldType::Short);
+            bitsPerSample = getValuesVector(entry);
         } else if (key == TiffTagEnum::Compression) {
-            compression = valueOffset;
+            compression = entry.valueOffset;
         } else if (key == TiffTagEnum::StripOffsets) {
-            stripOffsets = getValuesVector(key, valueOffset, numberValues, FieldType::Long);
+            stripOffsets = getValuesVector(entry);
         } else if (key == TiffTagEnum::RowsPerStrip) {
-            rowsPerStrip = valueOffset;
+            rowsPerStrip = entry.valueOffset;
+        } else if (key == TiffTagEnum::TileWidth) {
+            tileWidth = entry.valueOffset;
+        } else if (key == TiffTagEnum::TileLength) {
+            tileLength = entry.valueOffset;
+        } else if (key == TiffTagEnum::TileOffsets) {
+            tileOffsets = getValuesVector(entry);
+        } else if (key == TiffTagEnum::TileByteCounts) {
+            tileByteCounts = getValuesVector(entry);
+        }
+    }
+
+    // Values of the entry in its own field type, stored in the entry itself or at valueOffset
+    std::vector<uint64_t> getValuesVector(const BigTiffIFDEntry& entry) {
+        FieldType fieldType = static_cast<FieldType>(entry.fieldType);
+        uint64_t size = getFieldSize(fieldType);
+        if (entry.numberValues * size > directory.getInlineValuesBytesCount()) {
+            return getValuesVector(entry.tag, entry.valueOffset, entry.numberValues, fieldType);
+        }
+        std::vector<uint64_t> values(entry.numberValues, 0);
+        for (uint64_t j = 0; j < entry.numberValues; j++) {
+            memcpy(&values[j], reinterpret_cast<const uint8_t*>(&entry.valueOffset) + j * size, size);
         }
+        return values;
     }
 
     std::vector<uint64_t> getValuesVector(uint16_t key, uint64_t valueOffset, uint64_t numberValues, FieldType fieldType) {
+        nextReadOffset = UINT64_MAX;
         std::streampos oldPos = inputStream.tellg();
         inputStream.seekg(valueOffset, std::ios::beg);
         std::vector<uint64_t> values;
-        for (uint32_t j = 0; j < numberValues; j++) {
+        for (uint64_t j = 0; j < numberValues; j++) {
             uint64_t sample = 0;
             uint32_t size = getFieldSize(fieldType);
             inputStream.read(reinterpret_cast<char*>(&sample), static_cast<uint32_t>(size));
@@ -176,6 +228,141 @@ struct Tiff16RGBImage
     }
 
 
+    void readAt(uint64_t offset, void* destination, uint64_t bytesCount) {
+        if (offset != nextReadOffset) {
+            inputStream.seekg(offset, std::ios_base::beg);
+        }
+        inputStream.read(reinterpret_cast<char*>(destination), bytesCount);
+        if (inputStream.fail()) {
+            std::cerr << "Error reading source image!" << std::endl;
+            throw std::runtime_error("Error reading source image!");
+        }
+        nextReadOffset = offset + bytesCount;
+    }
+
+    // Row of a stripped or tiled image. Tiles of a tile row are read once while its rows are requested in turn
+    void readRow(uint32_t row, Tiff16RGBPixel* rowBuffer) {
+        uint64_t rowBytesCount = static_cast<uint64_t>(width) * sizeof(Tiff16RGBPixel);
+        if (tileOffsets.empty()) {
+            if (row / rowsPerStrip >= stripOffsets.size()) {
+                std::cerr << "Error reading source image!" << std::endl;
+                throw std::runtime_error("Error reading source image!");
+            }
+            readAt(stripOffsets[row / rowsPerStrip] + (row % rowsPerStrip) * rowBytesCount, rowBuffer, rowBytesCount);
+            return;
+        }
+
+        uint64_t tilesPerRow = (width + tileWidth - 1) / tileWidth;
+        uint64_t tileRowBytesCount = static_cast<uint64_t>(tileWidth) * sizeof(Tiff16RGBPixel);
+        uint64_t tileBytesCount = tileRowBytesCount * tileLength;
+        int64_t tileRow = row / tileLength;
+        if (tileRow != cachedTileRow) {
+            tileRowCache.resize(tilesPerRow * tileBytesCount);
+            for (uint64_t i = 0; i < tilesPerRow; i++) {
+                readAt(tileOffsets[tileRow * tilesPerRow + i], tileRowCache.data() + i * tileBytesCount, tileBytesCount);
+            }
+            cachedTileRow = tileRow;
+        }
+
+        uint64_t rowInTile = row % tileLength;
+        for (uint64_t i = 0; i < tilesPerRow; i++) {
+            uint64_t pixelsCount = std::min<uint64_t>(tileWidth, width - i * tileWidth);
+            memcpy(rowBuffer + i * tileWidth, tileRowCache.data() + i * tileBytesCount + rowInTile * tileRowBytesCount,
+                   pixelsCount * sizeof(Tiff16RGBPixel));
+        }
+    }
+
+    // StripsPerImage of the TIFF specification, an empty image has no strips
+    uint64_t getStripsCount() const {
+        return rowsPerStrip > 0 ? (static_cast<uint64_t>(height) + rowsPerStrip - 1) / rowsPerStrip : 0;
+    }
+
+    // TilesPerImage of the TIFF specification
+    uint64_t getTilesCount() const {
+        uint64_t tilesPerRow = (width + tileWidth - 1) / tileWidth;
+        uint64_t tilesDown = (height + tileLength - 1) / tileLength;
+        return tilesPerRow * tilesDown;
+    }
+
+    void mapFile(const std::string& fileName) {
+        try {
+            mappedFile = std::make_unique<MappedFile>(fileName);
+            mappedFile->adviseSequential();
+        } catch (const std::runtime_error&) {
+            mappedFile.reset();
+        }
+    }
+
+    std::vector<PixelSpan> getPixelSpans() const {
+        uint64_t rowBytesCount = static_cast<uint64_t>(width) * sizeof(Tiff16RGBPixel);
+        std::vector<PixelSpan> spans;
+        if (tileOffsets.empty()) {
+            for (uint64_t strip = 0; strip < stripOffsets.size() && strip * rowsPerStrip < height; strip++) {
+                uint64_t rowsCount = std::min<uint64_t>(rowsPerStrip, height - strip * rowsPerStrip);
+                spans.push_back({stripOffsets[strip], width * rowsCount, 1, rowBytesCount * rowsCount});
+            }
+            return spans;
+        }
+        uint64_t tilesPerRow = (width + tileWidth - 1) / tileWidth;
+        for (uint64_t tile = 0; tile < getTilesCount(); tile++) {
+            uint64_t firstCol = tile % tilesPerRow * tileWidth;
+            uint64_t firstRow = tile / tilesPerRow * tileLength;
+            spans.push_back({tileOffsets[tile], std::min<uint64_t>(tileWidth, width - firstCol), std::min<uint64_t>(tileLength, height - firstRow),
+                             static_cast<uint64_t>(tileWidth) * sizeof(Tiff16RGBPixel)});
+        }
+        return spans;
+    }
+
+    // Spans of the mapped file are split into jobs of at most JOB_PIXELS_COUNT pixels taken by threads in turn,
+    // every thread counts into its own ThreadHistograms
+    void calculateHistogramsParallel(std::array<uint64_t, COLORS_NUM>* totals) {
+        constexpr uint64_t JOB_PIXELS_COUNT = 1 << 22;
+        std::vector<PixelSpan> jobs;
+        for (const PixelSpan& span : getPixelSpans()) {
+            if (span.offset + (span.linesCount - 1) * span.lineBytesCount + span.pixelsCount * sizeof(Tiff16RGBPixel) > mappedFile->getSize()) {
+                std::cerr << "Error reading source image!" << std::endl;
+                throw std::runtime_error("Error reading source image!");
+            }
+            if (span.linesCount > 1) {
+                jobs.push_back(span);
+                continue;
+            }
+            for (uint64_t first = 0; first < span.pixelsCount; first += JOB_PIXELS_COUNT) {
+                jobs.push_back({span.offset + first * sizeof(Tiff16RGBPixel), std::min(JOB_PIXELS_COUNT, span.pixelsCount - first), 1, 0});
+            }
+        }
+
+        int64_t threadsCount = std::max<int64_t>(1, std::min<int64_t>(std::thread::hardware_concurrency(), jobs.size()));
+        std::atomic<uint64_t> nextJob(0);
+        std::mutex totalsMutex;
+        auto countJobs = [&]() {
+            auto histograms = std::make_unique<ThreadHistograms>();
+            auto flush = [&]() {
+                std::lock_guard<std::mutex> lock(totalsMutex);
+                histograms->flush(totals);
+            };
+            for (uint64_t index = nextJob++; index < jobs.size(); index = nextJob++) {
+                const PixelSpan& job = jobs[index];
+                if (histograms->pixelsCount + job.pixelsCount * job.linesCount > UINT32_MAX) {
+                    flush();
+                }
+                for (uint64_t line = 0; line < job.linesCount; line++) {
+                    histograms->add(mappedFile->getData() + job.offset + line * job.lineBytesCount, job.pixelsCount);
+                }
+            }
+            flush();
+        };
+
+        std::vector<std::thread> threads;
+        for (int64_t i = 1; i < threadsCount; i++) {
+            threads.emplace_back(countJobs);
+        }
+        countJobs();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
     std::pair<uint16_t, uint16_t> getBorders(const std::array<uint64_t, COLORS_NUM>& histogram) {
         bool isMinFound = false;
         uint16_t minIndex = 0;
@@ -194,7 +381,7 @@ struct Tiff16RGBImage
 
     uint64_t calculateMean(const std::array<uint64_t, COLORS_NUM>& histogram) const {
         double sum = 0;
-        uint64_t totalPixels = width * height;
+        uint64_t totalPixels = std::accumulate(histogram.begin(), histogram.end(), uint64_t(0));
 
         for (size_t i = 0; i < histogram.size(); i++) {
             uint16_t brightness = i;
@@ -211,7 +398,7 @@ struct Tiff16RGBImage
     std::pair<uint16_t, uint16_t> calculateRealBorders(const std::array<uint64_t, COLORS_NUM>& histogram, uint16_t leftBorder, uint16_t rightBorder,
                                                        double discardedPixelFractionLeft, double discardedPixelFractionRight)
     {
-        uint64_t totalPixels = width * height;
+        uint64_t totalPixels = std::accumulate(histogram.begin(), histogram.end(), uint64_t(0));
         uint64_t pixelsToDiscardLeft = totalPixels * discardedPixelFractionLeft;
         uint64_t leftSum = 0;
         uint16_t newLeftBorder = leftBorder;
@@ -237,33 +424,92 @@ struct Tiff16RGBImage
         return {newLeftBorder, newRightBorder};
     }
 
-    Tiff16RGBImageStatistics getStatistics(double discardedPixelFractionCoeffLeft, double discardedPixelFractionCoeffRight) {
+    // Count of pixels sampled by getStatistics for the discarded pixel fractions of all three channels to be within
+    // errorBound with 99.9% confidence. Pixels are drawn independently and uniformly, so the Dvoretzky-Kiefer-Wolfowitz
+    // inequality P(sup |F_n - F| > e) <= 2 exp(-2 n e^2) holds for the histogram of every channel
+    uint64_t getStatisticsSampleSize(double errorBound) const {
+        constexpr double SAMPLE_SIZE_CONFIDENCE = 0.999;
+        return static_cast<uint64_t>(std::ceil(std::log(2 * 3 / (1 - SAMPLE_SIZE_CONFIDENCE)) / (2 * errorBound * errorBound)));
+    }
+
+    // Offset of the pixel in the file
+    uint64_t getPixelOffset(uint64_t row, uint64_t col) const {
+        if (tileOffsets.empty()) {
+            uint64_t rowBytesCount = static_cast<uint64_t>(width) * sizeof(Tiff16RGBPixel);
+            return stripOffsets[row / rowsPerStrip] + (row % rowsPerStrip) * rowBytesCount + col * sizeof(Tiff16RGBPixel);
+        }
+        uint64_t tilesPerRow = (width + tileWidth - 1) / tileWidth;
+        uint64_t tile = row / tileLength * tilesPerRow + col / tileWidth;
+        return tileOffsets[tile] + ((row % tileLength) * tileWidth + col % tileWidth) * sizeof(Tiff16RGBPixel);
+    }
+
+    // Pixels at positions drawn with replacement from the whole image, sorted to read the file forward
+    void calculateHistogramsSampled(std::array<uint64_t, COLORS_NUM>* totals, uint64_t samplePixelsCount) {
+        constexpr uint64_t SAMPLE_SEED = 20240611;
+        uint64_t pixelsCount = static_cast<uint64_t>(width) * height;
+        std::mt19937_64 generator(SAMPLE_SEED);
+        std::uniform_int_distribution<uint64_t> position(0, pixelsCount - 1);
+        std::vector<uint64_t> positions(samplePixelsCount);
+        for (uint64_t& index : positions) {
+            index = position(generator);
+        }
+        std::sort(positions.begin(), positions.end());
+
+        for (uint64_t index : positions) {
+            uint64_t offset = getPixelOffset(index / width, index % width);
+            Tiff16RGBPixel pixel;
+            if (mappedFile) {
+                if (offset + sizeof(Tiff16RGBPixel) > mappedFile->getSize()) {
+                    std::cerr << "Error reading source image!" << std::endl;
+                    throw std::runtime_error("Error reading source image!");
+                }
+                memcpy(&pixel, mappedFile->getData() + offset, sizeof(Tiff16RGBPixel));
+            } else {
+                readAt(offset, &pixel, sizeof(Tiff16RGBPixel));
+            }
+            totals[0][pixel.red]++;
+            totals[1][pixel.green]++;
+            totals[2][pixel.blue]++;
+        }
+    }
+
+    // Histograms of samplePixelsCount random pixels (see getStatisticsSampleSize) or of the whole image if it is 0.
+    // A random pixel costs about as much as SAMPLED_PIXEL_COST pixels of the sequential count, larger samples are not
+    // taken as the whole image is counted faster. Min, max and mean of a sample are those of the sampled pixels.
+    Tiff16RGBImageStatistics getStatistics(double discardedPixelFractionCoeffLeft, double discardedPixelFractionCoeffRight,
+                                           uint64_t samplePixelsCount = 0) {
         Tiff16RGBImageStatistics tiff16RGBImageStatistics;
         std::array<uint64_t, COLORS_NUM> redChannelPixelMap = {0};
         std::array<uint64_t, COLORS_NUM> greenChannelPixelMap = {0};
         std::array<uint64_t, COLORS_NUM> blueChannelPixelMap = {0};
 
-        std::streampos oldPos = inputStream.tellg();
         uint32_t widthPx = width;
-        uint64_t rowBytesCount = widthPx * sizeof(Tiff16RGBPixel);
         uint32_t heightPx = height;
-        std::unique_ptr<Tiff16RGBPixel[]> inputRow = std::make_unique<Tiff16RGBPixel[]>(widthPx);
-        inputStream.seekg(stripOffsets[0], std::ios_base::beg);
-        for (uint64_t i = 0; i < heightPx; i++) {
-            inputStream.read((char*)inputRow.get(), rowBytesCount);
-            if (inputStream.fail()) {
-                std::cerr << "Error reading source image!" << std::endl;
-                throw std::runtime_error("Error reading source image!");
+        constexpr uint64_t SAMPLED_PIXEL_COST = 16;
+        bool isSampled = samplePixelsCount > 0 && samplePixelsCount * SAMPLED_PIXEL_COST < static_cast<uint64_t>(widthPx) * heightPx;
+        if (isSampled || mappedFile) {
+            std::array<uint64_t, COLORS_NUM> totals[3] = {};
+            if (isSampled) {
+                calculateHistogramsSampled(totals, samplePixelsCount);
+            } else {
+                calculateHistogramsParallel(totals);
             }
-            for (uint64_t j = 0; j < widthPx; j++) {
-                Tiff16RGBPixel tiff16RGBPixel = inputRow.get()[j];
-                redChannelPixelMap[tiff16RGBPixel.red]++;
-                greenChannelPixelMap[tiff16RGBPixel.green]++;
-                blueChannelPixelMap[tiff16RGBPixel.blue]++;
+            redChannelPixelMap = totals[0];
+            greenChannelPixelMap = totals[1];
+            blueChannelPixelMap = totals[2];
+        } else {
+            std::unique_ptr<Tiff16RGBPixel[]> inputRow = std::make_unique<Tiff16RGBPixel[]>(widthPx);
+            for (uint64_t i = 0; i < heightPx; i++) {
+                readRow(i, inputRow.get());
+                for (uint64_t j = 0; j < widthPx; j++) {
+                    Tiff16RGBPixel tiff16RGBPixel = inputRow.get()[j];
+                    redChannelPixelMap[tiff16RGBPixel.red]++;
+                    greenChannelPixelMap[tiff16RGBPixel.green]++;
+                    blueChannelPixelMap[tiff16RGBPixel.blue]++;
+                }
             }
         }
         //std::cout << "redChannelPixelMap sum = " << std::reduce(redChannelPixelMap.begin(), redChannelPixelMap.end()) << std::endl;
-        inputStream.seekg(oldPos, std::ios::beg);
         auto minMaxIndex = getBorders(redChannelPixelMap);
 
         tiff16RGBImageStatistics.red.min = minMaxIndex.first;
@@ -309,13 +555,27 @@ struct Tiff16RGBImage
         if (bitsPerSample[0] != 16) {
             throw std::runtime_error("bits per sample != 16");
         }
+        if (tileOffsets.empty() ? stripOffsets.empty() : tileWidth == 0 || tileLength == 0) {
+            throw std::runtime_error("no strip or tile offsets");
+        }
+        if (!tileOffsets.empty() && (tileOffsets.size() != getTilesCount() || tileByteCounts.size() != getTilesCount())) {
+            throw std::runtime_error("tile offsets or byte counts do not match the tile grid");
+        }
+        if (tileOffsets.empty() && stripOffsets.size() < getStripsCount()) {
+            throw std::runtime_error("strip offsets do not cover the image");
+        }
 
         std::cout << "Necessary image parameters:" << std::endl;
         std::cout << "Width: " << width << std::endl;
         std::cout << "Height: " << height << std::endl;
         std::cout << "Bits per sample: " << bitsPerSample.size() << " * " << bitsPerSample[0]<< std::endl;
         std::cout << "Compression: " << compression << std::endl;
-        std::cout << "Rows per strip: " << rowsPerStrip << std::endl;
+        std::cout << "BigTIFF: " << (directory.isBigTiff ? "yes" : "no") << std::endl;
+        if (tileOffsets.empty()) {
+            std::cout << "Rows per strip: " << rowsPerStrip << std::endl;
+        } else {
+            std::cout << "Tile size: " << tileWidth << " x " << tileLength << std::endl;
+        }
     }
 };
 
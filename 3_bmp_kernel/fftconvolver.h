@@ -0,0 +1,230 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <complex>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include "bitmap.h"
+#include "kernel.h"
+#include "imagerowsringbuffer.h"
+
+// Overlap-save convolution: image is processed by tiles of fftHeight x fftWidth input pixels,
+// every tile gives (fftHeight - kernelHeight + 1) x (fftWidth - kernelWidth + 1) output pixels.
+// Blue and green channels are packed into one complex tile, red into another.
+class FftConvolver
+{
+private:
+    typedef std::complex<double> Complex;
+
+    static constexpr uint64_t MIN_FFT_SIZE = 64;
+    static constexpr uint64_t CHANNELS_COUNT = 3;
+    static constexpr double ROUND_OFF_EPSILON = 1e-7;
+
+    int64_t kernelWidth;
+    int64_t kernelHeight;
+    uint64_t fftWidth;
+    uint64_t fftHeight;
+    std::vector<Complex> kernelSpectrum;
+    std::vector<Complex> rowTwiddles;
+    std::vector<Complex> colTwiddles;
+    std::vector<uint64_t> rowBitReverse;
+    std::vector<uint64_t> colBitReverse;
+    std::vector<Complex> blueGreenTile;
+    std::vector<Complex> redTile;
+    std::vector<Complex> column;
+
+    static Complex multiply(Complex a, Complex b) {
+        return Complex(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+    }
+
+    static void prepareTransform(uint64_t size, std::vector<Complex>& twiddles, std::vector<uint64_t>& bitReverse) {
+        twiddles.resize(size / 2);
+        for (uint64_t k = 0; k < size / 2; k++) {
+            twiddles[k] = std::polar(1.0, -2 * M_PI * k / size);
+        }
+
+        uint64_t bits = 0;
+        while ((1ull << bits) < size) {
+            bits++;
+        }
+        bitReverse.resize(size);
+        for (uint64_t i = 0; i < size; i++) {
+            uint64_t reversed = 0;
+            for (uint64_t bit = 0; bit < bits; bit++) {
+                reversed |= ((i >> bit) & 1) << (bits - bit - 1);
+            }
+            bitReverse[i] = reversed;
+        }
+    }
+
+    static void transform(Complex* data, uint64_t size, const std::vector<Complex>& twiddles,
+                          const std::vector<uint64_t>& bitReverse, bool inverse) {
+        for (uint64_t i = 0; i < size; i++) {
+            if (i < bitReverse[i]) {
+                std::swap(data[i], data[bitReverse[i]]);
+            }
+        }
+
+        for (uint64_t length = 2; length <= size; length <<= 1) {
+            uint64_t halfLength = length / 2;
+            uint64_t step = size / length;
+            for (uint64_t i = 0; i < size; i += length) {
+                for (uint64_t k = 0; k < halfLength; k++) {
+                    Complex twiddle = twiddles[k * step];
+                    if (inverse) {
+                        twiddle = std::conj(twiddle);
+                    }
+                    Complex u = data[i + k];
+                    Complex v = multiply(data[i + k + halfLength], twiddle);
+                    data[i + k] = u + v;
+                    data[i + k + halfLength] = u - v;
+                }
+            }
+        }
+    }
+
+    void transform2D(std::vector<Complex>& tile, uint64_t usedRowsCount, bool inverse) {
+        for (uint64_t r = 0; r < usedRowsCount; r++) {
+            transform(tile.data() + r * fftWidth, fftWidth, rowTwiddles, rowBitReverse, inverse);
+        }
+        for (uint64_t q = 0; q < fftWidth; q++) {
+            for (uint64_t r = 0; r < fftHeight; r++) {
+                column[r] = tile[r * fftWidth + q];
+            }
+            transform(column.data(), fftHeight, colTwiddles, colBitReverse, inverse);
+            for (uint64_t r = 0; r < fftHeight; r++) {
+                tile[r * fftWidth + q] = column[r];
+            }
+        }
+    }
+
+    // FFT round-off is much bigger than one of direct summation, so values are nudged
+    // away from zero before truncation to keep integer results of integer kernels exact
+    static uint8_t getNormalizedChannelValue(double value) {
+        int64_t result = value + (value < 0 ? -ROUND_OFF_EPSILON : ROUND_OFF_EPSILON);
+        if (result < 0) {
+            result = -result;
+        }
+        if (result > static_cast<int64_t>(Bitmap24Pixel::getMaxChannelValue())) {
+            result = Bitmap24Pixel::getMaxChannelValue();
+        }
+        return result;
+    }
+
+public:
+    static uint64_t getFftSize(int64_t kernelSize) {
+        uint64_t size = MIN_FFT_SIZE;
+        while (size < 2 * static_cast<uint64_t>(kernelSize)) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    // Multiply-adds per output channel value: 2 forward and 2 inverse 2D transforms
+    // (about 2 * N * log2(N) each) plus spectrum multiplication, divided by useful outputs of a tile.
+    static double estimateCostPerPixel(int64_t kernelWidth, int64_t kernelHeight) {
+        double fftWidth = getFftSize(kernelWidth);
+        double fftHeight = getFftSize(kernelHeight);
+        double tileSize = fftWidth * fftHeight;
+        double tileCost = 4 * 2 * tileSize * std::log2(tileSize) + 2 * 4 * tileSize;
+        double outputsCount = (fftWidth - kernelWidth + 1) * (fftHeight - kernelHeight + 1) * CHANNELS_COUNT;
+        return tileCost / outputsCount;
+    }
+
+    FftConvolver(const Kernel& kernel) {
+        kernelWidth = kernel.getWidth();
+        kernelHeight = kernel.getHeight();
+        fftWidth = getFftSize(kernelWidth);
+        fftHeight = getFftSize(kernelHeight);
+
+        prepareTransform(fftWidth, rowTwiddles, rowBitReverse);
+        prepareTransform(fftHeight, colTwiddles, colBitReverse);
+
+        blueGreenTile.resize(fftWidth * fftHeight);
+        redTile.resize(fftWidth * fftHeight);
+        column.resize(fftHeight);
+
+        kernelSpectrum.assign(fftWidth * fftHeight, Complex(0, 0));
+        double scale = 1.0 / (fftWidth * fftHeight);
+        for (int64_t i = 0; i < kernelHeight; i++) {
+            for (int64_t j = 0; j < kernelWidth; j++) {
+                kernelSpectrum[i * fftWidth + j] = kernel[kernelHeight - 1 - i][kernelWidth - 1 - j] * scale;
+            }
+        }
+        transform2D(kernelSpectrum, kernelHeight, false);
+    }
+
+    uint64_t getBlockHeight() const {
+        return fftHeight - kernelHeight + 1;
+    }
+
+    uint64_t getBlockWidth() const {
+        return fftWidth - kernelWidth + 1;
+    }
+
+    // rows: outputRows.size() + kernelHeight - 1 input rows, first output row is centered at rows[(kernelHeight - 1) / 2]
+    void convolveRows(const std::vector<const Bitmap24Pixel*>& rows, int64_t width,
+                      const std::vector<Bitmap24Pixel*>& outputRows, uint8_t channelMask) {
+        uint64_t outputRowsCount = outputRows.size();
+        if (outputRowsCount > getBlockHeight() || rows.size() != outputRowsCount + kernelHeight - 1) {
+            throw std::invalid_argument("Rows count doesn't match FFT tile!");
+        }
+
+        int64_t rowCenterOffset = (kernelHeight - 1) / 2;
+        for (uint64_t r = 0; r < outputRowsCount; r++) {
+            std::copy(rows[r + rowCenterOffset], rows[r + rowCenterOffset] + width, outputRows[r]);
+        }
+        if (!(channelMask & (Red | Green | Blue))) {
+            return;
+        }
+
+        uint64_t blockWidth = getBlockWidth();
+        for (int64_t colBegin = 0; colBegin < width; colBegin += blockWidth) {
+            uint64_t outputColsCount = std::min<int64_t>(blockWidth, width - colBegin);
+            uint64_t inputColsCount = outputColsCount + kernelWidth - 1;
+
+            std::fill(blueGreenTile.begin(), blueGreenTile.end(), Complex(0, 0));
+            std::fill(redTile.begin(), redTile.end(), Complex(0, 0));
+            for (uint64_t r = 0; r < rows.size(); r++) {
+                const Bitmap24Pixel* row = rows[r];
+                for (uint64_t q = 0; q < inputColsCount; q++) {
+                    int64_t col = colBegin + q;
+                    if (col >= width) {
+                        col %= 2 * width;
+                        col = 2 * width - col - 1;
+                    }
+                    blueGreenTile[r * fftWidth + q] = Complex(row[col].blue, row[col].green);
+                    redTile[r * fftWidth + q] = Complex(row[col].red, 0);
+                }
+            }
+
+            transform2D(blueGreenTile, rows.size(), false);
+            transform2D(redTile, rows.size(), false);
+            for (uint64_t i = 0; i < kernelSpectrum.size(); i++) {
+                blueGreenTile[i] = multiply(blueGreenTile[i], kernelSpectrum[i]);
+                redTile[i] = multiply(redTile[i], kernelSpectrum[i]);
+            }
+            transform2D(blueGreenTile, fftHeight, true);
+            transform2D(redTile, fftHeight, true);
+
+            for (uint64_t r = 0; r < outputRowsCount; r++) {
+                const Complex* blueGreenRow = blueGreenTile.data() + (r + kernelHeight - 1) * fftWidth + kernelWidth - 1;
+                const Complex* redRow = redTile.data() + (r + kernelHeight - 1) * fftWidth + kernelWidth - 1;
+                Bitmap24Pixel* outputRow = outputRows[r] + colBegin;
+                for (uint64_t q = 0; q < outputColsCount; q++) {
+                    if (channelMask & Blue) {
+                        outputRow[q].blue = getNormalizedChannelValue(blueGreenRow[q].real());
+                    }
+                    if (channelMask & Green) {
+                        outputRow[q].green = getNormalizedChannelValue(blueGreenRow[q].imag());
+                    }
+                    if (channelMask & Red) {
+                        outputRow[q].red = getNormalizedChannelValue(redRow[q].real());
+                    }
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <stdexcept>
+#include "bitmap.h"
+#include "kernel.h"
+#include "imagerowsringbuffer.h"
+#include "vectorizedkernelapplier.h"
+
+// Kernel weights quantized to int16 with one shared shift: weight ~ quantizedWeight / 2^shift.
+// Shift is the biggest one that keeps every weight in int16 and any row sum of 8-bit pixels in int32.
+class FixedPointKernel
+{
+private:
+    int64_t width;
+    int64_t height;
+    int shift;
+    std::vector<int16_t> weights;
+    double maxOutputError;
+
+    static constexpr int MAX_SHIFT = 24;
+
+public:
+    FixedPointKernel(const Kernel& kernel) {
+        width = kernel.getWidth();
+        height = kernel.getHeight();
+
+        double maxWeight = 0;
+        double weightsSum = 0;
+        for (int64_t i = 0; i < height; i++) {
+            for (int64_t j = 0; j < width; j++) {
+                maxWeight = std::max(maxWeight, std::abs(kernel[i][j]));
+                weightsSum += std::abs(kernel[i][j]);
+            }
+        }
+
+        shift = MAX_SHIFT;
+        while (shift >= 0 && (std::ldexp(maxWeight, shift) > INT16_MAX
+                              || (std::ldexp(weightsSum, shift) + width * height / 2.0) * Bitmap24Pixel::getMaxChannelValue() > INT32_MAX)) {
+            shift--;
+        }
+        if (shift < 0) {
+            throw std::invalid_argument("Kernel weights are too big for fixed point convolution!");
+        }
+
+        weights.resize(width * height);
+        double weightsErrorSum = 0;
+        for (int64_t i = 0; i < height; i++) {
+            for (int64_t j = 0; j < width; j++) {
+                double quantizedWeight = std::round(std::ldexp(kernel[i][j], shift));
+                weights[i * width + j] = quantizedWeight;
+                weightsErrorSum += std::abs(std::ldexp(quantizedWeight, -shift) - kernel[i][j]);
+            }
+        }
+        maxOutputError = weightsErrorSum * Bitmap24Pixel::getMaxChannelValue();
+    }
+
+    int64_t getWidth() const {
+        return width;
+    }
+
+    int64_t getHeight() const {
+        return height;
+    }
+
+    int getShift() const {
+        return shift;
+    }
+
+    int16_t getWeight(int64_t row, int64_t col) const {
+        return weights[row * width + col];
+    }
+
+    // Bound of |fixed point sum - double sum| before truncation to channel value,
+    // so channel values differ from the double path by at most floor(bound) + 1
+    double getMaxOutputError() const {
+        return maxOutputError;
+    }
+};
+
+// Same ring of mirrored planar rows as VectorizedKernelApplier, but with int16 pixels.
+// Taps are processed by pairs, so AVX2/AVX-512 madd gives two multiply-adds per int32 lane.
+class FixedPointKernelApplier
+{
+private:
+    static constexpr uint64_t CHANNELS_COUNT = 3;
+    static constexpr uint64_t BLOCK_LENGTH = 32;
+
+    InstructionSet instructionSet;
+    FixedPointKernel kernel;
+    int64_t width;
+    int64_t pairsCount;
+    uint64_t planeLength;
+    uint64_t beginIndex;
+    std::unique_ptr<int32_t[]> weightPairs;
+    std::unique_ptr<int16_t[]> planes;
+    std::unique_ptr<int32_t[]> channelValues;
+    std::unique_ptr<Bitmap24Pixel[]> resultRow;
+
+    const int16_t* getPlane(uint64_t row, uint64_t channel) const {
+        uint64_t realRow = (beginIndex + row) % kernel.getHeight();
+        return planes.get() + (realRow * CHANNELS_COUNT + channel) * planeLength;
+    }
+
+    void convolveChannelScalar(uint64_t channel) {
+        for (int64_t k = 0; k < width; k++) {
+            channelValues[k] = 0;
+        }
+        for (int64_t i = 0; i < kernel.getHeight(); i++) {
+            const int16_t* plane = getPlane(i, channel);
+            for (int64_t j = 0; j < kernel.getWidth(); j++) {
+                int32_t weight = kernel.getWeight(i, j);
+                for (int64_t k = 0; k < width; k++) {
+                    channelValues[k] += weight * plane[k + j];
+                }
+            }
+        }
+        for (int64_t k = 0; k < width; k++) {
+            channelValues[k] = std::min<int32_t>(std::abs(channelValues[k]) >> kernel.getShift(), Bitmap24Pixel::getMaxChannelValue());
+        }
+    }
+
+#ifdef VECTORIZED_KERNEL_X86
+    __attribute__((target("avx2")))
+    void convolveChannelAvx2(uint64_t channel) {
+        const __m256i maxValue = _mm256_set1_epi32(Bitmap24Pixel::getMaxChannelValue());
+        const __m128i shift = _mm_cvtsi32_si128(kernel.getShift());
+
+        for (int64_t k = 0; k < width; k += 16) {
+            __m256i sumLow = _mm256_setzero_si256();
+            __m256i sumHigh = _mm256_setzero_si256();
+
+            for (int64_t i = 0; i < kernel.getHeight(); i++) {
+                const int16_t* plane = getPlane(i, channel) + k;
+                const int32_t* weightsRow = weightPairs.get() + i * pairsCount;
+                for (int64_t p = 0; p < pairsCount; p++) {
+                    __m256i weights = _mm256_set1_epi32(weightsRow[p]);
+                    __m256i current = _mm256_loadu_si256((const __m256i*)(plane + 2 * p));
+                    __m256i next = _mm256_loadu_si256((const __m256i*)(plane + 2 * p + 1));
+                    sumLow = _mm256_add_epi32(sumLow, _mm256_madd_epi16(_mm256_unpacklo_epi16(current, next), weights));
+                    sumHigh = _mm256_add_epi32(sumHigh, _mm256_madd_epi16(_mm256_unpackhi_epi16(current, next), weights));
+                }
+            }
+
+            sumLow = _mm256_min_epi32(_mm256_srl_epi32(_mm256_abs_epi32(sumLow), shift), maxValue);
+            sumHigh = _mm256_min_epi32(_mm256_srl_epi32(_mm256_abs_epi32(sumHigh), shift), maxValue);
+            _mm256_storeu_si256((__m256i*)(channelValues.get() + k), _mm256_permute2x128_si256(sumLow, sumHigh, 0x20));
+            _mm256_storeu_si256((__m256i*)(channelValues.get() + k + 8), _mm256_permute2x128_si256(sumLow, sumHigh, 0x31));
+        }
+    }
+
+    __attribute__((target("avx512f,avx512bw")))
+    void convolveChannelAvx512(uint64_t channel) {
+        constexpr __mmask16 ALL_LANES = 0xFFFF;
+        const __m512i maxValue = _mm512_set1_epi32(Bitmap24Pixel::getMaxChannelValue());
+        const __m128i shift = _mm_cvtsi32_si128(kernel.getShift());
+        const __m512i firstHalfIndex = _mm512_setr_epi64(0, 1, 8, 9, 2, 3, 10, 11);
+        const __m512i secondHalfIndex = _mm512_setr_epi64(4, 5, 12, 13, 6, 7, 14, 15);
+
+        for (int64_t k = 0; k < width; k += 32) {
+            __m512i sumLow = _mm512_setzero_si512();
+            __m512i sumHigh = _mm512_setzero_si512();
+
+            for (int64_t i = 0; i < kernel.getHeight(); i++) {
+                const int16_t* plane = getPlane(i, channel) + k;
+                const int32_t* weightsRow = weightPairs.get() + i * pairsCount;
+                for (int64_t p = 0; p < pairsCount; p++) {
+                    __m512i weights = _mm512_set1_epi32(weightsRow[p]);
+                    __m512i current = _mm512_loadu_si512(plane + 2 * p);
+                    __m512i next = _mm512_loadu_si512(plane + 2 * p + 1);
+                    sumLow = _mm512_add_epi32(sumLow, _mm512_madd_epi16(_mm512_unpacklo_epi16(current, next), weights));
+                    sumHigh = _mm512_add_epi32(sumHigh, _mm512_madd_epi16(_mm512_unpackhi_epi16(current, next), weights));
+                }
+            }
+
+            // Zero-masked forms avoid the undefined pass-through operands of the unmasked ones
+            sumLow = _mm512_maskz_min_epi32(ALL_LANES, _mm512_maskz_srl_epi32(ALL_LANES, _mm512_maskz_abs_epi32(ALL_LANES, sumLow), shift), maxValue);
+            sumHigh = _mm512_maskz_min_epi32(ALL_LANES, _mm512_maskz_srl_epi32(ALL_LANES, _mm512_maskz_abs_epi32(ALL_LANES, sumHigh), shift), maxValue);
+            _mm512_storeu_si512(channelValues.get() + k, _mm512_permutex2var_epi64(sumLow, firstHalfIndex, sumHigh));
+            _mm512_storeu_si512(channelValues.get() + k + 16, _mm512_permutex2var_epi64(sumLow, secondHalfIndex, sumHigh));
+        }
+    }
+#endif
+
+    void convolveChannel(uint64_t channel) {
+#ifdef VECTORIZED_KERNEL_X86
+        if (instructionSet == InstructionSet::Avx512) {
+            convolveChannelAvx512(channel);
+            return;
+        }
+        if (instructionSet == InstructionSet::Avx2) {
+            convolveChannelAvx2(channel);
+            return;
+        }
+#endif
+        convolveChannelScalar(channel);
+    }
+
+public:
+    FixedPointKernelApplier(const Kernel& kernel, uint64_t width, InstructionSet instructionSet)
+        : instructionSet(instructionSet), kernel(kernel), width(width) {
+        beginIndex = 0;
+        pairsCount = divideWithCeil<int64_t>(kernel.getWidth(), 2);
+
+        uint64_t blocksCount = divideWithCeil<uint64_t>(width, BLOCK_LENGTH);
+        planeLength = (blocksCount + 1) * BLOCK_LENGTH + 2 * pairsCount;
+
+        weightPairs = std::make_unique<int32_t[]>(kernel.getHeight() * pairsCount);
+        for (int64_t i = 0; i < kernel.getHeight(); i++) {
+            for (int64_t p = 0; p < pairsCount; p++) {
+                uint16_t first = this->kernel.getWeight(i, 2 * p);
+                uint16_t second = 2 * p + 1 < kernel.getWidth() ? this->kernel.getWeight(i, 2 * p + 1) : 0;
+                weightPairs[i * pairsCount + p] = static_cast<int32_t>(first | (static_cast<uint32_t>(second) << 16));
+            }
+        }
+
+        planes = std::make_unique<int16_t[]>(kernel.getHeight() * CHANNELS_COUNT * planeLength);
+        channelValues = std::make_unique<int32_t[]>(blocksCount * BLOCK_LENGTH);
+        resultRow = std::make_unique<Bitmap24Pixel[]>(width + 4);
+    }
+
+    const FixedPointKernel& getKernel() const {
+        return kernel;
+    }
+
+    void pushRow(const Bitmap24Pixel* row) {
+        int16_t* blue = planes.get() + beginIndex * CHANNELS_COUNT * planeLength;
+        int16_t* green = blue + planeLength;
+        int16_t* red = green + planeLength;
+
+        for (int64_t m = 0; m < width + kernel.getWidth() - 1; m++) {
+            int64_t col = m;
+            if (col >= width) {
+                col %= 2 * width;
+                col = 2 * width - col - 1;
+            }
+            blue[m] = row[col].blue;
+            green[m] = row[col].green;
+            red[m] = row[col].red;
+        }
+
+        beginIndex = (beginIndex + 1) % kernel.getHeight();
+    }
+
+    Bitmap24Pixel* apply(const Bitmap24Pixel* centerRow, uint8_t channelMask) {
+        for (int64_t k = 0; k < width; k++) {
+            resultRow[k] = centerRow[k];
+        }
+
+        if (channelMask & Blue) {
+            convolveChannel(0);
+            for (int64_t k = 0; k < width; k++) {
+                resultRow[k].blue = channelValues[k];
+            }
+        }
+        if (channelMask & Green) {
+            convolveChannel(1);
+            for (int64_t k = 0; k < width; k++) {
+                resultRow[k].green = channelValues[k];
+            }
+        }
+        if (channelMask & Red) {
+            convolveChannel(2);
+            for (int64_t k = 0; k < width; k++) {
+                resultRow[k].red = channelValues[k];
+            }
+        }
+
+        return resultRow.get();
+    }
+};
@@ -3,7 +3,11 @@
 #include <cstdint>
 #include <memory>
 #include <cmath>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
 #include "kernel.h"
+#include "separablekernel.h"
 
 enum ImageChannel : uint8_t {
     Red    = 0b001,
@@ -21,12 +25,20 @@ private:
     uint64_t length;
     uint64_t beginIndex;
     std::unique_ptr<T[]> resultRow;
-
+    std::unique_ptr<double[]> columnSums;
+    std::unique_ptr<double[]> channelSums;
+    uint64_t columnSumsLength;
 
     const uint64_t mirrorColIndex(int64_t value) const {
         return mirrorDimention(value, width);
     }
 
+    // Separable sums differ from the exact sums by rounding errors of the terms, the exact sums of integer kernels
+    // are integers and are restored by rounding, as the dense sums of these kernels are exact
+    static double getSeparableSum(double value, bool isIntegerValued) {
+        return isIntegerValued ? std::round(value) : value;
+    }
+
     uint8_t getNormalizedChannelValue(int64_t value, int64_t maxChannelValue) const {
         if (value < 0) {
             value = std::abs(value);
@@ -44,19 +56,20 @@ public:
         widthBytes = cols * sizeof(T);
         length = rows;
         beginIndex = 0;
-        data = std::make_unique<T[]>(rows * widthBytes);
+        data = std::make_unique<T[]>(rows * width);
         resultRow = std::make_unique<T[]>(widthBytes + padding);
+        columnSumsLength = 0;
     }
 
     const T* pushNewRowAndGetPtr() {
         uint32_t oldBeginIndex = beginIndex;
         beginIndex = (beginIndex + 1) % length;
-        return data.get() + oldBeginIndex * widthBytes;
+        return data.get() + oldBeginIndex * width;
     }
 
     const T* getRow(uint64_t row) const {
         uint64_t realRow = (beginIndex + row) % length;
-        return data.get() + realRow * widthBytes;
+        return data.get() + realRow * width;
     }
 
     const T getElem(uint64_t row, int64_t col) const {
@@ -112,4 +125,74 @@ public:
 
         return resultRow.get();
     }
+
+    T* applySeparableKernel(const SeparableKernel& kernel, uint8_t channelMask) {
+        if (static_cast<uint64_t>(kernel.getHeight()) != length || static_cast<uint64_t>(kernel.getWidth()) > width) {
+            throw std::invalid_argument("Kernel with this size cannot be applied to buffer!");
+        }
+
+        uint64_t paddedWidth = width + kernel.getWidth() - 1;
+        if (columnSumsLength < paddedWidth) {
+            columnSumsLength = paddedWidth;
+            columnSums = std::make_unique<double[]>(3 * columnSumsLength);
+            channelSums = std::make_unique<double[]>(3 * width);
+        }
+
+        double* redColumnSums = columnSums.get();
+        double* greenColumnSums = redColumnSums + columnSumsLength;
+        double* blueColumnSums = greenColumnSums + columnSumsLength;
+        double* redSums = channelSums.get();
+        double* greenSums = redSums + width;
+        double* blueSums = greenSums + width;
+
+        std::fill(channelSums.get(), channelSums.get() + 3 * width, 0.0);
+
+        for (uint64_t term = 0; term < kernel.getRank(); term++) {
+            const std::vector<double>& vertical = kernel.getVerticalTerm(term);
+            const std::vector<double>& horizontal = kernel.getHorizontalTerm(term);
+
+            std::fill(columnSums.get(), columnSums.get() + 3 * columnSumsLength, 0.0);
+            for (uint64_t i = 0; i < length; i++) {
+                double weight = vertical[i];
+                if (weight == 0) {
+                    continue;
+                }
+                const T* row = getRow(i);
+                for (uint64_t m = 0; m < width; m++) {
+                    redColumnSums[m] += weight * row[m].red;
+                    greenColumnSums[m] += weight * row[m].green;
+                    blueColumnSums[m] += weight * row[m].blue;
+                }
+            }
+            for (uint64_t m = width; m < paddedWidth; m++) {
+                uint64_t col = mirrorColIndex(m);
+                redColumnSums[m] = redColumnSums[col];
+                greenColumnSums[m] = greenColumnSums[col];
+                blueColumnSums[m] = blueColumnSums[col];
+            }
+
+            for (int64_t j = 0; j < kernel.getWidth(); j++) {
+                double weight = horizontal[j];
+                if (weight == 0) {
+                    continue;
+                }
+                for (uint64_t k = 0; k < width; k++) {
+                    redSums[k] += weight * redColumnSums[k + j];
+                    greenSums[k] += weight * greenColumnSums[k + j];
+                    blueSums[k] += weight * blueColumnSums[k + j];
+                }
+            }
+        }
+
+        int64_t rowCenterOffset = (kernel.getHeight() - 1) / 2;
+        const T* centerRow = getRow(rowCenterOffset);
+
+        for (uint64_t k = 0; k < width; k++) {
+            resultRow[k].red = (channelMask & Red) ? getNormalizedChannelValue(getSeparableSum(redSums[k], kernel.isIntegerValued()), T::getMaxChannelValue()) : centerRow[k].red;
+            resultRow[k].green = (channelMask & Green) ? getNormalizedChannelValue(getSeparableSum(greenSums[k], kernel.isIntegerValued()), T::getMaxChannelValue()) : centerRow[k].green;
+            resultRow[k].blue = (channelMask & Blue) ? getNormalizedChannelValue(getSeparableSum(blueSums[k], kernel.isIntegerValued()), T::getMaxChannelValue()) : centerRow[k].blue;
+        }
+
+        return resultRow.get();
+    }
 };
@@ -5,13 +5,14 @@
 #include <stdexcept>
 #include <iostream>
 #include <iomanip>
+#include <vector>
 
-#define MAX_KERNEL_SIZE 50
+#define MAX_KERNEL_SIZE 1025
 
 class Kernel
 {
 private:
-    double data[MAX_KERNEL_SIZE][MAX_KERNEL_SIZE];
+    std::vector<double> data;
     int64_t width;
     int64_t height;
     uint64_t getValidatedSize(uint64_t size) {
@@ -30,36 +31,39 @@ public:
     Kernel(uint64_t width, uint64_t height) {
         this->width = getValidatedSize(width);
         this->height = getValidatedSize(height);
+        data.resize(this->width * this->height);
     }
 
     void setWidth(uint64_t width) {
         this->width = getValidatedSize(width);
+        data.resize(this->width * height);
     }
 
     void setHeight(uint64_t height) {
         this->height = getValidatedSize(height);
+        data.resize(width * this->height);
     }
 
     double* operator[](uint64_t row) {
-        return data[row];
+        return data.data() + row * width;
     }
 
     const double* operator[](uint64_t row) const {
-        return data[row];
+        return data.data() + row * width;
     }
 
     double getElem(uint64_t row, uint64_t col) const {
         if (row >= height || col >= width) {
             throw std::out_of_range("Index out of bounds");
         }
-        return data[row][col];
+        return data[row * width + col];
     }
 
     void setElem(uint64_t row, uint64_t col, double value) {
         if (row >= height || col >= width) {
             throw std::out_of_range("Index out of bounds");
         }
-        data[row][col] = value;
+        data[row * width + col] = value;
     }
 
     int64_t getWidth() const {
@@ -74,7 +78,7 @@ public:
         os << "Kernel (" << kernel.height << "x" << kernel.width << "):" << std::endl;
         for (int64_t i = 0; i < kernel.height; i++) {
             for (int64_t j = 0; j < kernel.width; j++) {
-                os << std::setw(8) << std::setprecision(5) << kernel.data[i][j] << " ";
+                os << std::setw(8) << std::setprecision(5) << kernel[i][j] << " ";
             }
             os << std::endl;
         }
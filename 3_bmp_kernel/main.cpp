@@ -3,11 +3,13 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cmath>
-#include <fstream>
 #include <memory>
+#include <algorithm>
 #include "bitmap.h"
 #include "kernel.h"
 #include "imagerowsringbuffer.h"
+#include "rowbandconvolutionengine.h"
+#include "../common/mappedbitmap.h"
 
 using namespace std;
 
@@ -45,7 +47,7 @@ void chooseKernel(Kernel& kernel, uint8_t& channelMask) {
     }
 
     kernel.setHeight(rows);
-    kernel.setWidth(rows);
+    kernel.setWidth(cols);
 
     if (chosenNumber == 1) { // Manual
         cout << "Input matrix: " << endl;
@@ -93,41 +95,30 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    ifstream inputStream;
-    inputStream.open(argv[1], std::ios_base::binary);
-
-    ofstream outputStream;
-    outputStream.open(argv[2], std::ios_base::binary);
-
-    if (!inputStream.is_open() || !outputStream.is_open()) {
-        cerr << "Can't open files!" << endl;
+    std::unique_ptr<MappedBitmapReader> input;
+    try {
+        input = std::make_unique<MappedBitmapReader>(argv[1]);
+    } catch (const std::exception& exception) {
+        cerr << exception.what() << endl;
         return 2;
     }
 
     BitmapFileHeader bitmapInputFileHeader;
     BitmapInfoHeaderV3 bitmapInputInfoHeader;
-
-    inputStream.read((char*)&bitmapInputFileHeader, sizeof(BitmapFileHeader));
-    if (bitmapInputFileHeader.bfType != 0x4d42 || inputStream.fail()) {
-        cerr << "Not BMP file!" << endl;
-        return 3;
-    }
-
-    inputStream.read((char*)&bitmapInputInfoHeader, sizeof(BitmapInfoHeaderV3));
-    inputStream.seekg(bitmapInputFileHeader.bfOffBits, ios_base::beg);
-
-    if (inputStream.fail()) {
-        cerr << "Error reading source file!" << endl;
+    try {
+        input->readHeaders(bitmapInputFileHeader, bitmapInputInfoHeader);
+    } catch (const std::exception& exception) {
+        cerr << exception.what() << endl;
         return 4;
     }
 
-    if (bitmapInputInfoHeader.biBitCount != 24) {
+    if (input->getBitCount() != 24) {
         cerr << "Not 24 bit BMP file!" << endl;
         return 5;
     }
 
-    int32_t inputWidthPx = bitmapInputInfoHeader.biWidth;
-    int32_t inputHeightPx = bitmapInputInfoHeader.biHeight;
+    int32_t inputWidthPx = input->getWidth();
+    int32_t inputHeightPx = input->getHeight();
 
     int32_t outputWidthPx = inputWidthPx;
     int32_t outputHeight = inputHeightPx;
@@ -135,20 +126,11 @@ int main(int argc, char** argv) {
     BitmapFileHeader bitmapOutputFileHeader = bitmapInputFileHeader;
     BitmapInfoHeaderV3 bitmapOutputInfoHeader = bitmapInputInfoHeader;
 
-    uint64_t inputRowBytesCountWithoutPadding = inputWidthPx * 3;
     uint64_t outputRowBytesCountWithoutPadding = outputWidthPx * 3;
-
-    uint64_t inputRowBytesCountWithPadding = getRowSizeWithPadding(inputRowBytesCountWithoutPadding);
     uint64_t outputRowBytesCountWithPadding = getRowSizeWithPadding(outputRowBytesCountWithoutPadding);
 
-    uint64_t paddingBytes = inputRowBytesCountWithPadding - inputRowBytesCountWithoutPadding;
-
-    std::unique_ptr<uint8_t[]> inputRow = std::make_unique<uint8_t[]>(inputRowBytesCountWithPadding);
-    std::unique_ptr<uint8_t[]> outputRow = std::make_unique<uint8_t[]>(outputRowBytesCountWithPadding);
-
     bitmapOutputFileHeader.bfSize = sizeof(BitmapFileHeader) + sizeof(BitmapInfoHeaderV3) + outputRowBytesCountWithPadding * outputHeight;
     bitmapOutputFileHeader.bfOffBits = sizeof(BitmapFileHeader) + sizeof(BitmapInfoHeaderV3);
-    outputStream.write((char*)&bitmapOutputFileHeader, sizeof(BitmapFileHeader));
 
     bitmapOutputInfoHeader.biWidth = outputWidthPx;
     bitmapOutputInfoHeader.biHeight = outputHeight;
@@ -171,68 +153,77 @@ int main(int argc, char** argv) {
     uint64_t kernelHeight = kernel.getHeight();
     uint64_t kernelWidth = kernel.getWidth();
 
-    ImageRowsRingBuffer<Bitmap24Pixel> ringBuffer(kernelHeight, inputWidthPx, paddingBytes);
-
     if (kernelWidth > inputWidthPx || kernelHeight > inputHeightPx) {
         cerr << "Filter size (" << kernelWidth << " x " << kernelHeight << ") is too big for this image ("
              << inputWidthPx << " x " << inputHeightPx << ")!" << endl;
         return 7;
     }
-    outputStream.write((char*)&bitmapOutputInfoHeader, sizeof(BitmapInfoHeaderV3));
 
-    inputStream.seekg((kernelHeight + 1) / 2 * inputRowBytesCountWithPadding, ios_base::cur);
-    for (int32_t i = 0; i < (kernelHeight + 1) / 2; i++) {
-        inputStream.read((char*)ringBuffer.pushNewRowAndGetPtr(), inputRowBytesCountWithoutPadding);
-        inputStream.seekg(paddingBytes - 2 * inputRowBytesCountWithPadding, ios_base::cur);
-        if (inputStream.fail()) {
-            cerr << "Error reading source image!" << endl;
-            return 8;
-        }
+    std::unique_ptr<MappedBitmapWriter> output;
+    try {
+        output = std::make_unique<MappedBitmapWriter>(argv[2], bitmapOutputFileHeader, bitmapOutputInfoHeader,
+                                                      outputWidthPx, outputHeight);
+    } catch (const std::exception& exception) {
+        cerr << exception.what() << endl;
+        return 2;
     }
 
-    inputStream.seekg(bitmapOutputFileHeader.bfOffBits, ios_base::beg);
-
-    for (int32_t i = 0; i < (kernelHeight) / 2; i++) {
-        inputStream.read((char*)ringBuffer.pushNewRowAndGetPtr(), inputRowBytesCountWithoutPadding);
-        inputStream.seekg(paddingBytes, ios_base::cur);
-        if (inputStream.fail()) {
-            cerr << "Error reading source image!" << endl;
-            return 9;
-        }
+    uint64_t threadsCount = RowBandConvolutionEngine::getDefaultThreadsCount();
+    if (argc >= 4) {
+        threadsCount = std::max(1, atoi(argv[3]));
     }
+    cout << "Threads: " << threadsCount << endl;
 
-    Bitmap24Pixel* newRow;
-    for (int32_t i = 0; i < inputHeightPx - (kernelHeight) / 2; i++) {
-        inputStream.read((char*)ringBuffer.pushNewRowAndGetPtr(), inputRowBytesCountWithoutPadding);
-        inputStream.seekg(paddingBytes, ios_base::cur);
-        if (inputStream.fail()) {
-            cerr << "Error reading source image!" << endl;
-            return 10;
+    RowBandConvolutionEngine engine(*input, *output);
+    try {
+        if (argc >= 5) {
+            string instructionSetName = argv[4];
+            if (instructionSetName == "scalar") {
+                engine.setInstructionSet(InstructionSet::Scalar);
+            } else if (instructionSetName == "avx2") {
+                engine.setInstructionSet(InstructionSet::Avx2);
+            } else if (instructionSetName == "avx512") {
+                engine.setInstructionSet(InstructionSet::Avx512);
+            } else {
+                throw std::invalid_argument("Unknown instruction set: " + instructionSetName);
+            }
         }
-
-        newRow = ringBuffer.applyKernel(kernel, channelMask);
-
-        outputStream.write((char*)newRow, outputRowBytesCountWithPadding);
-        if (outputStream.fail()) {
-            cerr << "Error writing to file!" << endl;
-            return 11;
+        if (argc >= 6) {
+            string modeName = argv[5];
+            if (modeName == "auto") {
+                engine.setMode(ConvolutionMode::Automatic);
+            } else if (modeName == "dense") {
+                engine.setMode(ConvolutionMode::Dense);
+            } else if (modeName == "separable") {
+                engine.setMode(ConvolutionMode::Separable);
+            } else if (modeName == "fft") {
+                engine.setMode(ConvolutionMode::Fft);
+            } else if (modeName == "fixed") {
+                engine.setMode(ConvolutionMode::FixedPoint);
+            } else {
+                throw std::invalid_argument("Unknown convolution mode: " + modeName);
+            }
         }
-    }
-
-    for (int32_t i = 0; i < (kernelHeight) / 2; i++) {
-        inputStream.seekg(paddingBytes - 2 * inputRowBytesCountWithPadding, ios_base::cur);
-        inputStream.read((char*)ringBuffer.pushNewRowAndGetPtr(), inputRowBytesCountWithoutPadding);
-        newRow = ringBuffer.applyKernel(kernel, channelMask);
-        outputStream.write((char*)newRow, outputRowBytesCountWithPadding);
-        if (outputStream.fail()) {
-            cerr << "Error writing to file!" << endl;
-            return 12;
+        cout << "Instruction set: " << getInstructionSetName(engine.getInstructionSet()) << endl;
+
+        ConvolutionMode mode = engine.run(kernel, channelMask, threadsCount);
+        cout << "Convolution mode: " << getConvolutionModeName(mode) << endl;
+        if (mode == ConvolutionMode::Separable) {
+            const SeparableKernel& separableKernel = engine.getSeparableKernel();
+            cout << "Separable kernel rank: " << separableKernel.getRank()
+                 << " (relative error " << separableKernel.getRelativeError() << ")" << endl;
         }
+        if (mode == ConvolutionMode::FixedPoint) {
+            FixedPointKernel fixedPointKernel(kernel);
+            cout << "Fixed point shift: " << fixedPointKernel.getShift()
+                 << " (max sum error " << fixedPointKernel.getMaxOutputError() << ", channel values differ by at most "
+                 << static_cast<int64_t>(fixedPointKernel.getMaxOutputError()) + 1 << ")" << endl;
+        }
+    } catch (const std::exception& exception) {
+        cerr << exception.what() << endl;
+        return 8;
     }
 
-
-    outputStream.close();
-    inputStream.close();
     cout << "Success!" << endl;
     return 0;
 }
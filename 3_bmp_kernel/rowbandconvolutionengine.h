@@ -0,0 +1,259 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <stdexcept>
+#include <algorithm>
+#include "bitmap.h"
+#include "kernel.h"
+#include "imagerowsringbuffer.h"
+#include "vectorizedkernelapplier.h"
+#include "separablekernel.h"
+#include "fftconvolver.h"
+#include "fixedpointkernelapplier.h"
+#include "../common/mappedbitmap.h"
+
+enum class ConvolutionMode : uint8_t {
+    Automatic,
+    Dense,
+    Separable,
+    Fft,
+    FixedPoint
+};
+
+inline const char* getConvolutionModeName(ConvolutionMode mode) {
+    switch (mode) {
+    case ConvolutionMode::Dense:
+        return "dense";
+    case ConvolutionMode::Separable:
+        return "separable";
+    case ConvolutionMode::Fft:
+        return "FFT";
+    case ConvolutionMode::FixedPoint:
+        return "fixed point";
+    default:
+        return "automatic";
+    }
+}
+
+// Image is split into horizontal bands, every band is processed in its own thread
+// with its own ring buffer (band rows + kernel halo rows). Rows are read from and written to
+// mapped files, so bands don't share any stream state.
+class RowBandConvolutionEngine
+{
+private:
+    const MappedBitmapReader& input;
+    const MappedBitmapWriter& output;
+    int64_t width;
+    int64_t height;
+    uint64_t rowBytesCountWithoutPadding;
+    ConvolutionMode mode;
+    InstructionSet instructionSet;
+    SeparableKernel separableKernel;
+
+    int64_t mirrorRowIndex(int64_t row) const {
+        if (row < 0) {
+            row = -row;
+        }
+        if (row >= height) {
+            row = 2 * height - 2 - row;
+        }
+        return row;
+    }
+
+    void readRow(int64_t row, const Bitmap24Pixel* destination) const {
+        memcpy((void*)destination, input.getRow(mirrorRowIndex(row)), rowBytesCountWithoutPadding);
+    }
+
+    void writeRow(int64_t row, const Bitmap24Pixel* source) const {
+        memcpy(output.getRow(row), source, rowBytesCountWithoutPadding);
+    }
+
+    void convolveBand(int64_t rowBegin, int64_t rowEnd, const Kernel& kernel, const SeparableKernel& separableKernel,
+                      ConvolutionMode bandMode, uint8_t channelMask) const {
+        int64_t kernelHeight = kernel.getHeight();
+        int64_t rowCenterOffset = (kernelHeight - 1) / 2;
+        ImageRowsRingBuffer<Bitmap24Pixel> ringBuffer(kernelHeight, width);
+        std::unique_ptr<VectorizedKernelApplier> vectorizedApplier;
+        if (bandMode == ConvolutionMode::Dense && instructionSet != InstructionSet::Scalar) {
+            vectorizedApplier = std::make_unique<VectorizedKernelApplier>(kernel, width, instructionSet);
+        }
+        std::unique_ptr<FixedPointKernelApplier> fixedPointApplier;
+        if (bandMode == ConvolutionMode::FixedPoint) {
+            fixedPointApplier = std::make_unique<FixedPointKernelApplier>(kernel, width, instructionSet);
+        }
+
+        auto pushRow = [&](int64_t row) {
+            const Bitmap24Pixel* ringBufferRow = ringBuffer.pushNewRowAndGetPtr();
+            readRow(row, ringBufferRow);
+            if (vectorizedApplier) {
+                vectorizedApplier->pushRow(ringBufferRow);
+            }
+            if (fixedPointApplier) {
+                fixedPointApplier->pushRow(ringBufferRow);
+            }
+        };
+
+        for (int64_t row = rowBegin - rowCenterOffset; row < rowBegin - rowCenterOffset + kernelHeight - 1; row++) {
+            pushRow(row);
+        }
+
+        for (int64_t row = rowBegin; row < rowEnd; row++) {
+            pushRow(row - rowCenterOffset + kernelHeight - 1);
+
+            Bitmap24Pixel* newRow;
+            if (bandMode == ConvolutionMode::Separable) {
+                newRow = ringBuffer.applySeparableKernel(separableKernel, channelMask);
+            } else if (fixedPointApplier) {
+                newRow = fixedPointApplier->apply(ringBuffer.getRow(rowCenterOffset), channelMask);
+            } else if (vectorizedApplier) {
+                newRow = vectorizedApplier->apply(ringBuffer.getRow(rowCenterOffset), channelMask);
+            } else {
+                newRow = ringBuffer.applyKernel(kernel, channelMask);
+            }
+
+            writeRow(row, newRow);
+        }
+    }
+
+    void convolveBandFft(int64_t rowBegin, int64_t rowEnd, const Kernel& kernel, uint8_t channelMask) const {
+        FftConvolver fftConvolver(kernel);
+        int64_t kernelHeight = kernel.getHeight();
+        int64_t rowCenterOffset = (kernelHeight - 1) / 2;
+        int64_t blockHeight = fftConvolver.getBlockHeight();
+        ImageRowsRingBuffer<Bitmap24Pixel> ringBuffer(blockHeight + kernelHeight - 1, width);
+
+        for (int64_t row = rowBegin - rowCenterOffset; row < rowBegin - rowCenterOffset + kernelHeight - 1; row++) {
+            readRow(row, ringBuffer.pushNewRowAndGetPtr());
+        }
+
+        for (int64_t blockBegin = rowBegin; blockBegin < rowEnd; blockBegin += blockHeight) {
+            int64_t outputRowsCount = std::min(blockHeight, rowEnd - blockBegin);
+            for (int64_t row = blockBegin; row < blockBegin + outputRowsCount; row++) {
+                readRow(row - rowCenterOffset + kernelHeight - 1, ringBuffer.pushNewRowAndGetPtr());
+            }
+
+            std::vector<const Bitmap24Pixel*> rows(outputRowsCount + kernelHeight - 1);
+            for (uint64_t r = 0; r < rows.size(); r++) {
+                rows[r] = ringBuffer.getRow(blockHeight - outputRowsCount + r);
+            }
+            std::vector<Bitmap24Pixel*> outputRows(outputRowsCount);
+            for (int64_t r = 0; r < outputRowsCount; r++) {
+                outputRows[r] = (Bitmap24Pixel*)output.getRow(blockBegin + r);
+            }
+
+            fftConvolver.convolveRows(rows, width, outputRows, channelMask);
+        }
+    }
+
+public:
+    // Output must have the same size as input
+    RowBandConvolutionEngine(const MappedBitmapReader& input, const MappedBitmapWriter& output)
+        : input(input), output(output), width(input.getWidth()), height(input.getHeight()) {
+        rowBytesCountWithoutPadding = width * sizeof(Bitmap24Pixel);
+        instructionSet = detectInstructionSet();
+        mode = ConvolutionMode::Automatic;
+    }
+
+    void setMode(ConvolutionMode mode) {
+        this->mode = mode;
+    }
+
+    ConvolutionMode getMode() const {
+        return mode;
+    }
+
+    void setInstructionSet(InstructionSet instructionSet) {
+        if (instructionSet > detectInstructionSet()) {
+            throw std::invalid_argument("Instruction set is not supported by this CPU!");
+        }
+        this->instructionSet = instructionSet;
+    }
+
+    InstructionSet getInstructionSet() const {
+        return instructionSet;
+    }
+
+    static uint64_t getDefaultThreadsCount() {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Estimated multiply-adds per output channel value, dense cost accounts for vector length
+    double estimateCostPerPixel(ConvolutionMode mode, const Kernel& kernel, const SeparableKernel& separableKernel) const {
+        switch (mode) {
+        case ConvolutionMode::Separable:
+            return separableKernel.getRank() * (kernel.getWidth() + kernel.getHeight());
+        case ConvolutionMode::Fft:
+            return FftConvolver::estimateCostPerPixel(kernel.getWidth(), kernel.getHeight());
+        default:
+            return static_cast<double>(kernel.getWidth() * kernel.getHeight()) / getInstructionSetVectorLength(instructionSet);
+        }
+    }
+
+    // The automatic mode keeps the output of the dense path: FFT and separable sums differ from the dense sums by rounding
+    // errors, that change truncated channel values by one, only separable sums of integer kernels are restored exactly
+    ConvolutionMode resolveMode(const Kernel& kernel, const SeparableKernel& separableKernel) const {
+        if (mode != ConvolutionMode::Automatic) {
+            return mode;
+        }
+        if (separableKernel.isIntegerValued() &&
+            estimateCostPerPixel(ConvolutionMode::Separable, kernel, separableKernel) <
+            estimateCostPerPixel(ConvolutionMode::Dense, kernel, separableKernel)) {
+            return ConvolutionMode::Separable;
+        }
+        return ConvolutionMode::Dense;
+    }
+
+    // Decomposition of the kernel of the last run, empty unless it was in the automatic or separable mode
+    const SeparableKernel& getSeparableKernel() const {
+        return separableKernel;
+    }
+
+    ConvolutionMode run(const Kernel& kernel, uint8_t channelMask, uint64_t threadsCount) {
+        if (kernel.getWidth() > width || kernel.getHeight() > height) {
+            throw std::invalid_argument("Kernel with this size cannot be applied to image!");
+        }
+
+        separableKernel = SeparableKernel();
+        if (mode == ConvolutionMode::Automatic || mode == ConvolutionMode::Separable) {
+            separableKernel = SeparableKernel::decompose(kernel);
+        }
+        ConvolutionMode bandMode = resolveMode(kernel, separableKernel);
+
+        uint64_t bandsCount = std::clamp<uint64_t>(threadsCount, 1, height);
+        std::vector<std::thread> threads;
+        std::vector<std::exception_ptr> errors(bandsCount);
+
+        for (uint64_t band = 0; band < bandsCount; band++) {
+            int64_t rowBegin = height * band / bandsCount;
+            int64_t rowEnd = height * (band + 1) / bandsCount;
+            threads.emplace_back([&, band, rowBegin, rowEnd]() {
+                try {
+                    if (bandMode == ConvolutionMode::Fft) {
+                        convolveBandFft(rowBegin, rowEnd, kernel, channelMask);
+                    } else {
+                        convolveBand(rowBegin, rowEnd, kernel, separableKernel, bandMode, channelMask);
+                    }
+                } catch (...) {
+                    errors[band] = std::current_exception();
+                }
+            });
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        for (auto& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+
+        return bandMode;
+    }
+};
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include "kernel.h"
+
+// Kernel represented as sum of outer products: kernel[i][j] = sum(vertical[t][i] * horizontal[t][j]).
+// Terms are obtained by cross approximation (keeps exact factors of integer kernels like Sobel)
+// or by SVD (one-sided Jacobi), whichever gives lower rank for the same relative Frobenius norm error.
+class SeparableKernel
+{
+private:
+    int64_t width;
+    int64_t height;
+    std::vector<std::vector<double>> verticalTerms;
+    std::vector<std::vector<double>> horizontalTerms;
+    double relativeError;
+    bool integerValued;
+
+    static constexpr int MAX_SWEEPS_COUNT = 60;
+
+    static bool isIntegerValued(const Kernel& kernel) {
+        for (int64_t i = 0; i < kernel.getHeight(); i++) {
+            for (int64_t j = 0; j < kernel.getWidth(); j++) {
+                if (kernel[i][j] != std::round(kernel[i][j])) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    static double getSquareNorm(const Kernel& kernel) {
+        double norm = 0;
+        for (int64_t i = 0; i < kernel.getHeight(); i++) {
+            for (int64_t j = 0; j < kernel.getWidth(); j++) {
+                norm += kernel[i][j] * kernel[i][j];
+            }
+        }
+        return norm;
+    }
+
+public:
+    static constexpr double DEFAULT_TOLERANCE = 1e-7;
+
+    SeparableKernel(): width(0), height(0), relativeError(0), integerValued(false) {}
+
+    static SeparableKernel decompose(const Kernel& kernel, double tolerance = DEFAULT_TOLERANCE) {
+        SeparableKernel crossKernel = decomposeByCrossApproximation(kernel, tolerance);
+        if (crossKernel.getRank() <= 1) {
+            return crossKernel;
+        }
+        SeparableKernel svdKernel = decomposeBySvd(kernel, tolerance);
+        return svdKernel.getRank() < crossKernel.getRank() ? svdKernel : crossKernel;
+    }
+
+    static SeparableKernel decomposeByCrossApproximation(const Kernel& kernel, double tolerance = DEFAULT_TOLERANCE) {
+        int64_t height = kernel.getHeight();
+        int64_t width = kernel.getWidth();
+
+        std::vector<std::vector<double>> residual(height, std::vector<double>(width));
+        for (int64_t i = 0; i < height; i++) {
+            for (int64_t j = 0; j < width; j++) {
+                residual[i][j] = kernel[i][j];
+            }
+        }
+
+        double total = getSquareNorm(kernel);
+        double rest = total;
+
+        SeparableKernel separableKernel;
+        separableKernel.width = width;
+        separableKernel.height = height;
+        while (rest > tolerance * tolerance * total) {
+            int64_t pivotRow = 0;
+            int64_t pivotCol = 0;
+            for (int64_t i = 0; i < height; i++) {
+                for (int64_t j = 0; j < width; j++) {
+                    if (std::abs(residual[i][j]) > std::abs(residual[pivotRow][pivotCol])) {
+                        pivotRow = i;
+                        pivotCol = j;
+                    }
+                }
+            }
+            double pivot = residual[pivotRow][pivotCol];
+            if (pivot == 0) {
+                break;
+            }
+
+            std::vector<double> vertical(height);
+            std::vector<double> horizontal(width);
+            for (int64_t i = 0; i < height; i++) {
+                vertical[i] = residual[i][pivotCol];
+            }
+            for (int64_t j = 0; j < width; j++) {
+                horizontal[j] = residual[pivotRow][j] / pivot;
+            }
+
+            rest = 0;
+            for (int64_t i = 0; i < height; i++) {
+                for (int64_t j = 0; j < width; j++) {
+                    residual[i][j] = (i == pivotRow || j == pivotCol) ? 0 : residual[i][j] - vertical[i] * horizontal[j];
+                    rest += residual[i][j] * residual[i][j];
+                }
+            }
+
+            separableKernel.verticalTerms.push_back(std::move(vertical));
+            separableKernel.horizontalTerms.push_back(std::move(horizontal));
+        }
+        separableKernel.relativeError = total > 0 ? std::sqrt(rest / total) : 0;
+        separableKernel.integerValued = isIntegerValued(kernel);
+
+        return separableKernel;
+    }
+
+    static SeparableKernel decomposeBySvd(const Kernel& kernel, double tolerance = DEFAULT_TOLERANCE) {
+        int64_t height = kernel.getHeight();
+        int64_t width = kernel.getWidth();
+
+        std::vector<std::vector<double>> a(width, std::vector<double>(height));
+        std::vector<std::vector<double>> v(width, std::vector<double>(width, 0));
+        for (int64_t j = 0; j < width; j++) {
+            for (int64_t i = 0; i < height; i++) {
+                a[j][i] = kernel[i][j];
+            }
+            v[j][j] = 1;
+        }
+
+        for (int sweep = 0; sweep < MAX_SWEEPS_COUNT; sweep++) {
+            bool converged = true;
+            for (int64_t p = 0; p < width - 1; p++) {
+                for (int64_t q = p + 1; q < width; q++) {
+                    double alpha = 0;
+                    double beta = 0;
+                    double gamma = 0;
+                    for (int64_t i = 0; i < height; i++) {
+                        alpha += a[p][i] * a[p][i];
+                        beta += a[q][i] * a[q][i];
+                        gamma += a[p][i] * a[q][i];
+                    }
+                    if (gamma == 0 || std::abs(gamma) <= 1e-15 * std::sqrt(alpha * beta)) {
+                        continue;
+                    }
+                    converged = false;
+
+                    double zeta = (beta - alpha) / (2 * gamma);
+                    double t = (zeta >= 0 ? 1.0 : -1.0) / (std::abs(zeta) + std::sqrt(1 + zeta * zeta));
+                    double c = 1 / std::sqrt(1 + t * t);
+                    double s = c * t;
+                    for (int64_t i = 0; i < height; i++) {
+                        double ap = a[p][i];
+                        double aq = a[q][i];
+                        a[p][i] = c * ap - s * aq;
+                        a[q][i] = s * ap + c * aq;
+                    }
+                    for (int64_t j = 0; j < width; j++) {
+                        double vp = v[p][j];
+                        double vq = v[q][j];
+                        v[p][j] = c * vp - s * vq;
+                        v[q][j] = s * vp + c * vq;
+                    }
+                }
+            }
+            if (converged) {
+                break;
+            }
+        }
+
+        std::vector<double> singularValuesSquare(width, 0);
+        for (int64_t p = 0; p < width; p++) {
+            for (int64_t i = 0; i < height; i++) {
+                singularValuesSquare[p] += a[p][i] * a[p][i];
+            }
+        }
+        std::vector<int64_t> order(width);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](int64_t lhs, int64_t rhs) {
+            return singularValuesSquare[lhs] > singularValuesSquare[rhs];
+        });
+
+        double total = std::accumulate(singularValuesSquare.begin(), singularValuesSquare.end(), 0.0);
+        double rest = total;
+
+        SeparableKernel separableKernel;
+        separableKernel.width = width;
+        separableKernel.height = height;
+        for (int64_t p : order) {
+            if (rest <= tolerance * tolerance * total) {
+                break;
+            }
+            separableKernel.verticalTerms.push_back(a[p]);
+            separableKernel.horizontalTerms.push_back(v[p]);
+            rest -= singularValuesSquare[p];
+        }
+        separableKernel.relativeError = total > 0 ? std::sqrt(std::max(rest, 0.0) / total) : 0;
+        separableKernel.integerValued = isIntegerValued(kernel);
+
+        return separableKernel;
+    }
+
+    int64_t getWidth() const {
+        return width;
+    }
+
+    int64_t getHeight() const {
+        return height;
+    }
+
+    uint64_t getRank() const {
+        return verticalTerms.size();
+    }
+
+    double getRelativeError() const {
+        return relativeError;
+    }
+
+    // Sums of integer pixels weighted by an integer kernel are integers
+    bool isIntegerValued() const {
+        return integerValued;
+    }
+
+    const std::vector<double>& getVerticalTerm(uint64_t term) const {
+        return verticalTerms[term];
+    }
+
+    const std::vector<double>& getHorizontalTerm(uint64_t term) const {
+        return horizontalTerms[term];
+    }
+};
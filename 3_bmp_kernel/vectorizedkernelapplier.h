@@ -0,0 +1,233 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include "bitmap.h"
+#include "kernel.h"
+#include "imagerowsringbuffer.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VECTORIZED_KERNEL_X86
+#endif
+
+enum class InstructionSet : uint8_t {
+    Scalar,
+    Avx2,
+    Avx512
+};
+
+inline InstructionSet detectInstructionSet() {
+#ifdef VECTORIZED_KERNEL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+        return InstructionSet::Avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return InstructionSet::Avx2;
+    }
+#endif
+    return InstructionSet::Scalar;
+}
+
+inline const char* getInstructionSetName(InstructionSet instructionSet) {
+    switch (instructionSet) {
+    case InstructionSet::Avx2:
+        return "AVX2";
+    case InstructionSet::Avx512:
+        return "AVX-512";
+    default:
+        return "scalar";
+    }
+}
+
+inline uint64_t getInstructionSetVectorLength(InstructionSet instructionSet) {
+    switch (instructionSet) {
+    case InstructionSet::Avx2:
+        return 4;
+    case InstructionSet::Avx512:
+        return 8;
+    default:
+        return 1;
+    }
+}
+
+// Keeps kernel rows as mirrored planar double rows (blue, green, red planes),
+// so every output row is a plain sum of weighted shifted rows.
+class VectorizedKernelApplier
+{
+private:
+    static constexpr uint64_t CHANNELS_COUNT = 3;
+    static constexpr uint64_t BLOCK_LENGTH = 32;
+
+    InstructionSet instructionSet;
+    int64_t width;
+    int64_t kernelWidth;
+    int64_t kernelHeight;
+    uint64_t planeLength;
+    uint64_t beginIndex;
+    std::unique_ptr<double[]> weights;
+    std::unique_ptr<double[]> planes;
+    std::unique_ptr<int32_t[]> channelValues;
+    std::unique_ptr<Bitmap24Pixel[]> resultRow;
+
+    const double* getPlane(uint64_t row, uint64_t channel) const {
+        uint64_t realRow = (beginIndex + row) % kernelHeight;
+        return planes.get() + (realRow * CHANNELS_COUNT + channel) * planeLength;
+    }
+
+#ifdef VECTORIZED_KERNEL_X86
+    // Products are added one by one in the order of ImageRowsRingBuffer::applyKernel without fused multiply-adds,
+    // so the sums and the channel values are equal to the scalar ones
+    __attribute__((target("avx2")))
+    void convolveChannelAvx2(uint64_t channel) {
+        constexpr int64_t VECTORS_COUNT = 4;
+        const __m256d signMask = _mm256_set1_pd(-0.0);
+        const __m256d maxValue = _mm256_set1_pd(Bitmap24Pixel::getMaxChannelValue());
+
+        for (int64_t k = 0; k < width; k += 4 * VECTORS_COUNT) {
+            __m256d sums[VECTORS_COUNT];
+            for (int64_t v = 0; v < VECTORS_COUNT; v++) {
+                sums[v] = _mm256_setzero_pd();
+            }
+
+            for (int64_t i = 0; i < kernelHeight; i++) {
+                const double* plane = getPlane(i, channel) + k;
+                const double* weightsRow = weights.get() + i * kernelWidth;
+                for (int64_t j = 0; j < kernelWidth; j++) {
+                    __m256d weight = _mm256_set1_pd(weightsRow[j]);
+                    for (int64_t v = 0; v < VECTORS_COUNT; v++) {
+                        sums[v] = _mm256_add_pd(sums[v], _mm256_mul_pd(weight, _mm256_loadu_pd(plane + j + 4 * v)));
+                    }
+                }
+            }
+
+            for (int64_t v = 0; v < VECTORS_COUNT; v++) {
+                __m256d sum = _mm256_min_pd(_mm256_andnot_pd(signMask, sums[v]), maxValue);
+                _mm_storeu_si128((__m128i*)(channelValues.get() + k + 4 * v), _mm256_cvttpd_epi32(sum));
+            }
+        }
+    }
+
+    // Same sums as convolveChannelAvx2, the rounding intrinsics keep the compiler from fusing them into FMA.
+    // Zero-masked forms avoid the undefined pass-through operands of the unmasked ones
+    __attribute__((target("avx512f")))
+    void convolveChannelAvx512(uint64_t channel) {
+        constexpr int64_t VECTORS_COUNT = 4;
+        constexpr __mmask8 ALL_LANES = 0xFF;
+        const __m512d maxValue = _mm512_set1_pd(Bitmap24Pixel::getMaxChannelValue());
+
+        for (int64_t k = 0; k < width; k += 8 * VECTORS_COUNT) {
+            __m512d sums[VECTORS_COUNT];
+            for (int64_t v = 0; v < VECTORS_COUNT; v++) {
+                sums[v] = _mm512_setzero_pd();
+            }
+
+            for (int64_t i = 0; i < kernelHeight; i++) {
+                const double* plane = getPlane(i, channel) + k;
+                const double* weightsRow = weights.get() + i * kernelWidth;
+                for (int64_t j = 0; j < kernelWidth; j++) {
+                    __m512d weight = _mm512_set1_pd(weightsRow[j]);
+                    for (int64_t v = 0; v < VECTORS_COUNT; v++) {
+                        __m512d product = _mm512_maskz_mul_round_pd(ALL_LANES, weight, _mm512_loadu_pd(plane + j + 8 * v),
+                                                                    _MM_FROUND_CUR_DIRECTION);
+                        sums[v] = _mm512_maskz_add_round_pd(ALL_LANES, sums[v], product, _MM_FROUND_CUR_DIRECTION);
+                    }
+                }
+            }
+
+            for (int64_t v = 0; v < VECTORS_COUNT; v++) {
+                __m512d sum = _mm512_maskz_min_pd(ALL_LANES, _mm512_abs_pd(sums[v]), maxValue);
+                _mm256_storeu_si256((__m256i*)(channelValues.get() + k + 8 * v), _mm512_maskz_cvttpd_epi32(ALL_LANES, sum));
+            }
+        }
+    }
+#endif
+
+    void convolveChannel(uint64_t channel) {
+#ifdef VECTORIZED_KERNEL_X86
+        if (instructionSet == InstructionSet::Avx512) {
+            convolveChannelAvx512(channel);
+            return;
+        }
+        if (instructionSet == InstructionSet::Avx2) {
+            convolveChannelAvx2(channel);
+            return;
+        }
+#endif
+        throw std::logic_error("Vectorized kernel is not supported by this CPU!");
+    }
+
+public:
+    VectorizedKernelApplier(const Kernel& kernel, uint64_t width, InstructionSet instructionSet) {
+        if (instructionSet == InstructionSet::Scalar) {
+            throw std::invalid_argument("Vectorized kernel requires AVX2 or AVX-512!");
+        }
+        this->instructionSet = instructionSet;
+        this->width = width;
+        kernelWidth = kernel.getWidth();
+        kernelHeight = kernel.getHeight();
+        beginIndex = 0;
+
+        uint64_t blocksCount = divideWithCeil<uint64_t>(width, BLOCK_LENGTH);
+        planeLength = (blocksCount + 1) * BLOCK_LENGTH + kernelWidth;
+
+        weights = std::make_unique<double[]>(kernelHeight * kernelWidth);
+        for (int64_t i = 0; i < kernelHeight; i++) {
+            for (int64_t j = 0; j < kernelWidth; j++) {
+                weights[i * kernelWidth + j] = kernel[i][j];
+            }
+        }
+
+        planes = std::make_unique<double[]>(kernelHeight * CHANNELS_COUNT * planeLength);
+        channelValues = std::make_unique<int32_t[]>(blocksCount * BLOCK_LENGTH);
+        resultRow = std::make_unique<Bitmap24Pixel[]>(width + 4);
+    }
+
+    void pushRow(const Bitmap24Pixel* row) {
+        double* blue = planes.get() + beginIndex * CHANNELS_COUNT * planeLength;
+        double* green = blue + planeLength;
+        double* red = green + planeLength;
+
+        for (int64_t m = 0; m < width + kernelWidth - 1; m++) {
+            int64_t col = m;
+            if (col >= width) {
+                col %= 2 * width;
+                col = 2 * width - col - 1;
+            }
+            blue[m] = row[col].blue;
+            green[m] = row[col].green;
+            red[m] = row[col].red;
+        }
+
+        beginIndex = (beginIndex + 1) % kernelHeight;
+    }
+
+    Bitmap24Pixel* apply(const Bitmap24Pixel* centerRow, uint8_t channelMask) {
+        for (int64_t k = 0; k < width; k++) {
+            resultRow[k] = centerRow[k];
+        }
+
+        if (channelMask & Blue) {
+            convolveChannel(0);
+            for (int64_t k = 0; k < width; k++) {
+                resultRow[k].blue = channelValues[k];
+            }
+        }
+        if (channelMask & Green) {
+            convolveChannel(1);
+            for (int64_t k = 0; k < width; k++) {
+                resultRow[k].green = channelValues[k];
+            }
+        }
+        if (channelMask & Red) {
+            convolveChannel(2);
+            for (int64_t k = 0; k < width; k++) {
+                resultRow[k].red = channelValues[k];
+            }
+        }
+
+        return resultRow.get();
+    }
+};
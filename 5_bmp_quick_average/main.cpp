@@ -3,10 +3,11 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cmath>
-#include <fstream>
 #include <memory>
 #include "bitmap.h"
 #include "imagerowsringbuffer.h"
+#include "../common/mappedbitmap.h"
+#include "../common/asyncrowpipeline.h"
 
 using namespace std;
 
@@ -23,41 +24,31 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    ifstream inputStream;
-    inputStream.open(argv[1], std::ios_base::binary);
-
-    ofstream outputStream;
-    outputStream.open(argv[2], std::ios_base::binary);
-
-    if (!inputStream.is_open() || !outputStream.is_open()) {
-        cerr << "Can't open files!" << endl;
+    std::unique_ptr<MappedBitmapReader> input;
+    try {
+        input = std::make_unique<MappedBitmapReader>(argv[1]);
+    } catch (const std::exception& exception) {
+        cerr << exception.what() << endl;
         return 2;
     }
+    input->adviseSequential();
 
     BitmapFileHeader bitmapInputFileHeader;
     BitmapInfoHeaderV3 bitmapInputInfoHeader;
-
-    inputStream.read((char*)&bitmapInputFileHeader, sizeof(BitmapFileHeader));
-    if (bitmapInputFileHeader.bfType != 0x4d42 || inputStream.fail()) {
-        cerr << "Not BMP file!" << endl;
-        return 3;
-    }
-
-    inputStream.read((char*)&bitmapInputInfoHeader, sizeof(BitmapInfoHeaderV3));
-    inputStream.seekg(bitmapInputFileHeader.bfOffBits, ios_base::beg);
-
-    if (inputStream.fail()) {
-        cerr << "Error reading source file!" << endl;
+    try {
+        input->readHeaders(bitmapInputFileHeader, bitmapInputInfoHeader);
+    } catch (const std::exception& exception) {
+        cerr << exception.what() << endl;
         return 4;
     }
 
-    if (bitmapInputInfoHeader.biBitCount != 24) {
+    if (input->getBitCount() != 24) {
         cerr << "Not 24 bit BMP file!" << endl;
         return 5;
     }
 
-    int32_t inputWidthPx = bitmapInputInfoHeader.biWidth;
-    int32_t inputHeightPx = bitmapInputInfoHeader.biHeight;
+    int32_t inputWidthPx = input->getWidth();
+    int32_t inputHeightPx = input->getHeight();
 
     int32_t outputWidthPx = inputWidthPx;
     int32_t outputHeight = inputHeightPx;
@@ -68,17 +59,10 @@ int main(int argc, char** argv) {
     uint64_t inputRowBytesCountWithoutPadding = inputWidthPx * 3;
     uint64_t outputRowBytesCountWithoutPadding = outputWidthPx * 3;
 
-    uint64_t inputRowBytesCountWithPadding = getRowSizeWithPadding(inputRowBytesCountWithoutPadding);
     uint64_t outputRowBytesCountWithPadding = getRowSizeWithPadding(outputRowBytesCountWithoutPadding);
 
-    uint64_t paddingBytes = inputRowBytesCountWithPadding - inputRowBytesCountWithoutPadding;
-
-    std::unique_ptr<uint8_t[]> inputRow = std::make_unique<uint8_t[]>(inputRowBytesCountWithPadding);
-    std::unique_ptr<uint8_t[]> outputRow = std::make_unique<uint8_t[]>(outputRowBytesCountWithPadding);
-
     bitmapOutputFileHeader.bfSize = sizeof(BitmapFileHeader) + sizeof(BitmapInfoHeaderV3) + outputRowBytesCountWithPadding * outputHeight;
     bitmapOutputFileHeader.bfOffBits = sizeof(BitmapFileHeader) + sizeof(BitmapInfoHeaderV3);
-    outputStream.write((char*)&bitmapOutputFileHeader, sizeof(BitmapFileHeader));
 
     bitmapOutputInfoHeader.biWidth = outputWidthPx;
     bitmapOutputInfoHeader.biHeight = outputHeight;
@@ -94,70 +78,68 @@ int main(int argc, char** argv) {
     uint64_t kernelHeight = kernelVertical;
     uint64_t kernelWidth = kernelHorizontal;
 
-    ImageRowsRingBuffer<Bitmap24Pixel> ringBuffer(kernelHeight, inputWidthPx, paddingBytes);
+    ImageRowsRingBuffer<Bitmap24Pixel> ringBuffer(kernelHeight, inputWidthPx);
 
     if (kernelWidth > inputWidthPx || kernelHeight > inputHeightPx) {
         cerr << "Filter size (" << kernelWidth << " x " << kernelHeight << ") is too big for this image ("
              << inputWidthPx << " x " << inputHeightPx << ")!" << endl;
         return 7;
     }
-    outputStream.write((char*)&bitmapOutputInfoHeader, sizeof(BitmapInfoHeaderV3));
-
-    for (int32_t i = 0; i < (kernelHeight + 2) / 2; i++) {
-        auto addRow = (char*)ringBuffer.pushNewRowAndGetPtr();
-        inputStream.read(addRow, inputRowBytesCountWithoutPadding);
-        inputStream.seekg(paddingBytes, ios_base::cur);
-        ringBuffer.applyHorizontalKernelToLastRow(kernelWidth);
-        if (inputStream.fail()) {
-            cerr << "Error reading source image!" << endl;
-            return 8;
-        }
-        if (i == 0 || (kernelHeight % 2 == 0 && (i == kernelHeight / 2))) {
-            continue;
-        }
-        memcpy((char*)ringBuffer.getRow(kernelHeight - 2 * i - 1), addRow, outputRowBytesCountWithoutPadding);
+
+    std::unique_ptr<MappedBitmapWriter> output;
+    try {
+        output = std::make_unique<MappedBitmapWriter>(argv[2], bitmapOutputFileHeader, bitmapOutputInfoHeader,
+                                                      outputWidthPx, outputHeight);
+    } catch (const std::exception& exception) {
+        cerr << exception.what() << endl;
+        return 2;
     }
-    ringBuffer.updateFullColsBuffer();
 
+    AsyncBitmapRowReader inputRows(*input, getDefaultRowQueueLength(input->getRowBytesCountWithPadding()));
+    AsyncBitmapRowWriter outputRows(*output, getDefaultRowQueueLength(outputRowBytesCountWithPadding));
+
+    // Reader and writer stages rethrow the errors of their threads
+    try {
+        for (int32_t i = 0; i < (kernelHeight + 2) / 2; i++) {
+            auto addRow = (char*)ringBuffer.pushNewRowAndGetPtr();
+            inputRows.readRow(addRow, inputRowBytesCountWithoutPadding);
+            ringBuffer.applyHorizontalKernelToLastRow(kernelWidth);
+            if (i == 0 || (kernelHeight % 2 == 0 && (i == kernelHeight / 2))) {
+                continue;
+            }
+            memcpy((char*)ringBuffer.getRow(kernelHeight - 2 * i - 1), addRow, outputRowBytesCountWithoutPadding);
+        }
+        ringBuffer.updateFullColsBuffer();
 
 
-    Bitmap24Pixel* newRow;
-    for (int32_t i = 0; i < inputHeightPx - (kernelHeight + 2) / 2; i++) {
-        newRow = ringBuffer.applyVerticalKernel(kernelHeight);
 
-        outputStream.write((char*)newRow, outputRowBytesCountWithPadding);
-        if (outputStream.fail()) {
-            cerr << "Error writing to file!" << endl;
-            return 10;
-        }
+        Bitmap24Pixel* newRow;
+        for (int32_t i = 0; i < inputHeightPx - (kernelHeight + 2) / 2; i++) {
+            newRow = ringBuffer.applyVerticalKernel(kernelHeight);
 
-        ringBuffer.updateSumColsBufferByRow(0, -1);
-        inputStream.read((char*)ringBuffer.pushNewRowAndGetPtr(), inputRowBytesCountWithoutPadding);
-        inputStream.seekg(paddingBytes, ios_base::cur);
-        if (inputStream.fail()) {
-            cerr << "Error reading source image!" << endl;
-            return 11;
+            outputRows.writeRow(newRow, outputRowBytesCountWithoutPadding);
+
+            ringBuffer.updateSumColsBufferByRow(0, -1);
+            inputRows.readRow((char*)ringBuffer.pushNewRowAndGetPtr(), inputRowBytesCountWithoutPadding);
+            ringBuffer.applyHorizontalKernelToLastRow(kernelWidth);
+            ringBuffer.updateSumColsBufferByRow(kernelHeight - 1, 1);
         }
-        ringBuffer.applyHorizontalKernelToLastRow(kernelWidth);
-        ringBuffer.updateSumColsBufferByRow(kernelHeight - 1, 1);
-    }
 
-    for (int32_t i = 0; i < (kernelHeight + 2) / 2; i++) {
-        newRow = ringBuffer.applyVerticalKernel(kernelHeight);
-        outputStream.write((char*)newRow, outputRowBytesCountWithPadding);
-        if (outputStream.fail()) {
-            cerr << "Error writing to file!" << endl;
-            return 12;
+        for (int32_t i = 0; i < (kernelHeight + 2) / 2; i++) {
+            newRow = ringBuffer.applyVerticalKernel(kernelHeight);
+            outputRows.writeRow(newRow, outputRowBytesCountWithoutPadding);
+            auto addRow = (char*)ringBuffer.pushNewRowAndGetPtr();
+            ringBuffer.updateSumColsBufferByRow(kernelHeight - 1, -1);
+            memcpy(addRow, (char*)ringBuffer.getRow(kernelHeight - 2 * i), outputRowBytesCountWithoutPadding);
+            ringBuffer.updateSumColsBufferByRow(kernelHeight - 2 * i, 1);
         }
-        auto addRow = (char*)ringBuffer.pushNewRowAndGetPtr();
-        ringBuffer.updateSumColsBufferByRow(kernelHeight - 1, -1);
-        memcpy(addRow, (char*)ringBuffer.getRow(kernelHeight - 2 * i), outputRowBytesCountWithoutPadding);
-        ringBuffer.updateSumColsBufferByRow(kernelHeight - 2 * i, 1);
-    }
 
+        outputRows.finish();
+    } catch (const std::exception& exception) {
+        cerr << exception.what() << endl;
+        return 10;
+    }
 
-    outputStream.close();
-    inputStream.close();
     cout << "Success!" << endl;
     return 0;
 }
@@ -0,0 +1,91 @@
+#ifndef COHERENCYBOXCARFILTER_H
+#define COHERENCYBOXCARFILTER_H
+
+#include <cstdint>
+#include <cstring>
+#include "coherencyfilter.h"
+#include "imagerowsringbuffer.h"
+#include "pixel.h"
+#include "t_matrix.h"
+
+// windowSize x windowSize boxcar mean of the six coherency matrix channels, a filter of coherencyfilter.h.
+// All channels of a pixel are stored together, so every pass of the filter is one sweep over the rows.
+class CoherencyBoxcarFilter {
+private:
+    int64_t begin;
+    int64_t width;
+    int64_t kernelWidth;
+    int64_t kernelHeight;
+    int64_t inputRowsCount;
+    int64_t tailRowsCount;
+
+    ImageRowsRingBuffer<CoherencyMatrixPixel, CoherencyMatrixStatistics> ringBuffer;
+
+    void copyRow(int64_t sourceRow, int64_t destinationRow) {
+        memcpy(ringBuffer.getRow(destinationRow), ringBuffer.getRow(sourceRow), width * sizeof(CoherencyMatrixPixel));
+    }
+
+    // Pushes coherency matrices of the input row filtered horizontally
+    void pushInputRow(const PolarimetricRowViews& input) {
+        CoherencyMatrixPixel* row = ringBuffer.pushNewRowAndGetPtr();
+        for (int64_t j = 0; j < width; j++) {
+            row[j] = getCoherencyMatrixPixel(input, begin + j);
+        }
+        ringBuffer.applyHorizontalKernelToLastRow(kernelWidth);
+    }
+
+    // Coherency matrices of the window sums, output[j] is the column begin + outputBegin + j
+    void getOutputRow(int64_t outputBegin, int64_t outputEnd, TMatrix* output) const {
+        const CoherencyMatrixPixel* row = ringBuffer.applyVerticalKernel(kernelHeight);
+        for (int64_t j = outputBegin; j < outputEnd; j++) {
+            output[j - outputBegin] = getTMatrix(row[j]);
+        }
+    }
+
+public:
+    CoherencyBoxcarFilter(int64_t begin, int64_t end, const CoherencyFilterParameters& parameters)
+        : begin(begin), width(end - begin), kernelWidth(parameters.windowSize), kernelHeight(parameters.windowSize),
+          inputRowsCount(0), tailRowsCount(0), ringBuffer(kernelHeight, width, 0) {
+    }
+
+    static int64_t getDelayRowsCount(int64_t windowSize) {
+        return (windowSize + 2) / 2;
+    }
+
+    // The output row is taken from the window sums before the input row is pushed
+    bool processInputRow(const PolarimetricRowViews& input, int64_t outputBegin, int64_t outputEnd, TMatrix* output) {
+        int64_t delayRowsCount = getDelayRowsCount(kernelHeight);
+        if (inputRowsCount < delayRowsCount) {
+            pushInputRow(input);
+            // The first rows are mirrored to the top of the window: row i to the position kernelHeight - 2 * i - 1
+            int64_t i = inputRowsCount++;
+            if (i != 0 && !(kernelHeight % 2 == 0 && i == kernelHeight / 2)) {
+                copyRow(kernelHeight - 1, kernelHeight - 2 * i - 1);
+            }
+            if (inputRowsCount == delayRowsCount) {
+                ringBuffer.updateFullColsBuffer();
+            }
+            return false;
+        }
+
+        getOutputRow(outputBegin, outputEnd, output);
+        ringBuffer.updateSumColsBufferByRow(0, -1);
+        pushInputRow(input);
+        ringBuffer.updateSumColsBufferByRow(kernelHeight - 1, 1);
+        inputRowsCount++;
+        return true;
+    }
+
+    // Writes the next of the last getDelayRowsCount() output rows, the last rows of the window are mirrored
+    void processTailRow(int64_t outputBegin, int64_t outputEnd, TMatrix* output) {
+        getOutputRow(outputBegin, outputEnd, output);
+
+        int64_t i = tailRowsCount++;
+        ringBuffer.pushNewRowAndGetPtr();
+        ringBuffer.updateSumColsBufferByRow(kernelHeight - 1, -1);
+        copyRow(kernelHeight - 2 * i, kernelHeight - 1);
+        ringBuffer.updateSumColsBufferByRow(kernelHeight - 2 * i, 1);
+    }
+};
+
+#endif // COHERENCYBOXCARFILTER_H
@@ -0,0 +1,83 @@
+#ifndef COHERENCYFILTER_H
+#define COHERENCYFILTER_H
+
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <string>
+#include "imageutils.h"
+#include "pixel.h"
+#include "t_matrix.h"
+#include "tiff.h"
+
+// Speckle filters of the coherency matrix. Every filter streams rows through a window of windowSize rows of its
+// column range and has the same interface:
+//   Filter(begin, end, parameters) filters the columns [begin, end) of the image
+//   static int64_t getDelayRowsCount(windowSize): output row n is ready after input row n + delay
+//   bool processInputRow(input, outputBegin, outputEnd, output): takes the next input row, returns true if
+//       the output row inputRowsCount - delay was written for the columns [outputBegin, outputEnd) relative to begin
+//   void processTailRow(outputBegin, outputEnd, output): writes the next of the last delay rows after the input end
+// Columns are mirrored at the borders of the range, so a range inside the image has to include windowSize / 2
+// extra columns on both sides, filtered values of these columns are not correct.
+enum class CoherencyFilterType : uint8_t {
+    Boxcar,
+    RefinedLee,
+    Idan
+};
+
+struct CoherencyFilterParameters {
+    CoherencyFilterType type;
+    int64_t windowSize;
+    // Equivalent number of looks of the input, speckle of the intensities has the relative variance 1 / looksCount
+    double looksCount;
+};
+
+inline const char* getCoherencyFilterTypeName(CoherencyFilterType type) {
+    switch (type) {
+    case CoherencyFilterType::RefinedLee:
+        return "refined Lee";
+    case CoherencyFilterType::Idan:
+        return "IDAN";
+    default:
+        return "boxcar";
+    }
+}
+
+// Rows of the four polarisations of the same image row
+struct PolarimetricRowViews {
+    const Tiff16ComplexPixel* hh;
+    const Tiff16ComplexPixel* hv;
+    const Tiff16ComplexPixel* vh;
+    const Tiff16ComplexPixel* vv;
+};
+
+// Single-look coherency matrix of the Pauli scattering vector of the pixel j
+inline CoherencyMatrixPixel getCoherencyMatrixPixel(const PolarimetricRowViews& input, int64_t j) {
+    const double sqrt2 = std::sqrt(2.0);
+    std::complex<double> SHH = std::complex<double>(input.hh[j].real, input.hh[j].imag);
+    std::complex<double> SVV = std::complex<double>(input.vv[j].real, input.vv[j].imag);
+    std::complex<double> SHV = std::complex<double>(input.hv[j].real, input.hv[j].imag);
+    std::complex<double> SVH = std::complex<double>(input.vh[j].real, input.vh[j].imag);
+
+    auto S_alpha = divideComplexByReal(SHH + SVV, sqrt2);
+    auto S_beta = divideComplexByReal(SHH - SVV, sqrt2);
+    auto S_gamma = divideComplexByReal(SHV + SVH, sqrt2);
+    std::complex<double> E01 = S_alpha * std::conj(S_beta);
+    std::complex<double> E02 = S_alpha * std::conj(S_gamma);
+    std::complex<double> E12 = S_beta * std::conj(S_gamma);
+
+    return {complexSquare(S_alpha), complexSquare(S_beta), complexSquare(S_gamma), E01.real(), E01.imag(),
+            E02.real(), E02.imag(), E12.real(), E12.imag()};
+}
+
+inline TMatrix getTMatrix(const CoherencyMatrixPixel& pixel) {
+    return {pixel.e00, pixel.e11, pixel.e22, {pixel.e01Real, pixel.e01Imag}, {pixel.e02Real, pixel.e02Imag},
+            {pixel.e12Real, pixel.e12Imag}};
+}
+
+// Total power
+inline double getSpan(const CoherencyMatrixPixel& pixel) {
+    return pixel.e00 + pixel.e11 + pixel.e22;
+}
+
+#endif // COHERENCYFILTER_H
@@ -0,0 +1,143 @@
+#ifndef COHERENCYWINDOWFILTER_H
+#define COHERENCYWINDOWFILTER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "coherencyfilter.h"
+#include "pixel.h"
+#include "t_matrix.h"
+
+constexpr double CoherencyMatrixPixel::* COHERENCY_MATRIX_FIELDS[] = {
+    &CoherencyMatrixPixel::e00, &CoherencyMatrixPixel::e11, &CoherencyMatrixPixel::e22,
+    &CoherencyMatrixPixel::e01Real, &CoherencyMatrixPixel::e01Imag, &CoherencyMatrixPixel::e02Real,
+    &CoherencyMatrixPixel::e02Imag, &CoherencyMatrixPixel::e12Real, &CoherencyMatrixPixel::e12Imag};
+
+// windowSize x windowSize single-look coherency matrices around a pixel of the output row,
+// rows and columns outside of the image or the filtered range are mirrored
+class CoherencyWindow {
+private:
+    const CoherencyMatrixPixel* const* rows;
+    int64_t half;
+    int64_t width;
+
+public:
+    CoherencyWindow(const CoherencyMatrixPixel* const* rows, int64_t half, int64_t width)
+        : rows(rows), half(half), width(width) {
+    }
+
+    int64_t getHalf() const {
+        return half;
+    }
+
+    // Pixel of the column col of the row dy relative to the output row, dy in [-half, half]
+    const CoherencyMatrixPixel& getPixel(int64_t dy, int64_t col) const {
+        if (col < 0) {
+            col = -col;
+        } else if (col >= width) {
+            col = 2 * width - 2 - col;
+        }
+        return rows[dy + half][col];
+    }
+};
+
+// Sums of the pixels of a neighbourhood for the local linear minimum mean square error estimate
+struct CoherencyNeighbourhoodSums {
+    CoherencyMatrixStatistics matrixSums;
+    double spanSum = 0;
+    double spanSquareSum = 0;
+    int64_t count = 0;
+
+    void add(const CoherencyMatrixPixel& pixel) {
+        PixelStatisticsTraits<CoherencyMatrixStatistics>::add(matrixSums, pixel);
+        double span = getSpan(pixel);
+        spanSum += span;
+        spanSquareSum += span * span;
+        count++;
+    }
+};
+
+// T = mean + b (T_center - mean): b is the part of the span variance of the neighbourhood that is not explained
+// by speckle with the relative variance noiseVariance (Lee's local statistics filter applied to all matrix elements)
+inline CoherencyMatrixPixel getLlmmseEstimate(const CoherencyNeighbourhoodSums& sums, const CoherencyMatrixPixel& center,
+                                              double noiseVariance) {
+    CoherencyMatrixPixel mean = PixelStatisticsTraits<CoherencyMatrixStatistics>::normalize(sums.matrixSums, sums.count);
+    double spanMean = sums.spanSum / sums.count;
+    double spanVariance = sums.spanSquareSum / sums.count - spanMean * spanMean;
+    double weight = 0;
+    if (spanVariance > 0) {
+        double signalVariance = (spanVariance - spanMean * spanMean * noiseVariance) / (1 + noiseVariance);
+        weight = std::clamp(signalVariance / spanVariance, 0.0, 1.0);
+    }
+
+    CoherencyMatrixPixel result;
+    for (double CoherencyMatrixPixel::* field : COHERENCY_MATRIX_FIELDS) {
+        result.*field = mean.*field + weight * (center.*field - mean.*field);
+    }
+    return result;
+}
+
+// Filter of coherencyfilter.h that keeps the last windowSize single-look rows and computes every output pixel
+// from its whole window: Estimator(parameters) provides estimate(window, col), the filtered pixel of the column col
+template <typename Estimator>
+class CoherencyWindowFilter {
+private:
+    int64_t begin;
+    int64_t width;
+    int64_t windowSize;
+    int64_t half;
+    int64_t inputRowsCount;
+    int64_t tailRowsCount;
+    std::vector<CoherencyMatrixPixel> rows;
+    std::vector<const CoherencyMatrixPixel*> windowRows;
+    Estimator estimator;
+
+    // Rows are mirrored at the top and, when height is known after the input end, at the bottom
+    void filterRow(int64_t outputRow, int64_t height, int64_t outputBegin, int64_t outputEnd, TMatrix* output) {
+        for (int64_t dy = -half; dy <= half; dy++) {
+            int64_t row = outputRow + dy;
+            if (row < 0) {
+                row = -row;
+            } else if (row >= height) {
+                row = 2 * height - 2 - row;
+            }
+            windowRows[dy + half] = rows.data() + (row % windowSize) * width;
+        }
+
+        CoherencyWindow window(windowRows.data(), half, width);
+        for (int64_t j = outputBegin; j < outputEnd; j++) {
+            output[j - outputBegin] = getTMatrix(estimator.estimate(window, j));
+        }
+    }
+
+public:
+    CoherencyWindowFilter(int64_t begin, int64_t end, const CoherencyFilterParameters& parameters)
+        : begin(begin), width(end - begin), windowSize(parameters.windowSize), half(parameters.windowSize / 2),
+          inputRowsCount(0), tailRowsCount(0), rows(parameters.windowSize * (end - begin)), windowRows(parameters.windowSize),
+          estimator(parameters) {
+    }
+
+    static int64_t getDelayRowsCount(int64_t windowSize) {
+        return windowSize / 2;
+    }
+
+    // The output row is filtered after the input row is stored
+    bool processInputRow(const PolarimetricRowViews& input, int64_t outputBegin, int64_t outputEnd, TMatrix* output) {
+        CoherencyMatrixPixel* row = rows.data() + (inputRowsCount % windowSize) * width;
+        for (int64_t j = 0; j < width; j++) {
+            row[j] = getCoherencyMatrixPixel(input, begin + j);
+        }
+        int64_t inputRow = inputRowsCount++;
+        if (inputRow < half) {
+            return false;
+        }
+        filterRow(inputRow - half, INT64_MAX, outputBegin, outputEnd, output);
+        return true;
+    }
+
+    void processTailRow(int64_t outputBegin, int64_t outputEnd, TMatrix* output) {
+        filterRow(inputRowsCount - half + tailRowsCount++, inputRowsCount, outputBegin, outputEnd, output);
+    }
+};
+
+#endif // COHERENCYWINDOWFILTER_H
@@ -0,0 +1,316 @@
+#ifndef HAALPHAPIPELINE_H
+#define HAALPHAPIPELINE_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "bitmap.h"
+#include "coherencyboxcarfilter.h"
+#include "coherencyfilter.h"
+#include "idanfilter.h"
+#include "imageutils.h"
+#include "refinedleefilter.h"
+#include "t_matrix.h"
+#include "tiff.h"
+#include "tmatrixbatch.h"
+
+// Input rows are processed in batches of PIPELINE_BATCH_ROWS_COUNT rows: while the workers filter one batch,
+// the calling thread reads the next one and writes the output rows of the previous one
+constexpr int64_t PIPELINE_BATCH_ROWS_COUNT = 8;
+
+// Columns of a band besides the halo, narrower bands spend more time on the halo than on the image
+constexpr int64_t PIPELINE_MIN_BAND_WIDTH = 64;
+
+inline uint64_t getDefaultHAAlphaThreadsCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Bands, and so worker threads, of HAAlphaPipeline for the image width
+inline uint64_t getHAAlphaBandsCount(int64_t width, uint64_t threadsCount) {
+    return std::clamp<int64_t>(threadsCount, 1, std::max<int64_t>(width / PIPELINE_MIN_BAND_WIDTH, 1));
+}
+
+// H / A / alpha of the coherency matrices filtered by Filter of coherencyfilter.h. The image is split into vertical bands,
+// every worker thread owns one band with its own filter (band columns and windowSize / 2 halo columns on both sides)
+// and computes the eigen decomposition of its columns, so workers are independent within a batch and meet once
+// per batch. Memory is two input and two output batches and the row windows of the bands: O((batch + windowSize) x width).
+template <typename Filter>
+class HAAlphaPipeline {
+private:
+    struct Band {
+        int64_t begin;
+        int64_t end;
+        int64_t haloBegin;
+        std::unique_ptr<Filter> filter;
+        TMatrixRow tMatrixRow;
+        std::vector<double> entropy;
+        std::vector<double> anisotropy;
+        std::vector<double> alpha;
+
+        Band(int64_t begin, int64_t end, int64_t haloBegin, int64_t haloEnd, const CoherencyFilterParameters& parameters)
+            : begin(begin), end(end), haloBegin(haloBegin), filter(std::make_unique<Filter>(haloBegin, haloEnd, parameters)),
+              tMatrixRow(end - begin), entropy(end - begin), anisotropy(end - begin), alpha(end - begin) {
+        }
+    };
+
+    struct InputBatch {
+        int64_t rowBegin;
+        int64_t rowEnd;
+        std::vector<Tiff16ComplexPixel> hh;
+        std::vector<Tiff16ComplexPixel> hv;
+        std::vector<Tiff16ComplexPixel> vh;
+        std::vector<Tiff16ComplexPixel> vv;
+    };
+
+    struct OutputBatch {
+        int64_t rowBegin;
+        int64_t rowEnd;
+        std::vector<Bitmap24Pixel> pixels;
+        std::vector<TMatrix> tMatrices;
+    };
+
+    int64_t width;
+    int64_t height;
+    int64_t delayRowsCount;
+    int64_t batchesCount;
+    std::vector<Band> bands;
+    InputBatch inputBatches[2];
+    OutputBatch outputBatches[2];
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable batchStarted;
+    std::condition_variable batchFinished;
+    int64_t startedBatch;
+    uint64_t finishedBandsCount;
+    bool isStopped;
+    std::exception_ptr error;
+
+    // Output rows of a batch are the rows whose last input row is in it, the last batch also has the tail rows
+    OutputBatch& getOutputBatch(int64_t outputRow) {
+        int64_t batch = std::min((outputRow + delayRowsCount) / PIPELINE_BATCH_ROWS_COUNT, batchesCount - 1);
+        return outputBatches[batch % 2];
+    }
+
+    TMatrix* getOutputTMatrices(const Band& band, int64_t outputRow) {
+        OutputBatch& output = getOutputBatch(outputRow);
+        return output.tMatrices.data() + (outputRow - output.rowBegin) * width + band.begin;
+    }
+
+    // Filtered row of the band to H / A / alpha pixels
+    void computeBandRow(Band& band, int64_t outputRow) {
+        OutputBatch& output = getOutputBatch(outputRow);
+        int64_t offset = (outputRow - output.rowBegin) * width;
+        const TMatrix* tMatrices = output.tMatrices.data() + offset;
+        for (int64_t j = band.begin; j < band.end; j++) {
+            band.tMatrixRow.set(j - band.begin, tMatrices[j]);
+        }
+        int64_t count = band.end - band.begin;
+        computeHAAlphaRow(band.tMatrixRow, count, band.entropy.data(), band.anisotropy.data(), band.alpha.data());
+        Bitmap24Pixel* pixels = output.pixels.data() + offset;
+        for (int64_t j = 0; j < count; j++) {
+            Bitmap24Pixel& pixel = pixels[band.begin + j];
+            pixel.green = getValueInInterval(band.entropy[j], 0.0, 1.0, 255);
+            pixel.blue = getValueInInterval(band.anisotropy[j], 0.0, 1.0, 255);
+            pixel.red = getValueInInterval(band.alpha[j], 0.0, M_PI_2, 255);
+        }
+    }
+
+    void processBatch(Band& band, int64_t batch) {
+        const InputBatch& input = inputBatches[batch % 2];
+        int64_t outputBegin = band.begin - band.haloBegin;
+        int64_t outputEnd = band.end - band.haloBegin;
+        for (int64_t row = input.rowBegin; row < input.rowEnd; row++) {
+            int64_t offset = (row - input.rowBegin) * width;
+            PolarimetricRowViews views = {input.hh.data() + offset, input.hv.data() + offset, input.vh.data() + offset,
+                                          input.vv.data() + offset};
+            int64_t outputRow = row - delayRowsCount;
+            TMatrix* output = outputRow >= 0 ? getOutputTMatrices(band, outputRow) : nullptr;
+            if (band.filter->processInputRow(views, outputBegin, outputEnd, output)) {
+                computeBandRow(band, outputRow);
+            }
+        }
+        if (batch == batchesCount - 1) {
+            for (int64_t outputRow = std::max<int64_t>(height - delayRowsCount, 0); outputRow < height; outputRow++) {
+                band.filter->processTailRow(outputBegin, outputEnd, getOutputTMatrices(band, outputRow));
+                computeBandRow(band, outputRow);
+            }
+        }
+    }
+
+    void runWorker(Band& band) {
+        for (int64_t batch = 0; batch < batchesCount; batch++) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                batchStarted.wait(lock, [&]() { return startedBatch >= batch || isStopped; });
+                if (isStopped) {
+                    return;
+                }
+            }
+            try {
+                processBatch(band, batch);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                finishedBandsCount++;
+            }
+            batchFinished.notify_all();
+        }
+    }
+
+    void startBatch(int64_t batch) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            finishedBandsCount = 0;
+            startedBatch = batch;
+        }
+        batchStarted.notify_all();
+    }
+
+    void waitBatch() {
+        std::unique_lock<std::mutex> lock(mutex);
+        batchFinished.wait(lock, [this]() { return finishedBandsCount == bands.size(); });
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    void setBatchRows(int64_t batch) {
+        InputBatch& input = inputBatches[batch % 2];
+        input.rowBegin = batch * PIPELINE_BATCH_ROWS_COUNT;
+        input.rowEnd = std::min(input.rowBegin + PIPELINE_BATCH_ROWS_COUNT, height);
+        OutputBatch& output = outputBatches[batch % 2];
+        output.rowBegin = std::max<int64_t>(input.rowBegin - delayRowsCount, 0);
+        output.rowEnd = batch == batchesCount - 1 ? height : std::max<int64_t>(input.rowEnd - delayRowsCount, 0);
+    }
+
+public:
+    HAAlphaPipeline(int64_t width, int64_t height, const CoherencyFilterParameters& parameters, uint64_t threadsCount)
+        : width(width), height(height), startedBatch(-1), finishedBandsCount(0), isStopped(false) {
+        delayRowsCount = Filter::getDelayRowsCount(parameters.windowSize);
+        // Mirroring at the borders needs the whole window inside the image
+        if (height < parameters.windowSize || width < parameters.windowSize) {
+            throw std::invalid_argument("Image is smaller than the filter window!");
+        }
+        batchesCount = divideWithCeil<int64_t>(height, PIPELINE_BATCH_ROWS_COUNT);
+
+        int64_t bandsCount = getHAAlphaBandsCount(width, threadsCount);
+        int64_t halo = parameters.windowSize / 2;
+        bands.reserve(bandsCount);
+        for (int64_t b = 0; b < bandsCount; b++) {
+            int64_t begin = width * b / bandsCount;
+            int64_t end = width * (b + 1) / bandsCount;
+            bands.emplace_back(begin, end, std::max<int64_t>(begin - halo, 0), std::min(end + halo, width), parameters);
+        }
+
+        for (int64_t i = 0; i < 2; i++) {
+            inputBatches[i].hh.resize(PIPELINE_BATCH_ROWS_COUNT * width);
+            inputBatches[i].hv.resize(PIPELINE_BATCH_ROWS_COUNT * width);
+            inputBatches[i].vh.resize(PIPELINE_BATCH_ROWS_COUNT * width);
+            inputBatches[i].vv.resize(PIPELINE_BATCH_ROWS_COUNT * width);
+            outputBatches[i].pixels.resize((PIPELINE_BATCH_ROWS_COUNT + delayRowsCount) * width);
+            outputBatches[i].tMatrices.resize((PIPELINE_BATCH_ROWS_COUNT + delayRowsCount) * width);
+        }
+    }
+
+    HAAlphaPipeline(const HAAlphaPipeline&) = delete;
+    HAAlphaPipeline& operator=(const HAAlphaPipeline&) = delete;
+
+    ~HAAlphaPipeline() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            isStopped = true;
+        }
+        batchStarted.notify_all();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    // readRow(row, hh, hv, vh, vv) copies the input row to the four buffers of width pixels,
+    // writeRow(row, pixels, tMatrices) gets output rows in order. Both are called from the calling thread,
+    // the first exception stops the pipeline and is rethrown.
+    template <typename ReadFunction, typename WriteFunction>
+    void run(ReadFunction readRow, WriteFunction writeRow) {
+        auto readBatch = [&](int64_t batch) {
+            setBatchRows(batch);
+            InputBatch& input = inputBatches[batch % 2];
+            for (int64_t row = input.rowBegin; row < input.rowEnd; row++) {
+                int64_t offset = (row - input.rowBegin) * width;
+                readRow(row, input.hh.data() + offset, input.hv.data() + offset, input.vh.data() + offset, input.vv.data() + offset);
+            }
+        };
+        auto writeBatch = [&](int64_t batch) {
+            const OutputBatch& output = outputBatches[batch % 2];
+            for (int64_t row = output.rowBegin; row < output.rowEnd; row++) {
+                int64_t offset = (row - output.rowBegin) * width;
+                writeRow(row, output.pixels.data() + offset, output.tMatrices.data() + offset);
+            }
+        };
+
+        for (Band& band : bands) {
+            threads.emplace_back([this, &band]() { runWorker(band); });
+        }
+
+        readBatch(0);
+        for (int64_t batch = 0; batch < batchesCount; batch++) {
+            startBatch(batch);
+            if (batch > 0) {
+                writeBatch(batch - 1);
+            }
+            if (batch + 1 < batchesCount) {
+                readBatch(batch + 1);
+            }
+            waitBatch();
+        }
+        writeBatch(batchesCount - 1);
+    }
+};
+
+// Output row n of the filter is written after input row n + delay
+inline int64_t getCoherencyFilterDelayRowsCount(const CoherencyFilterParameters& parameters) {
+    switch (parameters.type) {
+    case CoherencyFilterType::RefinedLee:
+        return RefinedLeeFilter::getDelayRowsCount(parameters.windowSize);
+    case CoherencyFilterType::Idan:
+        return IdanFilter::getDelayRowsCount(parameters.windowSize);
+    default:
+        return CoherencyBoxcarFilter::getDelayRowsCount(parameters.windowSize);
+    }
+}
+
+// Runs HAAlphaPipeline with the filter of parameters.type
+template <typename ReadFunction, typename WriteFunction>
+void runHAAlphaPipeline(int64_t width, int64_t height, const CoherencyFilterParameters& parameters, uint64_t threadsCount,
+                        ReadFunction readRow, WriteFunction writeRow) {
+    switch (parameters.type) {
+    case CoherencyFilterType::RefinedLee: {
+        HAAlphaPipeline<RefinedLeeFilter> pipeline(width, height, parameters, threadsCount);
+        pipeline.run(readRow, writeRow);
+        break;
+    }
+    case CoherencyFilterType::Idan: {
+        HAAlphaPipeline<IdanFilter> pipeline(width, height, parameters, threadsCount);
+        pipeline.run(readRow, writeRow);
+        break;
+    }
+    default: {
+        HAAlphaPipeline<CoherencyBoxcarFilter> pipeline(width, height, parameters, threadsCount);
+        pipeline.run(readRow, writeRow);
+        break;
+    }
+    }
+}
+
+#endif // HAALPHAPIPELINE_H
@@ -0,0 +1,128 @@
+#ifndef IDANFILTER_H
+#define IDANFILTER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "coherencyfilter.h"
+#include "coherencywindowfilter.h"
+#include "pixel.h"
+
+// Intensity-driven adaptive-neighbourhood filter (Vasile et al., 2006). The neighbourhood grows from the pixel
+// through 4-connected pixels whose diagonal elements are close to the seed, the 3 x 3 median of the diagonal elements.
+// Pixels rejected by the growth are tested again against the mean of the grown region with a wider tolerance.
+// Neighbourhoods are confined to the window, the pixel is the local statistics estimate over its neighbourhood.
+class IdanEstimator {
+private:
+    // Tolerances of the sum of absolute differences of the diagonal elements relative to the sum of the reference
+    // diagonal elements, in standard deviations of speckle
+    static constexpr double GROWTH_TOLERANCE = 2;
+    static constexpr double BACKGROUND_TOLERANCE = 3;
+
+    enum PixelState : uint8_t {
+        NOT_TESTED,
+        IN_REGION,
+        REJECTED
+    };
+
+    int64_t half;
+    int64_t windowSize;
+    double noiseVariance;
+    double noiseDeviation;
+    std::vector<uint8_t> states;
+    std::vector<int64_t> region;
+    std::vector<int64_t> rejected;
+
+    static double getDistance(const CoherencyMatrixPixel& pixel, const double reference[3]) {
+        return std::abs(pixel.e00 - reference[0]) + std::abs(pixel.e11 - reference[1]) + std::abs(pixel.e22 - reference[2]);
+    }
+
+public:
+    explicit IdanEstimator(const CoherencyFilterParameters& parameters)
+        : half(parameters.windowSize / 2), windowSize(parameters.windowSize), noiseVariance(1.0 / parameters.looksCount),
+          noiseDeviation(std::sqrt(noiseVariance)), states(parameters.windowSize * parameters.windowSize) {
+        region.reserve(states.size());
+        rejected.reserve(states.size());
+    }
+
+    CoherencyMatrixPixel estimate(const CoherencyWindow& window, int64_t col) {
+        double seed[3];
+        double values[3][9];
+        for (int64_t dy = -1; dy <= 1; dy++) {
+            for (int64_t dx = -1; dx <= 1; dx++) {
+                const CoherencyMatrixPixel& pixel = window.getPixel(dy, col + dx);
+                int64_t index = (dy + 1) * 3 + dx + 1;
+                values[0][index] = pixel.e00;
+                values[1][index] = pixel.e11;
+                values[2][index] = pixel.e22;
+            }
+        }
+        for (int64_t c = 0; c < 3; c++) {
+            std::nth_element(values[c], values[c] + 4, values[c] + 9);
+            seed[c] = values[c][4];
+        }
+
+        // Pixels are indexed (dy + half) * windowSize + dx + half
+        std::fill(states.begin(), states.end(), NOT_TESTED);
+        region.clear();
+        rejected.clear();
+        int64_t centerIndex = half * windowSize + half;
+        states[centerIndex] = IN_REGION;
+        region.push_back(centerIndex);
+
+        double growthLimit = GROWTH_TOLERANCE * noiseDeviation * (seed[0] + seed[1] + seed[2]);
+        const int64_t neighbourOffsets[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+        for (size_t next = 0; next < region.size(); next++) {
+            int64_t y = region[next] / windowSize;
+            int64_t x = region[next] % windowSize;
+            for (const auto& offset : neighbourOffsets) {
+                int64_t neighbourY = y + offset[0];
+                int64_t neighbourX = x + offset[1];
+                if (neighbourY < 0 || neighbourY >= windowSize || neighbourX < 0 || neighbourX >= windowSize) {
+                    continue;
+                }
+                int64_t index = neighbourY * windowSize + neighbourX;
+                if (states[index] != NOT_TESTED) {
+                    continue;
+                }
+                const CoherencyMatrixPixel& pixel = window.getPixel(neighbourY - half, col + neighbourX - half);
+                if (getDistance(pixel, seed) <= growthLimit) {
+                    states[index] = IN_REGION;
+                    region.push_back(index);
+                } else {
+                    states[index] = REJECTED;
+                    rejected.push_back(index);
+                }
+            }
+        }
+
+        double regionMean[3] = {0, 0, 0};
+        for (int64_t index : region) {
+            const CoherencyMatrixPixel& pixel = window.getPixel(index / windowSize - half, col + index % windowSize - half);
+            regionMean[0] += pixel.e00;
+            regionMean[1] += pixel.e11;
+            regionMean[2] += pixel.e22;
+        }
+        for (double& mean : regionMean) {
+            mean /= region.size();
+        }
+
+        CoherencyNeighbourhoodSums sums;
+        for (int64_t index : region) {
+            sums.add(window.getPixel(index / windowSize - half, col + index % windowSize - half));
+        }
+        double backgroundLimit = BACKGROUND_TOLERANCE * noiseDeviation * (regionMean[0] + regionMean[1] + regionMean[2]);
+        for (int64_t index : rejected) {
+            const CoherencyMatrixPixel& pixel = window.getPixel(index / windowSize - half, col + index % windowSize - half);
+            if (getDistance(pixel, regionMean) <= backgroundLimit) {
+                sums.add(pixel);
+            }
+        }
+        return getLlmmseEstimate(sums, window.getPixel(0, col), noiseVariance);
+    }
+};
+
+using IdanFilter = CoherencyWindowFilter<IdanEstimator>;
+
+#endif // IDANFILTER_H
@@ -52,8 +52,8 @@ public:
         widthBytes = cols * sizeof(T);
         length = rows;
         beginIndex = 0;
-        data = std::make_unique<T[]>(rows * widthBytes);
-        resultRow = std::make_unique<T[]>(widthBytes + padding);
+        data = std::make_unique<T[]>(rows * cols);
+        resultRow = std::make_unique<T[]>(cols + padding);
         sumColsBuffer = std::make_unique<PixelStatistics[]>(cols);
         for (int64_t i = 0; i < cols; i++) {
             PixelStatisticsTraits<PixelStatistics>::reset(sumColsBuffer[i]);
@@ -63,17 +63,17 @@ public:
     T* pushNewRowAndGetPtr() {
         uint32_t oldBeginIndex = beginIndex;
         beginIndex = (beginIndex + 1) % length;
-        return data.get() + oldBeginIndex * widthBytes;
+        return data.get() + oldBeginIndex * width;
     }
 
     T* getRow(uint64_t row) {
         uint64_t realRow = (beginIndex + row) % length;
-        return data.get() + realRow * widthBytes;
+        return data.get() + realRow * width;
     }
 
     const T* getRow(uint64_t row) const {
         uint64_t realRow = (beginIndex + row) % length;
-        return data.get() + realRow * widthBytes;
+        return data.get() + realRow * width;
     }
 
     const T getElem(uint64_t row, int64_t col) const {
@@ -122,15 +122,14 @@ public:
     }
 
     void updateSumColsBufferByRow(int64_t row, int8_t sign) {
+        const T* rowPtr = getRow(row);
         if (sign < 0) {
             for (int64_t i = 0; i < width; i++) {
-                auto currentPixel = getRow(row)[i];
-                PixelStatisticsTraits<PixelStatistics>::subtract(sumColsBuffer[i], currentPixel);
+                PixelStatisticsTraits<PixelStatistics>::subtract(sumColsBuffer[i], rowPtr[i]);
             }
         } else {
             for (int64_t i = 0; i < width; i++) {
-                auto currentPixel = getRow(row)[i];
-                PixelStatisticsTraits<PixelStatistics>::add(sumColsBuffer[i], currentPixel);
+                PixelStatisticsTraits<PixelStatistics>::add(sumColsBuffer[i], rowPtr[i]);
             }
         }
 
@@ -141,9 +140,9 @@ public:
             PixelStatisticsTraits<PixelStatistics>::reset(sumColsBuffer[i]);
         }
         for (int64_t j = 0; j < length; j++) {
+            const T* rowPtr = getRow(j);
             for (int64_t i = 0; i < width; i++) {
-                auto currentPixel = getRow(j)[i];
-                PixelStatisticsTraits<PixelStatistics>::add(sumColsBuffer[i], currentPixel);
+                PixelStatisticsTraits<PixelStatistics>::add(sumColsBuffer[i], rowPtr[i]);
             }
         }
     }
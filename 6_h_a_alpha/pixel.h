@@ -56,6 +56,23 @@ struct Complex16Pixel
 #pragma pack(pop)
 
 
+// Elements of the coherency matrix of one pixel, the six channels are filtered together in one ring buffer
+#pragma pack(push, 1)
+struct CoherencyMatrixPixel
+{
+    double e00;
+    double e11;
+    double e22;
+    double e01Real;
+    double e01Imag;
+    double e02Real;
+    double e02Imag;
+    double e12Real;
+    double e12Imag;
+};
+#pragma pack(pop)
+
+
 class RGB8Statistics {
 public:
     double red;
@@ -90,6 +107,24 @@ public:
 };
 
 
+class CoherencyMatrixStatistics {
+public:
+    double e00;
+    double e11;
+    double e22;
+    double e01Real;
+    double e01Imag;
+    double e02Real;
+    double e02Imag;
+    double e12Real;
+    double e12Imag;
+    CoherencyMatrixStatistics() {
+        e00 = e11 = e22 = 0;
+        e01Real = e01Imag = e02Real = e02Imag = e12Real = e12Imag = 0;
+    }
+};
+
+
 template <typename PixelStructure>
 class PixelStatisticsTraits {
 
@@ -171,3 +206,49 @@ public:
         );
     }
 };
+
+template <>
+class PixelStatisticsTraits<CoherencyMatrixStatistics> {
+public:
+    static void reset(CoherencyMatrixStatistics& pixel) {
+        pixel = CoherencyMatrixStatistics();
+    }
+
+    static void add(CoherencyMatrixStatistics& target, const CoherencyMatrixPixel& source) {
+        target.e00 += source.e00;
+        target.e11 += source.e11;
+        target.e22 += source.e22;
+        target.e01Real += source.e01Real;
+        target.e01Imag += source.e01Imag;
+        target.e02Real += source.e02Real;
+        target.e02Imag += source.e02Imag;
+        target.e12Real += source.e12Real;
+        target.e12Imag += source.e12Imag;
+    }
+
+    static void subtract(CoherencyMatrixStatistics& target, const CoherencyMatrixPixel& source) {
+        target.e00 -= source.e00;
+        target.e11 -= source.e11;
+        target.e22 -= source.e22;
+        target.e01Real -= source.e01Real;
+        target.e01Imag -= source.e01Imag;
+        target.e02Real -= source.e02Real;
+        target.e02Imag -= source.e02Imag;
+        target.e12Real -= source.e12Real;
+        target.e12Imag -= source.e12Imag;
+    }
+
+    static CoherencyMatrixPixel normalize(const CoherencyMatrixStatistics& pixel, int divisor) {
+        return {
+            pixel.e00 / divisor,
+            pixel.e11 / divisor,
+            pixel.e22 / divisor,
+            pixel.e01Real / divisor,
+            pixel.e01Imag / divisor,
+            pixel.e02Real / divisor,
+            pixel.e02Imag / divisor,
+            pixel.e12Real / divisor,
+            pixel.e12Imag / divisor
+        };
+    }
+};
@@ -0,0 +1,107 @@
+#ifndef REFINEDLEEFILTER_H
+#define REFINEDLEEFILTER_H
+
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "coherencyfilter.h"
+#include "coherencywindowfilter.h"
+#include "pixel.h"
+
+// Refined Lee filter (Lee, Grunes, de Grandi, 1999). The window is covered by 3 x 3 overlapping subwindows,
+// gradients of their mean spans in four directions give the direction of the edge through the window.
+// Pixels are averaged over the half of the window on the side of the edge that is closer to the center subwindow,
+// with the local statistics weight of the span.
+class RefinedLeeEstimator {
+private:
+    static constexpr int64_t DIRECTIONS_COUNT = 4;
+
+    int64_t half;
+    int64_t subwindowSize;
+    int64_t subwindowStep;
+    double noiseVariance;
+    // Offsets (dy, dx) of the half windows: [2 * direction] is on the negative side of the gradient, [2 * direction + 1]
+    // on the positive side, the pixels on the edge line belong to both
+    std::vector<std::pair<int64_t, int64_t>> directionalWindows[2 * DIRECTIONS_COUNT];
+
+    // Projections of (dy, dx) to the gradients of the directions 0, 45, 90 and 135 degrees from the row
+    static int64_t getProjection(int64_t direction, int64_t dy, int64_t dx) {
+        switch (direction) {
+        case 0:
+            return dx;
+        case 1:
+            return dx + dy;
+        case 2:
+            return dy;
+        default:
+            return dy - dx;
+        }
+    }
+
+public:
+    explicit RefinedLeeEstimator(const CoherencyFilterParameters& parameters)
+        : half(parameters.windowSize / 2), noiseVariance(1.0 / parameters.looksCount) {
+        // 3 for the 5 x 5, 7 x 7 and 9 x 9 windows, 5 for 11 x 11 and 13 x 13
+        subwindowSize = 2 * ((parameters.windowSize + 1) / 6) + 1;
+        subwindowStep = (parameters.windowSize - subwindowSize) / 2;
+        for (int64_t direction = 0; direction < DIRECTIONS_COUNT; direction++) {
+            for (int64_t dy = -half; dy <= half; dy++) {
+                for (int64_t dx = -half; dx <= half; dx++) {
+                    int64_t projection = getProjection(direction, dy, dx);
+                    if (projection <= 0) {
+                        directionalWindows[2 * direction].emplace_back(dy, dx);
+                    }
+                    if (projection >= 0) {
+                        directionalWindows[2 * direction + 1].emplace_back(dy, dx);
+                    }
+                }
+            }
+        }
+    }
+
+    CoherencyMatrixPixel estimate(const CoherencyWindow& window, int64_t col) {
+        // means[i][j] is the mean span of the subwindow with the center ((i - 1) * step, (j - 1) * step)
+        double means[3][3];
+        int64_t subwindowHalf = subwindowSize / 2;
+        for (int64_t i = 0; i < 3; i++) {
+            for (int64_t j = 0; j < 3; j++) {
+                double sum = 0;
+                for (int64_t dy = -subwindowHalf; dy <= subwindowHalf; dy++) {
+                    for (int64_t dx = -subwindowHalf; dx <= subwindowHalf; dx++) {
+                        sum += getSpan(window.getPixel((i - 1) * subwindowStep + dy, col + (j - 1) * subwindowStep + dx));
+                    }
+                }
+                means[i][j] = sum / (subwindowSize * subwindowSize);
+            }
+        }
+
+        // Gradients along the projections and the subwindows on their negative and positive sides
+        double gradients[DIRECTIONS_COUNT] = {
+            means[0][2] + means[1][2] + means[2][2] - means[0][0] - means[1][0] - means[2][0],
+            means[1][2] + means[2][2] + means[2][1] - means[0][1] - means[0][0] - means[1][0],
+            means[2][0] + means[2][1] + means[2][2] - means[0][0] - means[0][1] - means[0][2],
+            means[1][0] + means[2][0] + means[2][1] - means[0][1] - means[0][2] - means[1][2]};
+        double sides[DIRECTIONS_COUNT][2] = {
+            {means[1][0], means[1][2]}, {means[0][0], means[2][2]}, {means[0][1], means[2][1]}, {means[0][2], means[2][0]}};
+
+        int64_t direction = 0;
+        for (int64_t k = 1; k < DIRECTIONS_COUNT; k++) {
+            if (std::abs(gradients[k]) > std::abs(gradients[direction])) {
+                direction = k;
+            }
+        }
+        double center = means[1][1];
+        int64_t side = std::abs(sides[direction][1] - center) < std::abs(sides[direction][0] - center) ? 1 : 0;
+
+        CoherencyNeighbourhoodSums sums;
+        for (const auto& offset : directionalWindows[2 * direction + side]) {
+            sums.add(window.getPixel(offset.first, col + offset.second));
+        }
+        return getLlmmseEstimate(sums, window.getPixel(0, col), noiseVariance);
+    }
+};
+
+using RefinedLeeFilter = CoherencyWindowFilter<RefinedLeeEstimator>;
+
+#endif // REFINEDLEEFILTER_H
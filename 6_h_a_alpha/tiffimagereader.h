@@ -7,6 +7,11 @@
 #include <cmath>
 #include <fstream>
 #include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <condition_variable>
 #include "tiff.h"
 #include <stdexcept>
 #include <iostream>
@@ -29,18 +34,38 @@ static uint64_t getFieldSize(FieldType fieldType) {
     case FieldType::Rational:
     case FieldType::Srational:
     case FieldType::Double:
+    case FieldType::Long8:
+    case FieldType::Slong8:
+    case FieldType::Ifd8:
         return 8;
     default:
         return 1;
     }
 }
 
+// Rows are read in windows of about READ_WINDOW_BYTES: a reader thread fills the next window with a few large reads
+// while rows of the current one are handed out, so every input file is read as one sequential stream.
+// Windows of tiled images are whole tile rows, every tile is read once.
+constexpr int64_t READ_WINDOW_BYTES = 4 << 20;
+constexpr int64_t READ_WINDOWS_COUNT = 2;
+
 template <typename T>
 class TiffImageReader {
 public:
     TiffImageReader(const std::string& filename) : filename(filename), currentRow(0) {}
 
+    TiffImageReader(const TiffImageReader&) = delete;
+    TiffImageReader& operator=(const TiffImageReader&) = delete;
+
     ~TiffImageReader() {
+        {
+            std::lock_guard<std::mutex> lock(windowsMutex);
+            isClosed = true;
+        }
+        windowReleased.notify_all();
+        if (readerThread.joinable()) {
+            readerThread.join();
+        }
         if (inputStream.is_open()) {
             inputStream.close();
         }
@@ -52,28 +77,66 @@ public:
             std::cerr << "Can't open file!" << std::endl;
             return false;
         }
-        loadTiffHeader();
-        loadIFD();
+        try {
+            loadIFD();
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            return false;
+        }
         this->rowBytesCount = this->width * sizeof(T);
+        if (rowsPerStrip <= 0) {
+            rowsPerStrip = height;
+        }
+        rowsPerWindow = std::max<int64_t>(READ_WINDOW_BYTES / std::max<int64_t>(rowBytesCount, 1), 1);
+        if (isTiled()) {
+            if (tileWidth <= 0 || tileLength <= 0) {
+                std::cerr << "Wrong tile size!" << std::endl;
+                return false;
+            }
+            if (static_cast<int64_t>(tileOffsets.size()) != getTilesPerRow() * getTilesDown()) {
+                std::cerr << "Tile offsets do not match the tile grid!" << std::endl;
+                return false;
+            }
+            rowsPerWindow = std::max<int64_t>(rowsPerWindow / tileLength, 1) * tileLength;
+            tileRowBuffer = std::make_unique<uint8_t[]>(getTilesPerRow() * getTileBytesCount());
+        } else if (static_cast<int64_t>(stripOffsets.size()) < getStripsCount()) {
+            std::cerr << "Strip offsets do not cover the image!" << std::endl;
+            return false;
+        }
+        windows = std::make_unique<uint8_t[]>(READ_WINDOWS_COUNT * rowsPerWindow * rowBytesCount);
+        readerThread = std::thread(&TiffImageReader::readWindows, this);
         return true;
     }
 
-    bool readNextRow(T* rowBuffer) {
+    // Next row in the read window, valid until the next call. nullptr after the last row or on a read error
+    const T* readNextRowView() {
         if (currentRow >= height) {
-            return false;
+            return nullptr;
         }
 
-        uint32_t currentStrip = currentRow / rowsPerStrip;
-        uint32_t currentRowInStrip = currentRow % rowsPerStrip;
-        inputStream.seekg(stripOffsets[currentStrip] + currentRowInStrip * rowBytesCount, std::ios_base::beg);
-        inputStream.read(reinterpret_cast<char*>(rowBuffer), rowBytesCount);
-
-        if (inputStream.fail()) {
+        int64_t rowInWindow = currentRow % rowsPerWindow;
+        std::unique_lock<std::mutex> lock(windowsMutex);
+        if (rowInWindow == 0 && currentRow > 0) {
+            firstFilledWindow = (firstFilledWindow + 1) % READ_WINDOWS_COUNT;
+            filledWindowsCount--;
+            windowReleased.notify_one();
+        }
+        windowFilled.wait(lock, [this]() { return filledWindowsCount > 0 || isReadFinished; });
+        if (filledWindowsCount == 0) {
             std::cerr << "Error reading source image!" << std::endl;
-            return false;
+            return nullptr;
         }
 
         currentRow++;
+        return reinterpret_cast<const T*>(windows.get() + (firstFilledWindow * rowsPerWindow + rowInWindow) * rowBytesCount);
+    }
+
+    bool readNextRow(T* rowBuffer) {
+        const T* row = readNextRowView();
+        if (!row) {
+            return false;
+        }
+        memcpy(rowBuffer, row, rowBytesCount);
         return true;
     }
 
@@ -103,28 +166,132 @@ private:
     std::vector<uint64_t> stripOffsets;
     int32_t currentRow = 0;
 
-    void loadTiffHeader() {
-        TiffFileHeader tiffFileHeader;
-        inputStream.read(reinterpret_cast<char*>(&tiffFileHeader), sizeof(TiffFileHeader));
-        if (tiffFileHeader.byteOrder != 0x4949) {
-            std::cerr << "Not little-endian TIFF!" << std::endl;
-            throw std::runtime_error("Invalid byte order");
+    int64_t tileWidth = 0;
+    int64_t tileLength = 0;
+    std::vector<uint64_t> tileOffsets;
+    // Tiles of one tile row as they are stored in the file
+    std::unique_ptr<uint8_t[]> tileRowBuffer;
+
+    int64_t rowsPerWindow = 0;
+    std::unique_ptr<uint8_t[]> windows;
+    int64_t firstFilledWindow = 0;
+    int64_t filledWindowsCount = 0;
+    bool isReadFinished = false;
+    bool isClosed = false;
+    std::mutex windowsMutex;
+    std::condition_variable windowFilled;
+    std::condition_variable windowReleased;
+    std::thread readerThread;
+
+    bool isTiled() const {
+        return !tileOffsets.empty();
+    }
+
+    // Rows per strip are the image height if the tag is missing, an empty image has no strips
+    int64_t getStripsCount() const {
+        return rowsPerStrip > 0 ? (static_cast<int64_t>(height) + rowsPerStrip - 1) / rowsPerStrip : 0;
+    }
+
+    int64_t getTilesPerRow() const {
+        return (width + tileWidth - 1) / tileWidth;
+    }
+
+    int64_t getTilesDown() const {
+        return (height + tileLength - 1) / tileLength;
+    }
+
+    int64_t getTileBytesCount() const {
+        return tileWidth * tileLength * sizeof(T);
+    }
+
+    // Tiles of consecutive tile rows are read with one request per run of tiles lying one after another in the file,
+    // rows of the window are cut from them. firstRow is the first row of a tile row.
+    bool readTileRows(int64_t firstRow, int64_t rowsCount, uint8_t* destination) {
+        int64_t tilesPerRow = getTilesPerRow();
+        int64_t tileBytesCount = getTileBytesCount();
+        for (int64_t tileFirstRow = firstRow; tileFirstRow < firstRow + rowsCount; tileFirstRow += tileLength) {
+            const uint64_t* offsets = tileOffsets.data() + tileFirstRow / tileLength * tilesPerRow;
+            for (int64_t tile = 0; tile < tilesPerRow;) {
+                int64_t runTilesCount = 1;
+                while (tile + runTilesCount < tilesPerRow && offsets[tile + runTilesCount] == offsets[tile] + runTilesCount * tileBytesCount) {
+                    runTilesCount++;
+                }
+                inputStream.seekg(offsets[tile], std::ios_base::beg);
+                inputStream.read(reinterpret_cast<char*>(tileRowBuffer.get() + tile * tileBytesCount), runTilesCount * tileBytesCount);
+                if (inputStream.fail()) {
+                    return false;
+                }
+                tile += runTilesCount;
+            }
+
+            int64_t tileRowsCount = std::min<int64_t>(tileLength, firstRow + rowsCount - tileFirstRow);
+            for (int64_t rowInTile = 0; rowInTile < tileRowsCount; rowInTile++) {
+                uint8_t* row = destination + (tileFirstRow - firstRow + rowInTile) * rowBytesCount;
+                for (int64_t tile = 0; tile < tilesPerRow; tile++) {
+                    int64_t pixelsCount = std::min<int64_t>(tileWidth, width - tile * tileWidth);
+                    memcpy(row + tile * tileWidth * sizeof(T), tileRowBuffer.get() + tile * tileBytesCount + rowInTile * tileWidth * sizeof(T),
+                           pixelsCount * sizeof(T));
+                }
+            }
+        }
+        return true;
+    }
+
+    // Rows of consecutive strips lying one after another in the file are read at once
+    bool readRows(int64_t firstRow, int64_t rowsCount, uint8_t* destination) {
+        if (isTiled()) {
+            return readTileRows(firstRow, rowsCount, destination);
+        }
+        int64_t row = firstRow;
+        while (row < firstRow + rowsCount) {
+            uint64_t offset = stripOffsets[row / rowsPerStrip] + (row % rowsPerStrip) * rowBytesCount;
+            int64_t runRowsCount = 0;
+            while (row + runRowsCount < firstRow + rowsCount) {
+                int64_t nextRow = row + runRowsCount;
+                if (stripOffsets[nextRow / rowsPerStrip] + (nextRow % rowsPerStrip) * rowBytesCount != offset + runRowsCount * rowBytesCount) {
+                    break;
+                }
+                runRowsCount = std::min<int64_t>(runRowsCount + rowsPerStrip - nextRow % rowsPerStrip, firstRow + rowsCount - row);
+            }
+            inputStream.seekg(offset, std::ios_base::beg);
+            inputStream.read(reinterpret_cast<char*>(destination + (row - firstRow) * rowBytesCount), runRowsCount * rowBytesCount);
+            if (inputStream.fail()) {
+                return false;
+            }
+            row += runRowsCount;
+        }
+        return true;
+    }
+
+    void readWindows() {
+        for (int64_t firstRow = 0; firstRow < height; firstRow += rowsPerWindow) {
+            int64_t window = firstRow / rowsPerWindow % READ_WINDOWS_COUNT;
+            {
+                std::unique_lock<std::mutex> lock(windowsMutex);
+                windowReleased.wait(lock, [this]() { return filledWindowsCount < READ_WINDOWS_COUNT || isClosed; });
+                if (isClosed) {
+                    return;
+                }
+            }
+            if (!readRows(firstRow, std::min<int64_t>(rowsPerWindow, height - firstRow), windows.get() + window * rowsPerWindow * rowBytesCount)) {
+                break;
+            }
+            {
+                std::lock_guard<std::mutex> lock(windowsMutex);
+                filledWindowsCount++;
+            }
+            windowFilled.notify_one();
         }
-        if (tiffFileHeader.versionNumber != 42) {
-            std::cerr << "Unknown TIFF version!" << std::endl;
-            throw std::runtime_error("Unknown TIFF version");
+        {
+            std::lock_guard<std::mutex> lock(windowsMutex);
+            isReadFinished = true;
         }
-        inputStream.seekg(tiffFileHeader.offsetIFD, std::ios::beg);
+        windowFilled.notify_one();
     }
 
     void loadIFD() {
-        uint16_t numberEntries;
-        inputStream.read(reinterpret_cast<char*>(&numberEntries), sizeof(uint16_t));
-        TiffIFD tiffIFD(numberEntries);
-        inputStream.read(reinterpret_cast<char*>(tiffIFD.entries.get()), numberEntries * sizeof(TiffIFDEntry));
-
-        for (int i = 0; i < numberEntries; i++) {
-            auto& entry = tiffIFD.entries.get()[i];
+        TiffDirectory directory = readTiffDirectory(inputStream);
+        for (const BigTiffIFDEntry& entry : directory.entries) {
             if (entry.tag == TiffTagEnum::ImageWidth) {
                 width = entry.valueOffset;
             } else if (entry.tag == TiffTagEnum::ImageLength) {
@@ -132,16 +299,36 @@ private:
             } else if (entry.tag == TiffTagEnum::RowsPerStrip) {
                 rowsPerStrip = entry.valueOffset;
             } else if (entry.tag == TiffTagEnum::StripOffsets) {
-                stripOffsets = getValuesVector(entry.tag, entry.valueOffset, entry.numberValues, FieldType::Long);
+                stripOffsets = getValuesVector(directory, entry);
+            } else if (entry.tag == TiffTagEnum::TileWidth) {
+                tileWidth = entry.valueOffset;
+            } else if (entry.tag == TiffTagEnum::TileLength) {
+                tileLength = entry.valueOffset;
+            } else if (entry.tag == TiffTagEnum::TileOffsets) {
+                tileOffsets = getValuesVector(directory, entry);
             }
         }
     }
 
+    // Values stored in the entry itself (one strip) or at valueOffset
+    std::vector<uint64_t> getValuesVector(const TiffDirectory& directory, const BigTiffIFDEntry& entry) {
+        FieldType fieldType = static_cast<FieldType>(entry.fieldType);
+        uint64_t size = getFieldSize(fieldType);
+        if (entry.numberValues * size > directory.getInlineValuesBytesCount()) {
+            return getValuesVector(entry.tag, entry.valueOffset, entry.numberValues, fieldType);
+        }
+        std::vector<uint64_t> values(entry.numberValues, 0);
+        for (uint64_t j = 0; j < entry.numberValues; j++) {
+            memcpy(&values[j], reinterpret_cast<const uint8_t*>(&entry.valueOffset) + j * size, size);
+        }
+        return values;
+    }
+
     std::vector<uint64_t> getValuesVector(uint16_t key, uint64_t valueOffset, uint64_t numberValues, FieldType fieldType) {
         std::streampos oldPos = inputStream.tellg();
         inputStream.seekg(valueOffset, std::ios::beg);
         std::vector<uint64_t> values;
-        for (uint32_t j = 0; j < numberValues; j++) {
+        for (uint64_t j = 0; j < numberValues; j++) {
             uint64_t sample = 0;
             uint32_t size = getFieldSize(fieldType);
             inputStream.read(reinterpret_cast<char*>(&sample), static_cast<uint32_t>(size));
@@ -0,0 +1,377 @@
+#ifndef TMATRIXBATCH_H
+#define TMATRIXBATCH_H
+
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <vector>
+#include "t_matrix.h"
+#include "tmatrixdecomposition.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define T_MATRIX_BATCH_X86
+#endif
+
+// Row of coherency matrices as structure of arrays, vector code loads 4 pixels of every element at once
+struct TMatrixRow {
+    std::vector<double> e00;
+    std::vector<double> e11;
+    std::vector<double> e22;
+    std::vector<double> e01Re;
+    std::vector<double> e01Im;
+    std::vector<double> e02Re;
+    std::vector<double> e02Im;
+    std::vector<double> e12Re;
+    std::vector<double> e12Im;
+
+    explicit TMatrixRow(int64_t width)
+        : e00(width), e11(width), e22(width), e01Re(width), e01Im(width), e02Re(width), e02Im(width), e12Re(width), e12Im(width) {
+    }
+
+    void set(int64_t index, const TMatrix& tMatrix) {
+        e00[index] = tMatrix.E00;
+        e11[index] = tMatrix.E11;
+        e22[index] = tMatrix.E22;
+        e01Re[index] = tMatrix.E01.real();
+        e01Im[index] = tMatrix.E01.imag();
+        e02Re[index] = tMatrix.E02.real();
+        e02Im[index] = tMatrix.E02.imag();
+        e12Re[index] = tMatrix.E12.real();
+        e12Im[index] = tMatrix.E12.imag();
+    }
+
+    TMatrix get(int64_t index) const {
+        return {e00[index], e11[index], e22[index], {e01Re[index], e01Im[index]}, {e02Re[index], e02Im[index]},
+                {e12Re[index], e12Im[index]}};
+    }
+};
+
+// Taylor coefficients of asin(z) = z + sum c[k] z^(2k + 1), k = 1..ASIN_TERMS_COUNT
+constexpr int64_t ASIN_TERMS_COUNT = 20;
+
+constexpr std::array<double, ASIN_TERMS_COUNT + 1> getAsinCoefficients() {
+    std::array<double, ASIN_TERMS_COUNT + 1> coefficients = {};
+    double ratio = 1;
+    for (int64_t k = 0; k <= ASIN_TERMS_COUNT; k++) {
+        coefficients[k] = ratio / (2 * k + 1);
+        ratio *= (2.0 * k + 1) / (2.0 * k + 2);
+    }
+    return coefficients;
+}
+
+constexpr std::array<double, ASIN_TERMS_COUNT + 1> ASIN_COEFFICIENTS = getAsinCoefficients();
+
+#ifdef T_MATRIX_BATCH_X86
+inline bool isTMatrixBatchSupported() {
+    static const bool isAvx2Supported = []() {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+    }();
+    return isAvx2Supported;
+}
+
+// Natural logarithm of positive normal numbers, absolute error below 2e-15 * max(1, |log(x)|).
+// x = 2^e * m, m in [sqrt(0.5), sqrt(2)), log(m) = 2 atanh(s) = 2 (s + s^3 / 3 + ... + s^17 / 17), s = (m - 1) / (m + 1)
+__attribute__((target("avx2")))
+inline __m256d logAvx2(__m256d x) {
+    __m256i bits = _mm256_castpd_si256(x);
+    __m256i exponentBits = _mm256_or_si256(_mm256_srli_epi64(bits, 52), _mm256_set1_epi64x(0x4330000000000000));
+    __m256d exponent = _mm256_sub_pd(_mm256_castsi256_pd(exponentBits), _mm256_set1_pd(4503599627370496.0 + 1023));
+    __m256i mantissaBits = _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x(0x000fffffffffffff)),
+                                           _mm256_set1_epi64x(0x3ff0000000000000));
+    __m256d mantissa = _mm256_castsi256_pd(mantissaBits);
+
+    __m256d isAboveSqrt2 = _mm256_cmp_pd(mantissa, _mm256_set1_pd(M_SQRT2), _CMP_GT_OQ);
+    mantissa = _mm256_blendv_pd(mantissa, _mm256_mul_pd(mantissa, _mm256_set1_pd(0.5)), isAboveSqrt2);
+    exponent = _mm256_add_pd(exponent, _mm256_and_pd(isAboveSqrt2, _mm256_set1_pd(1.0)));
+
+    __m256d s = _mm256_div_pd(_mm256_sub_pd(mantissa, _mm256_set1_pd(1.0)), _mm256_add_pd(mantissa, _mm256_set1_pd(1.0)));
+    __m256d s2 = _mm256_mul_pd(s, s);
+    __m256d series = _mm256_set1_pd(1.0 / 17);
+    for (int64_t k = 7; k >= 0; k--) {
+        series = _mm256_add_pd(_mm256_mul_pd(series, s2), _mm256_set1_pd(1.0 / (2 * k + 1)));
+    }
+    __m256d logMantissa = _mm256_mul_pd(_mm256_add_pd(s, s), series);
+    return _mm256_add_pd(_mm256_mul_pd(exponent, _mm256_set1_pd(M_LN2)), logMantissa);
+}
+
+// acos(x) for x in [0, 1], absolute error below 4e-15. acos(x) = pi / 2 - asin(x) for x <= 0.5,
+// 2 asin(sqrt((1 - x) / 2)) above, asin of arguments up to 0.5 is the Taylor series of ASIN_COEFFICIENTS
+__attribute__((target("avx2")))
+inline __m256d acosUnitAvx2(__m256d x) {
+    __m256d isAboveHalf = _mm256_cmp_pd(x, _mm256_set1_pd(0.5), _CMP_GT_OQ);
+    __m256d reduced = _mm256_sqrt_pd(_mm256_mul_pd(_mm256_sub_pd(_mm256_set1_pd(1.0), x), _mm256_set1_pd(0.5)));
+    __m256d z = _mm256_blendv_pd(x, reduced, isAboveHalf);
+    __m256d z2 = _mm256_mul_pd(z, z);
+    __m256d series = _mm256_set1_pd(ASIN_COEFFICIENTS[ASIN_TERMS_COUNT]);
+    for (int64_t k = ASIN_TERMS_COUNT - 1; k >= 0; k--) {
+        series = _mm256_add_pd(_mm256_mul_pd(series, z2), _mm256_set1_pd(ASIN_COEFFICIENTS[k]));
+    }
+    __m256d asinZ = _mm256_mul_pd(z, series);
+    return _mm256_blendv_pd(_mm256_sub_pd(_mm256_set1_pd(M_PI_2), asinZ), _mm256_add_pd(asinZ, asinZ), isAboveHalf);
+}
+
+// cos(acos(y) / 3) for y in [0, 1]: the root of 4x^3 - 3x = y in [cos(pi / 6), 1]. The derivative is at least 6 there,
+// four Newton steps from the chord reach full precision
+__attribute__((target("avx2")))
+inline __m256d cosThirdAcosAvx2(__m256d y) {
+    __m256d x = _mm256_add_pd(_mm256_set1_pd(0.8660254037844386), _mm256_mul_pd(y, _mm256_set1_pd(0.1339745962155614)));
+    for (int64_t i = 0; i < 4; i++) {
+        __m256d x2 = _mm256_mul_pd(x, x);
+        __m256d f = _mm256_sub_pd(_mm256_mul_pd(x, _mm256_sub_pd(_mm256_mul_pd(_mm256_set1_pd(4.0), x2), _mm256_set1_pd(3.0))), y);
+        __m256d derivative = _mm256_sub_pd(_mm256_mul_pd(_mm256_set1_pd(12.0), x2), _mm256_set1_pd(3.0));
+        x = _mm256_sub_pd(x, _mm256_div_pd(f, derivative));
+    }
+    return x;
+}
+
+struct ComplexBatch {
+    __m256d re;
+    __m256d im;
+};
+
+__attribute__((target("avx2")))
+inline ComplexBatch addAvx2(const ComplexBatch& a, const ComplexBatch& b) {
+    return {_mm256_add_pd(a.re, b.re), _mm256_add_pd(a.im, b.im)};
+}
+
+__attribute__((target("avx2")))
+inline ComplexBatch subAvx2(const ComplexBatch& a, const ComplexBatch& b) {
+    return {_mm256_sub_pd(a.re, b.re), _mm256_sub_pd(a.im, b.im)};
+}
+
+__attribute__((target("avx2")))
+inline ComplexBatch mulAvx2(const ComplexBatch& a, const ComplexBatch& b) {
+    return {_mm256_sub_pd(_mm256_mul_pd(a.re, b.re), _mm256_mul_pd(a.im, b.im)),
+            _mm256_add_pd(_mm256_mul_pd(a.re, b.im), _mm256_mul_pd(a.im, b.re))};
+}
+
+__attribute__((target("avx2")))
+inline ComplexBatch scaleAvx2(const ComplexBatch& a, __m256d factor) {
+    return {_mm256_mul_pd(a.re, factor), _mm256_mul_pd(a.im, factor)};
+}
+
+__attribute__((target("avx2")))
+inline ComplexBatch conjAvx2(const ComplexBatch& a) {
+    return {a.re, _mm256_sub_pd(_mm256_setzero_pd(), a.im)};
+}
+
+__attribute__((target("avx2")))
+inline __m256d normAvx2(const ComplexBatch& a) {
+    return _mm256_add_pd(_mm256_mul_pd(a.re, a.re), _mm256_mul_pd(a.im, a.im));
+}
+
+__attribute__((target("avx2")))
+inline ComplexBatch selectAvx2(__m256d mask, const ComplexBatch& ifTrue, const ComplexBatch& ifFalse) {
+    return {_mm256_blendv_pd(ifFalse.re, ifTrue.re, mask), _mm256_blendv_pd(ifFalse.im, ifTrue.im, mask)};
+}
+
+using ComplexVectorBatch = std::array<ComplexBatch, 3>;
+
+__attribute__((target("avx2")))
+inline ComplexVectorBatch crossProductAvx2(const ComplexVectorBatch& u, const ComplexVectorBatch& v) {
+    return {subAvx2(mulAvx2(u[1], v[2]), mulAvx2(u[2], v[1])), subAvx2(mulAvx2(u[2], v[0]), mulAvx2(u[0], v[2])),
+            subAvx2(mulAvx2(u[0], v[1]), mulAvx2(u[1], v[0]))};
+}
+
+__attribute__((target("avx2")))
+inline __m256d squaredNormAvx2(const ComplexVectorBatch& u) {
+    return _mm256_add_pd(_mm256_add_pd(normAvx2(u[0]), normAvx2(u[1])), normAvx2(u[2]));
+}
+
+// Real part of u^H v
+__attribute__((target("avx2")))
+inline __m256d dotReAvx2(const ComplexVectorBatch& u, const ComplexVectorBatch& v) {
+    __m256d result = _mm256_setzero_pd();
+    for (int64_t i = 0; i < 3; i++) {
+        result = _mm256_add_pd(result, _mm256_add_pd(_mm256_mul_pd(u[i].re, v[i].re), _mm256_mul_pd(u[i].im, v[i].im)));
+    }
+    return result;
+}
+
+__attribute__((target("avx2")))
+inline ComplexVectorBatch multiplyTMatrixAvx2(__m256d e00, __m256d e11, __m256d e22, const ComplexBatch& e01, const ComplexBatch& e02,
+                                              const ComplexBatch& e12, const ComplexVectorBatch& u) {
+    return {addAvx2(addAvx2(scaleAvx2(u[0], e00), mulAvx2(e01, u[1])), mulAvx2(e02, u[2])),
+            addAvx2(addAvx2(mulAvx2(conjAvx2(e01), u[0]), scaleAvx2(u[1], e11)), mulAvx2(e12, u[2])),
+            addAvx2(addAvx2(mulAvx2(conjAvx2(e02), u[0]), mulAvx2(conjAvx2(e12), u[1])), scaleAvx2(u[2], e22))};
+}
+
+// solveTMatrixEigenAnalytic and computeHAAlpha for 4 pixels, only the first components of eigenvectors are computed.
+// Returns the mask of pixels left to the scalar code: close to a multiple of identity or with a zero cross product.
+__attribute__((target("avx2")))
+inline int computeHAAlphaAvx2(const TMatrixRow& row, int64_t index, double* entropy, double* anisotropy, double* alpha) {
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d zero = _mm256_setzero_pd();
+
+    __m256d e00 = _mm256_loadu_pd(row.e00.data() + index);
+    __m256d e11 = _mm256_loadu_pd(row.e11.data() + index);
+    __m256d e22 = _mm256_loadu_pd(row.e22.data() + index);
+    ComplexBatch e01 = {_mm256_loadu_pd(row.e01Re.data() + index), _mm256_loadu_pd(row.e01Im.data() + index)};
+    ComplexBatch e02 = {_mm256_loadu_pd(row.e02Re.data() + index), _mm256_loadu_pd(row.e02Im.data() + index)};
+    ComplexBatch e12 = {_mm256_loadu_pd(row.e12Re.data() + index), _mm256_loadu_pd(row.e12Im.data() + index)};
+
+    __m256d m = _mm256_mul_pd(_mm256_add_pd(_mm256_add_pd(e00, e11), e22), _mm256_set1_pd(1.0 / 3));
+    __m256d b00 = _mm256_sub_pd(e00, m);
+    __m256d b11 = _mm256_sub_pd(e11, m);
+    __m256d b22 = _mm256_sub_pd(e22, m);
+    __m256d norm01 = normAvx2(e01);
+    __m256d norm02 = normAvx2(e02);
+    __m256d norm12 = normAvx2(e12);
+
+    __m256d diagonal = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(b00, b00), _mm256_mul_pd(b11, b11)), _mm256_mul_pd(b22, b22));
+    __m256d offDiagonal = _mm256_add_pd(_mm256_add_pd(norm01, norm02), norm12);
+    __m256d p2 = _mm256_mul_pd(_mm256_add_pd(diagonal, _mm256_add_pd(offDiagonal, offDiagonal)), _mm256_set1_pd(1.0 / 6));
+    __m256d p = _mm256_sqrt_pd(p2);
+    __m256d absM = _mm256_andnot_pd(_mm256_set1_pd(-0.0), m);
+    __m256d isSolved = _mm256_cmp_pd(p, _mm256_mul_pd(absM, _mm256_set1_pd(T_MATRIX_ISOTROPY_THRESHOLD)), _CMP_GT_OQ);
+
+    __m256d product = mulAvx2(mulAvx2(e01, e12), conjAvx2(e02)).re;
+    __m256d detB = _mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(b00, b11), b22), _mm256_add_pd(product, product));
+    detB = _mm256_sub_pd(detB, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(b00, norm12), _mm256_mul_pd(b11, norm02)),
+                                             _mm256_mul_pd(b22, norm01)));
+    __m256d cos3Phi = _mm256_div_pd(detB, _mm256_mul_pd(_mm256_add_pd(p, p), p2));
+    cos3Phi = _mm256_max_pd(_mm256_min_pd(cos3Phi, one), _mm256_set1_pd(-1.0));
+
+    // cos(phi + 2 pi / 3) = -cos(acos(-cos3Phi) / 3)
+    __m256d isLargestIsolated = _mm256_cmp_pd(cos3Phi, zero, _CMP_GE_OQ);
+    __m256d signBit = _mm256_andnot_pd(isLargestIsolated, _mm256_set1_pd(-0.0));
+    __m256d cosine = _mm256_xor_pd(cosThirdAcosAvx2(_mm256_xor_pd(cos3Phi, signBit)), signBit);
+    __m256d isolatedEigenValue = _mm256_add_pd(m, _mm256_mul_pd(_mm256_add_pd(p, p), cosine));
+
+    ComplexBatch diagonal0 = {_mm256_sub_pd(e00, isolatedEigenValue), zero};
+    ComplexBatch diagonal1 = {_mm256_sub_pd(e11, isolatedEigenValue), zero};
+    ComplexBatch diagonal2 = {_mm256_sub_pd(e22, isolatedEigenValue), zero};
+    ComplexVectorBatch row0 = {diagonal0, e01, e02};
+    ComplexVectorBatch row1 = {conjAvx2(e01), diagonal1, e12};
+    ComplexVectorBatch row2 = {conjAvx2(e02), conjAvx2(e12), diagonal2};
+    ComplexVectorBatch products[3] = {crossProductAvx2(row0, row1), crossProductAvx2(row0, row2), crossProductAvx2(row1, row2)};
+    __m256d norms[3] = {squaredNormAvx2(products[0]), squaredNormAvx2(products[1]), squaredNormAvx2(products[2])};
+
+    // The first longest product as std::max_element
+    __m256d isSecondLonger = _mm256_cmp_pd(norms[1], norms[0], _CMP_GT_OQ);
+    __m256d longestNorm = _mm256_max_pd(norms[1], norms[0]);
+    __m256d isThirdLongest = _mm256_cmp_pd(norms[2], longestNorm, _CMP_GT_OQ);
+    longestNorm = _mm256_blendv_pd(longestNorm, norms[2], isThirdLongest);
+    isSolved = _mm256_and_pd(isSolved, _mm256_cmp_pd(longestNorm, zero, _CMP_GT_OQ));
+    __m256d inverseNorm = _mm256_div_pd(one, _mm256_sqrt_pd(longestNorm));
+    ComplexVectorBatch isolated;
+    for (int64_t i = 0; i < 3; i++) {
+        ComplexBatch longest = selectAvx2(isThirdLongest, products[2][i], selectAvx2(isSecondLonger, products[1][i], products[0][i]));
+        isolated[i] = scaleAvx2(longest, inverseNorm);
+    }
+
+    // u1 = conj(isolated x unit axis of the smallest component), cross products with unit axes are permutations
+    __m256d componentNorms[3] = {normAvx2(isolated[0]), normAvx2(isolated[1]), normAvx2(isolated[2])};
+    __m256d isAxis1 = _mm256_cmp_pd(componentNorms[1], componentNorms[0], _CMP_LT_OQ);
+    __m256d isAxis2 = _mm256_cmp_pd(componentNorms[2], _mm256_blendv_pd(componentNorms[0], componentNorms[1], isAxis1), _CMP_LT_OQ);
+    isAxis1 = _mm256_andnot_pd(isAxis2, isAxis1);
+    ComplexBatch zeroComplex = {zero, zero};
+    ComplexVectorBatch u1 = {
+        selectAvx2(isAxis2, isolated[1], selectAvx2(isAxis1, subAvx2(zeroComplex, isolated[2]), zeroComplex)),
+        selectAvx2(isAxis2, subAvx2(zeroComplex, isolated[0]), selectAvx2(isAxis1, zeroComplex, isolated[2])),
+        selectAvx2(isAxis2, zeroComplex, selectAvx2(isAxis1, isolated[0], subAvx2(zeroComplex, isolated[1])))};
+    __m256d inverseU1Norm = _mm256_div_pd(one, _mm256_sqrt_pd(squaredNormAvx2(u1)));
+    for (int64_t i = 0; i < 3; i++) {
+        u1[i] = scaleAvx2(conjAvx2(u1[i]), inverseU1Norm);
+    }
+    ComplexVectorBatch u2 = crossProductAvx2(isolated, u1);
+    for (int64_t i = 0; i < 3; i++) {
+        u2[i] = conjAvx2(u2[i]);
+    }
+
+    ComplexVectorBatch tU1 = multiplyTMatrixAvx2(e00, e11, e22, e01, e02, e12, u1);
+    ComplexVectorBatch tU2 = multiplyTMatrixAvx2(e00, e11, e22, e01, e02, e12, u2);
+    __m256d c11 = dotReAvx2(u1, tU1);
+    __m256d c22 = dotReAvx2(u2, tU2);
+    ComplexBatch c12 = zeroComplex;
+    for (int64_t i = 0; i < 3; i++) {
+        c12 = addAvx2(c12, mulAvx2(conjAvx2(u1[i]), tU2[i]));
+    }
+
+    __m256d mean = _mm256_mul_pd(_mm256_add_pd(c11, c22), _mm256_set1_pd(0.5));
+    __m256d d = _mm256_mul_pd(_mm256_sub_pd(c11, c22), _mm256_set1_pd(0.5));
+    __m256d r = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(d, d), normAvx2(c12)));
+    __m256d isDNonNegative = _mm256_cmp_pd(d, zero, _CMP_GE_OQ);
+    ComplexBatch w0 = selectAvx2(isDNonNegative, ComplexBatch{_mm256_add_pd(d, r), zero}, c12);
+    ComplexBatch w1 = selectAvx2(isDNonNegative, conjAvx2(c12), ComplexBatch{_mm256_sub_pd(r, d), zero});
+    __m256d inverseWNorm = _mm256_div_pd(one, _mm256_sqrt_pd(_mm256_add_pd(normAvx2(w0), normAvx2(w1))));
+    __m256d isRPositive = _mm256_cmp_pd(r, zero, _CMP_GT_OQ);
+    w0 = selectAvx2(isRPositive, scaleAvx2(w0, inverseWNorm), ComplexBatch{one, zero});
+    w1 = selectAvx2(isRPositive, scaleAvx2(w1, inverseWNorm), zeroComplex);
+
+    ComplexBatch larger0 = addAvx2(mulAvx2(w0, u1[0]), mulAvx2(w1, u2[0]));
+    ComplexBatch smaller0 = subAvx2(mulAvx2(conjAvx2(w0), u2[0]), mulAvx2(conjAvx2(w1), u1[0]));
+    __m256d isolatedFirst = _mm256_sqrt_pd(normAvx2(isolated[0]));
+    __m256d largerFirst = _mm256_sqrt_pd(normAvx2(larger0));
+    __m256d smallerFirst = _mm256_sqrt_pd(normAvx2(smaller0));
+
+    __m256d largerEigenValue = _mm256_add_pd(mean, r);
+    __m256d smallerEigenValue = _mm256_sub_pd(mean, r);
+    __m256d eigenValues[3] = {_mm256_blendv_pd(largerEigenValue, isolatedEigenValue, isLargestIsolated),
+                              _mm256_blendv_pd(smallerEigenValue, largerEigenValue, isLargestIsolated),
+                              _mm256_blendv_pd(isolatedEigenValue, smallerEigenValue, isLargestIsolated)};
+    __m256d firstComponents[3] = {_mm256_blendv_pd(largerFirst, isolatedFirst, isLargestIsolated),
+                                  _mm256_blendv_pd(smallerFirst, largerFirst, isLargestIsolated),
+                                  _mm256_blendv_pd(isolatedFirst, smallerFirst, isLargestIsolated)};
+
+    // 0 * log(0) is taken as 0
+    __m256d probabilities[3];
+    __m256d totalSum = zero;
+    for (int64_t k = 0; k < 3; k++) {
+        eigenValues[k] = _mm256_andnot_pd(_mm256_set1_pd(-0.0), eigenValues[k]);
+        totalSum = _mm256_add_pd(totalSum, eigenValues[k]);
+    }
+    __m256d inverseTotalSum = _mm256_div_pd(one, totalSum);
+    __m256d entropySum = zero;
+    __m256d alphaSum = zero;
+    for (int64_t k = 0; k < 3; k++) {
+        probabilities[k] = _mm256_mul_pd(eigenValues[k], inverseTotalSum);
+        __m256d isPositive = _mm256_cmp_pd(probabilities[k], zero, _CMP_GT_OQ);
+        __m256d term = _mm256_mul_pd(probabilities[k], logAvx2(_mm256_blendv_pd(one, probabilities[k], isPositive)));
+        entropySum = _mm256_add_pd(entropySum, term);
+        alphaSum = _mm256_add_pd(alphaSum, _mm256_mul_pd(acosUnitAvx2(_mm256_min_pd(firstComponents[k], one)), probabilities[k]));
+    }
+    _mm256_storeu_pd(entropy + index, _mm256_mul_pd(entropySum, _mm256_set1_pd(-1.0 / std::log(3.0))));
+    _mm256_storeu_pd(anisotropy + index, _mm256_div_pd(_mm256_sub_pd(probabilities[1], probabilities[2]),
+                                                       _mm256_add_pd(probabilities[1], probabilities[2])));
+    _mm256_storeu_pd(alpha + index, alphaSum);
+    return ~_mm256_movemask_pd(isSolved) & 0xf;
+}
+#else
+inline bool isTMatrixBatchSupported() {
+    return false;
+}
+#endif
+
+// H / A / alpha of the first count matrices of the row: 4 pixels at a time with AVX2, the rest and the pixels
+// the vector code can't solve with solveTMatrixEigen and computeHAAlpha
+inline void computeHAAlphaRow(const TMatrixRow& row, int64_t count, double* entropy, double* anisotropy, double* alpha) {
+    auto computeScalar = [&](int64_t index) {
+        HAAlphaParameters parameters = computeHAAlpha(solveTMatrixEigen(row.get(index)));
+        entropy[index] = parameters.entropy;
+        anisotropy[index] = parameters.anisotropy;
+        alpha[index] = parameters.alpha;
+    };
+
+    int64_t index = 0;
+#ifdef T_MATRIX_BATCH_X86
+    if (isTMatrixBatchSupported()) {
+        for (; index + 4 <= count; index += 4) {
+            int unsolvedMask = computeHAAlphaAvx2(row, index, entropy, anisotropy, alpha);
+            for (int64_t lane = 0; unsolvedMask != 0 && lane < 4; lane++) {
+                if (unsolvedMask & (1 << lane)) {
+                    computeScalar(index + lane);
+                }
+            }
+        }
+    }
+#endif
+    for (; index < count; index++) {
+        computeScalar(index);
+    }
+}
+
+#endif // TMATRIXBATCH_H
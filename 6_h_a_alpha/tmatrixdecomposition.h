@@ -0,0 +1,221 @@
+#ifndef TMATRIXDECOMPOSITION_H
+#define TMATRIXDECOMPOSITION_H
+
+#include <array>
+#include <cmath>
+#include <complex>
+#include <algorithm>
+#include <eigen3/Eigen/Dense>
+#include "t_matrix.h"
+
+// Eigenvalues of the coherency matrix in descending order, eigenVectors[k] is the unit eigenvector of eigenValues[k]
+struct TMatrixEigenDecomposition {
+    std::array<double, 3> eigenValues;
+    std::array<std::array<std::complex<double>, 3>, 3> eigenVectors;
+};
+
+// Entropy, anisotropy and mean alpha angle of the Cloude-Pottier decomposition
+struct HAAlphaParameters {
+    double entropy;
+    double anisotropy;
+    double alpha;
+};
+
+// Matrices closer than this fraction of their trace to a multiple of identity have no distinct eigenvectors,
+// they are left to the iterative solver
+constexpr double T_MATRIX_ISOTROPY_THRESHOLD = 1e-6;
+
+inline TMatrixEigenDecomposition solveTMatrixEigenIterative(const TMatrix& tMatrix) {
+    Eigen::Matrix3cd T;
+    T(0, 0) = tMatrix.E00;
+    T(1, 1) = tMatrix.E11;
+    T(2, 2) = tMatrix.E22;
+    T(0, 1) = tMatrix.E01;
+    T(1, 0) = std::conj(tMatrix.E01);
+    T(0, 2) = tMatrix.E02;
+    T(2, 0) = std::conj(tMatrix.E02);
+    T(1, 2) = tMatrix.E12;
+    T(2, 1) = std::conj(tMatrix.E12);
+
+    // Eigenvalues of the solver are in ascending order
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3cd> solver(T);
+    TMatrixEigenDecomposition decomposition;
+    for (int64_t k = 0; k < 3; k++) {
+        decomposition.eigenValues[k] = solver.eigenvalues()(2 - k);
+        for (int64_t i = 0; i < 3; i++) {
+            decomposition.eigenVectors[k][i] = solver.eigenvectors()(i, 2 - k);
+        }
+    }
+    return decomposition;
+}
+
+// Product of finite complex values: operator* of std::complex also recovers infinities from NaN results (C99 Annex G),
+// GCC and Clang call __muldc3 for that instead of inlining the four products
+inline std::complex<double> multiplyFinite(const std::complex<double>& a, const std::complex<double>& b) {
+    return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+}
+
+inline std::array<std::complex<double>, 3> crossProduct(const std::array<std::complex<double>, 3>& u,
+                                                        const std::array<std::complex<double>, 3>& v) {
+    return {multiplyFinite(u[1], v[2]) - multiplyFinite(u[2], v[1]), multiplyFinite(u[2], v[0]) - multiplyFinite(u[0], v[2]),
+            multiplyFinite(u[0], v[1]) - multiplyFinite(u[1], v[0])};
+}
+
+inline double squaredNorm(const std::array<std::complex<double>, 3>& u) {
+    return std::norm(u[0]) + std::norm(u[1]) + std::norm(u[2]);
+}
+
+// Unit vector v with (T - eigenValue * I) v = 0: the cross product of two rows of T - eigenValue * I is orthogonal
+// to both of them, the longest of the three products is the most accurate
+inline bool getTMatrixEigenVector(const TMatrix& tMatrix, double eigenValue, std::array<std::complex<double>, 3>& eigenVector) {
+    std::array<std::complex<double>, 3> row0 = {tMatrix.E00 - eigenValue, tMatrix.E01, tMatrix.E02};
+    std::array<std::complex<double>, 3> row1 = {std::conj(tMatrix.E01), tMatrix.E11 - eigenValue, tMatrix.E12};
+    std::array<std::complex<double>, 3> row2 = {std::conj(tMatrix.E02), std::conj(tMatrix.E12), tMatrix.E22 - eigenValue};
+
+    std::array<std::array<std::complex<double>, 3>, 3> products = {crossProduct(row0, row1), crossProduct(row0, row2),
+                                                                   crossProduct(row1, row2)};
+    std::array<double, 3> norms = {squaredNorm(products[0]), squaredNorm(products[1]), squaredNorm(products[2])};
+    int64_t longest = std::max_element(norms.begin(), norms.end()) - norms.begin();
+    if (!(norms[longest] > 0)) {
+        return false;
+    }
+    double inverseNorm = 1.0 / std::sqrt(norms[longest]);
+    for (int64_t i = 0; i < 3; i++) {
+        eigenVector[i] = products[longest][i] * inverseNorm;
+    }
+    return true;
+}
+
+// Closed form: eigenvalues of T = m * I + p * B are m + 2p * cos(phi + 2 pi k / 3), cos(3 phi) = det(B) / 2.
+// Only the eigenvalue farthest from the other two is taken from the formula, it is separated from them by at least
+// sqrt(3) * p, so its eigenvector is a well-conditioned cross product of rows. The other two are eigenvalues of T
+// restricted to the orthogonal complement, a 2 x 2 Hermitian matrix solved directly: Cardano's roots of two close
+// eigenvalues lose half of the digits. Returns false for T close to a multiple of identity.
+inline bool solveTMatrixEigenAnalytic(const TMatrix& tMatrix, TMatrixEigenDecomposition& decomposition) {
+    double m = (tMatrix.E00 + tMatrix.E11 + tMatrix.E22) / 3;
+    double b00 = tMatrix.E00 - m;
+    double b11 = tMatrix.E11 - m;
+    double b22 = tMatrix.E22 - m;
+    double norm01 = std::norm(tMatrix.E01);
+    double norm02 = std::norm(tMatrix.E02);
+    double norm12 = std::norm(tMatrix.E12);
+
+    double p2 = (b00 * b00 + b11 * b11 + b22 * b22 + 2 * (norm01 + norm02 + norm12)) / 6;
+    double p = std::sqrt(p2);
+    if (!(p > T_MATRIX_ISOTROPY_THRESHOLD * std::abs(m))) {
+        return false;
+    }
+    double detB = b00 * b11 * b22 + 2 * std::real(multiplyFinite(multiplyFinite(tMatrix.E01, tMatrix.E12), std::conj(tMatrix.E02))) -
+                  b00 * norm12 - b11 * norm02 - b22 * norm01;
+    double cos3Phi = std::clamp(detB / (2 * p * p2), -1.0, 1.0);
+    double phi = std::acos(cos3Phi) / 3;
+
+    // cos(3 phi) >= 0: the largest eigenvalue is the farthest one, otherwise the smallest
+    bool isLargestIsolated = cos3Phi >= 0;
+    double isolatedEigenValue = isLargestIsolated ? m + 2 * p * std::cos(phi) : m + 2 * p * std::cos(phi + 2 * M_PI / 3);
+    std::array<std::complex<double>, 3> isolated;
+    if (!getTMatrixEigenVector(tMatrix, isolatedEigenValue, isolated)) {
+        return false;
+    }
+
+    // Orthonormal basis u1, u2 of the complement: u1 is orthogonal to the axis of the smallest component of isolated
+    int64_t axis = 0;
+    for (int64_t i = 1; i < 3; i++) {
+        if (std::norm(isolated[i]) < std::norm(isolated[axis])) {
+            axis = i;
+        }
+    }
+    std::array<std::complex<double>, 3> unitAxis = {0.0, 0.0, 0.0};
+    unitAxis[axis] = 1.0;
+    std::array<std::complex<double>, 3> u1 = crossProduct(isolated, unitAxis);
+    double inverseNorm = 1.0 / std::sqrt(squaredNorm(u1));
+    for (int64_t i = 0; i < 3; i++) {
+        u1[i] = std::conj(u1[i]) * inverseNorm;
+    }
+    std::array<std::complex<double>, 3> u2 = crossProduct(isolated, u1);
+    for (int64_t i = 0; i < 3; i++) {
+        u2[i] = std::conj(u2[i]);
+    }
+
+    // C = [u1 u2]^H T [u1 u2]
+    auto multiply = [&tMatrix](const std::array<std::complex<double>, 3>& u) {
+        return std::array<std::complex<double>, 3>{
+            tMatrix.E00 * u[0] + multiplyFinite(tMatrix.E01, u[1]) + multiplyFinite(tMatrix.E02, u[2]),
+            multiplyFinite(std::conj(tMatrix.E01), u[0]) + tMatrix.E11 * u[1] + multiplyFinite(tMatrix.E12, u[2]),
+            multiplyFinite(std::conj(tMatrix.E02), u[0]) + multiplyFinite(std::conj(tMatrix.E12), u[1]) + tMatrix.E22 * u[2]};
+    };
+    auto dot = [](const std::array<std::complex<double>, 3>& u, const std::array<std::complex<double>, 3>& v) {
+        return multiplyFinite(std::conj(u[0]), v[0]) + multiplyFinite(std::conj(u[1]), v[1]) + multiplyFinite(std::conj(u[2]), v[2]);
+    };
+    std::array<std::complex<double>, 3> tU1 = multiply(u1);
+    std::array<std::complex<double>, 3> tU2 = multiply(u2);
+    double c11 = std::real(dot(u1, tU1));
+    double c22 = std::real(dot(u2, tU2));
+    std::complex<double> c12 = dot(u1, tU2);
+
+    // Eigenvalues mean +- r of C, eigenvector (w0, w1) of the larger one in the form without cancellation
+    double mean = (c11 + c22) / 2;
+    double d = (c11 - c22) / 2;
+    double r = std::sqrt(d * d + std::norm(c12));
+    std::complex<double> w0 = 1.0;
+    std::complex<double> w1 = 0.0;
+    if (r > 0) {
+        if (d >= 0) {
+            w0 = d + r;
+            w1 = std::conj(c12);
+        } else {
+            w0 = c12;
+            w1 = r - d;
+        }
+        double inverseWNorm = 1.0 / std::sqrt(std::norm(w0) + std::norm(w1));
+        w0 *= inverseWNorm;
+        w1 *= inverseWNorm;
+    }
+    std::array<std::complex<double>, 3> larger;
+    std::array<std::complex<double>, 3> smaller;
+    for (int64_t i = 0; i < 3; i++) {
+        larger[i] = multiplyFinite(w0, u1[i]) + multiplyFinite(w1, u2[i]);
+        smaller[i] = multiplyFinite(std::conj(w0), u2[i]) - multiplyFinite(std::conj(w1), u1[i]);
+    }
+
+    if (isLargestIsolated) {
+        decomposition.eigenValues = {isolatedEigenValue, mean + r, mean - r};
+        decomposition.eigenVectors = {isolated, larger, smaller};
+    } else {
+        decomposition.eigenValues = {mean + r, mean - r, isolatedEigenValue};
+        decomposition.eigenVectors = {larger, smaller, isolated};
+    }
+    return true;
+}
+
+inline TMatrixEigenDecomposition solveTMatrixEigen(const TMatrix& tMatrix) {
+    TMatrixEigenDecomposition decomposition;
+    if (solveTMatrixEigenAnalytic(tMatrix, decomposition)) {
+        return decomposition;
+    }
+    return solveTMatrixEigenIterative(tMatrix);
+}
+
+inline HAAlphaParameters computeHAAlpha(const TMatrixEigenDecomposition& decomposition) {
+    std::array<double, 3> probabilities;
+    double totalSum = std::abs(decomposition.eigenValues[0]) + std::abs(decomposition.eigenValues[1]) +
+                      std::abs(decomposition.eigenValues[2]);
+    for (int64_t k = 0; k < 3; k++) {
+        probabilities[k] = std::abs(decomposition.eigenValues[k]) / totalSum;
+    }
+
+    HAAlphaParameters parameters;
+    parameters.entropy = 0;
+    parameters.alpha = 0;
+    for (int64_t k = 0; k < 3; k++) {
+        // 0 * log(0) is taken as 0
+        if (probabilities[k] > 0) {
+            parameters.entropy -= probabilities[k] * (std::log(probabilities[k]) / std::log(3.0));
+        }
+        parameters.alpha += std::acos(std::min(1.0, std::abs(decomposition.eigenVectors[k][0]))) * probabilities[k];
+    }
+    parameters.anisotropy = (probabilities[1] - probabilities[2]) / (probabilities[1] + probabilities[2]);
+    return parameters;
+}
+
+#endif // TMATRIXDECOMPOSITION_H
@@ -0,0 +1,221 @@
+#ifndef TMATRIXEIGENCHECK_H
+#define TMATRIXEIGENCHECK_H
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "t_matrix.h"
+#include "tmatrixdecomposition.h"
+#include "tmatrixbatch.h"
+
+// Larger of two errors, NaN is kept: std::max(maxError, NaN) returns maxError
+inline double getMaxError(double maxError, double error) {
+    return std::isnan(maxError) || error <= maxError ? maxError : error;
+}
+
+// Coherency matrices of 7 x 7 windows of random scattering vectors with random power of the three components,
+// every 16th matrix is degenerate: of one scatterer (rank 1), of two equal components or a multiple of identity
+inline std::vector<TMatrix> generateTMatrices(int64_t matricesCount) {
+    std::mt19937_64 generator(20240611);
+    std::normal_distribution<double> normal(0.0, 1.0);
+    std::uniform_real_distribution<double> logPower(-1.5, 1.5);
+
+    std::vector<TMatrix> matrices(matricesCount);
+    for (int64_t n = 0; n < matricesCount; n++) {
+        int64_t kind = n % 16 < 13 ? 0 : n % 16 - 12;
+        std::array<double, 3> scales;
+        for (double& scale : scales) {
+            scale = std::pow(10.0, logPower(generator));
+        }
+        if (kind == 2) {
+            scales[1] = scales[0];
+        }
+        int64_t looksCount = kind == 1 ? 1 : 49;
+
+        TMatrix& t = matrices[n];
+        t = {0, 0, 0, 0, 0, 0};
+        for (int64_t look = 0; look < looksCount; look++) {
+            std::array<std::complex<double>, 3> k;
+            for (int64_t i = 0; i < 3; i++) {
+                k[i] = scales[i] * std::complex<double>(normal(generator), normal(generator));
+            }
+            t.E00 += std::norm(k[0]);
+            t.E11 += std::norm(k[1]);
+            t.E22 += std::norm(k[2]);
+            t.E01 += k[0] * std::conj(k[1]);
+            t.E02 += k[0] * std::conj(k[2]);
+            t.E12 += k[1] * std::conj(k[2]);
+        }
+        if (kind == 2) {
+            t.E01 = t.E02 = t.E12 = 0;
+            t.E11 = t.E00;
+        } else if (kind == 3) {
+            t = {scales[0], scales[0], scales[0], 0, 0, 0};
+        }
+    }
+    return matrices;
+}
+
+#ifdef T_MATRIX_BATCH_X86
+// Max errors of logAvx2 (relative to max(1, |log x|)), acosUnitAvx2 and cosThirdAcosAvx2 on a grid
+__attribute__((target("avx2")))
+inline std::array<double, 3> getBatchMathErrors() {
+    std::array<double, 3> errors = {0, 0, 0};
+    alignas(32) double values[4];
+    for (int64_t i = 0; i < 4000000; i += 4) {
+        __m256d unit = _mm256_set_pd((i + 3) / 4e6, (i + 2) / 4e6, (i + 1) / 4e6, i / 4e6);
+        __m256d positive = _mm256_set_pd(std::pow(10.0, (i + 3) / 1e5 - 20), std::pow(10.0, (i + 2) / 1e5 - 20),
+                                         std::pow(10.0, (i + 1) / 1e5 - 20), std::pow(10.0, i / 1e5 - 20));
+        alignas(32) double units[4];
+        alignas(32) double positives[4];
+        _mm256_store_pd(units, unit);
+        _mm256_store_pd(positives, positive);
+
+        _mm256_store_pd(values, logAvx2(positive));
+        for (int64_t k = 0; k < 4; k++) {
+            double reference = std::log(positives[k]);
+            errors[0] = getMaxError(errors[0], std::abs(values[k] - reference) / std::max(1.0, std::abs(reference)));
+        }
+        _mm256_store_pd(values, acosUnitAvx2(unit));
+        for (int64_t k = 0; k < 4; k++) {
+            errors[1] = getMaxError(errors[1], std::abs(values[k] - std::acos(units[k])));
+        }
+        _mm256_store_pd(values, cosThirdAcosAvx2(unit));
+        for (int64_t k = 0; k < 4; k++) {
+            errors[2] = getMaxError(errors[2], std::abs(values[k] - std::cos(std::acos(units[k]) / 3)));
+        }
+    }
+    return errors;
+}
+#endif
+
+// H / A / alpha of computeHAAlphaRow against the scalar code and the time of both
+inline bool checkTMatrixBatch(const std::vector<TMatrix>& matrices, double tolerance) {
+    int64_t count = matrices.size();
+    TMatrixRow row(count);
+    for (int64_t j = 0; j < count; j++) {
+        row.set(j, matrices[j]);
+    }
+    std::vector<double> entropy(count);
+    std::vector<double> anisotropy(count);
+    std::vector<double> alpha(count);
+
+    auto start = std::chrono::steady_clock::now();
+    computeHAAlphaRow(row, count, entropy.data(), anisotropy.data(), alpha.data());
+    auto finish = std::chrono::steady_clock::now();
+    double batchTime = std::chrono::duration<double, std::nano>(finish - start).count() / count;
+
+    double maxEntropyError = 0;
+    double maxAnisotropyError = 0;
+    double maxAlphaError = 0;
+    start = std::chrono::steady_clock::now();
+    for (int64_t j = 0; j < count; j++) {
+        TMatrixEigenDecomposition decomposition = solveTMatrixEigen(matrices[j]);
+        HAAlphaParameters parameters = computeHAAlpha(decomposition);
+        maxEntropyError = getMaxError(maxEntropyError, std::abs(entropy[j] - parameters.entropy));
+        maxAlphaError = getMaxError(maxAlphaError, std::abs(alpha[j] - parameters.alpha));
+        double scale = std::abs(decomposition.eigenValues[0]);
+        if (std::abs(decomposition.eigenValues[1]) + std::abs(decomposition.eigenValues[2]) > 1e-6 * scale) {
+            maxAnisotropyError = getMaxError(maxAnisotropyError, std::abs(anisotropy[j] - parameters.anisotropy));
+        }
+    }
+    finish = std::chrono::steady_clock::now();
+    double scalarTime = std::chrono::duration<double, std::nano>(finish - start).count() / count;
+
+    std::cout << "Batch (" << (isTMatrixBatchSupported() ? "AVX2" : "scalar") << ") max error of H = " << maxEntropyError
+              << "; A = " << maxAnisotropyError << "; alpha = " << maxAlphaError << std::endl;
+    std::cout << "Batch H / A / alpha: " << batchTime << " ns per matrix, scalar: " << scalarTime << " ns" << std::endl;
+    return maxEntropyError < tolerance && maxAnisotropyError < tolerance && maxAlphaError < tolerance;
+}
+
+// Compares solveTMatrixEigen with the iterative solver and times both, returns 0 if the eigenpairs and H / A / alpha agree
+inline int runTMatrixEigenCheck(int64_t matricesCount) {
+    constexpr double EIGEN_TOLERANCE = 1e-10;
+    constexpr double PARAMETERS_TOLERANCE = 1e-6;
+    constexpr double ILL_CONDITIONED_THRESHOLD = 1e-6;
+    std::vector<TMatrix> matrices = generateTMatrices(matricesCount);
+
+    int64_t fallbacksCount = 0;
+    double maxEigenValueError = 0;
+    double maxEigenVectorError = 0;
+    double maxEntropyError = 0;
+    double maxAnisotropyError = 0;
+    double maxAlphaError = 0;
+    for (const TMatrix& t : matrices) {
+        TMatrixEigenDecomposition reference = solveTMatrixEigenIterative(t);
+        TMatrixEigenDecomposition decomposition;
+        if (!solveTMatrixEigenAnalytic(t, decomposition)) {
+            fallbacksCount++;
+            continue;
+        }
+
+        // Eigenvectors of (nearly) multiple eigenvalues and the anisotropy of two (nearly) zero eigenvalues are
+        // defined by rounding errors only, they are not compared
+        double scale = std::abs(reference.eigenValues[0]);
+        double minDefinedGap = ILL_CONDITIONED_THRESHOLD * scale;
+        for (int64_t k = 0; k < 3; k++) {
+            maxEigenValueError = getMaxError(maxEigenValueError, std::abs(decomposition.eigenValues[k] - reference.eigenValues[k]) / scale);
+            double gap = std::min(std::abs(reference.eigenValues[k] - reference.eigenValues[(k + 1) % 3]),
+                                  std::abs(reference.eigenValues[k] - reference.eigenValues[(k + 2) % 3]));
+            if (gap <= minDefinedGap) {
+                continue;
+            }
+            std::complex<double> product = 0;
+            for (int64_t i = 0; i < 3; i++) {
+                product += std::conj(reference.eigenVectors[k][i]) * decomposition.eigenVectors[k][i];
+            }
+            maxEigenVectorError = getMaxError(maxEigenVectorError, 1 - std::abs(product));
+        }
+
+        HAAlphaParameters referenceParameters = computeHAAlpha(reference);
+        HAAlphaParameters parameters = computeHAAlpha(decomposition);
+        maxEntropyError = getMaxError(maxEntropyError, std::abs(parameters.entropy - referenceParameters.entropy));
+        if (std::abs(reference.eigenValues[1]) + std::abs(reference.eigenValues[2]) > minDefinedGap) {
+            maxAnisotropyError = getMaxError(maxAnisotropyError, std::abs(parameters.anisotropy - referenceParameters.anisotropy));
+        }
+        maxAlphaError = getMaxError(maxAlphaError, std::abs(parameters.alpha - referenceParameters.alpha));
+    }
+
+    std::cout << "Matrices: " << matricesCount << "; solved iteratively: " << fallbacksCount << std::endl;
+    std::cout << "Max relative eigenvalue error: " << maxEigenValueError << std::endl;
+    std::cout << "Max eigenvector error (1 - |<v, v_ref>|): " << maxEigenVectorError << std::endl;
+    std::cout << "Max error of H = " << maxEntropyError << "; A = " << maxAnisotropyError << "; alpha = " << maxAlphaError << std::endl;
+
+    auto measure = [&matrices](auto solve) {
+        double checksum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const TMatrix& t : matrices) {
+            TMatrixEigenDecomposition decomposition = solve(t);
+            checksum += decomposition.eigenValues[1] + std::abs(decomposition.eigenVectors[0][0]);
+        }
+        auto finish = std::chrono::steady_clock::now();
+        double nanoseconds = std::chrono::duration<double, std::nano>(finish - start).count();
+        return std::make_pair(nanoseconds / matrices.size(), checksum);
+    };
+    auto iterativeTime = measure([](const TMatrix& t) { return solveTMatrixEigenIterative(t); });
+    auto analyticTime = measure([](const TMatrix& t) { return solveTMatrixEigen(t); });
+    std::cout << "Iterative: " << iterativeTime.first << " ns per matrix (checksum " << iterativeTime.second << ")" << std::endl;
+    std::cout << "Analytic: " << analyticTime.first << " ns per matrix (checksum " << analyticTime.second << ")" << std::endl;
+
+#ifdef T_MATRIX_BATCH_X86
+    if (isTMatrixBatchSupported()) {
+        std::array<double, 3> mathErrors = getBatchMathErrors();
+        std::cout << "Vector math max error: log = " << mathErrors[0] << "; acos = " << mathErrors[1]
+                  << "; cos(acos / 3) = " << mathErrors[2] << std::endl;
+    }
+#endif
+    bool isBatchAccurate = checkTMatrixBatch(matrices, PARAMETERS_TOLERANCE);
+
+    bool isAccurate = maxEigenValueError < EIGEN_TOLERANCE && maxEigenVectorError < EIGEN_TOLERANCE &&
+                      maxEntropyError < PARAMETERS_TOLERANCE && maxAnisotropyError < PARAMETERS_TOLERANCE &&
+                      maxAlphaError < PARAMETERS_TOLERANCE && isBatchAccurate;
+    std::cout << (isAccurate ? "Check passed" : "Check failed") << std::endl;
+    return isAccurate ? 0 : 1;
+}
+
+#endif // TMATRIXEIGENCHECK_H
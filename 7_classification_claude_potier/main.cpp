@@ -11,6 +11,7 @@
 #include "bitmap.h"
 #include "bitmap.h"
 #include "t_matrix.h"
+#include "../common/mappedbitmap.h"
 
 using namespace std;
 
@@ -318,14 +319,11 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    ifstream inputStream;
-    inputStream.open(argv[2], ios_base::binary);
-
-    ofstream outputStream;
-    outputStream.open(argv[3], ios_base::binary);
-
-    if (!inputStream.is_open() || !outputStream.is_open()) {
-        cerr << "Can't open input files!" << endl;
+    std::unique_ptr<MappedBitmapReader> input;
+    try {
+        input = std::make_unique<MappedBitmapReader>(argv[2]);
+    } catch (const std::exception& exception) {
+        cerr << exception.what() << endl;
         return 2;
     }
 
@@ -355,27 +353,20 @@ int main(int argc, char** argv) {
     BitmapFileHeader bitmapInputFileHeader;
     BitmapInfoHeaderV3 bitmapInputInfoHeader;
 
-    inputStream.read((char*)&bitmapInputFileHeader, sizeof(BitmapFileHeader));
-    if (bitmapInputFileHeader.bfType != 0x4d42 || inputStream.fail()) {
-        cerr << "Not BMP file!" << endl;
-        return 3;
-    }
-
-    inputStream.read((char*)&bitmapInputInfoHeader, sizeof(BitmapInfoHeaderV3));
-    inputStream.seekg(bitmapInputFileHeader.bfOffBits, ios_base::beg);
-
-    if (inputStream.fail()) {
-        cerr << "Error reading source file!" << endl;
+    try {
+        input->readHeaders(bitmapInputFileHeader, bitmapInputInfoHeader);
+    } catch (const std::exception& exception) {
+        cerr << exception.what() << endl;
         return 4;
     }
 
-    if (bitmapInputInfoHeader.biBitCount != 24) {
+    if (input->getBitCount() != 24) {
         cerr << "Not 24 bit BMP file!" << endl;
         return 5;
     }
 
-    int32_t inputWidthPx = bitmapInputInfoHeader.biWidth;
-    int32_t inputHeightPx = bitmapInputInfoHeader.biHeight;
+    int32_t inputWidthPx = input->getWidth();
+    int32_t inputHeightPx = input->getHeight();
 
     int32_t outputWidthPx = inputWidthPx;
     int32_t outputHeight = inputHeightPx;
@@ -383,24 +374,23 @@ int main(int argc, char** argv) {
     BitmapFileHeader bitmapOutputFileHeader = bitmapInputFileHeader;
     BitmapInfoHeaderV3 bitmapOutputInfoHeader = bitmapInputInfoHeader;
 
-    uint64_t inputRowBytesCountWithoutPadding = inputWidthPx * 3;
     uint64_t outputRowBytesCountWithoutPadding = outputWidthPx * 3;
-
-    uint64_t inputRowBytesCountWithPadding = getRowSizeWithPadding(inputRowBytesCountWithoutPadding);
     uint64_t outputRowBytesCountWithPadding = getRowSizeWithPadding(outputRowBytesCountWithoutPadding);
 
-    uint64_t paddingBytes = inputRowBytesCountWithPadding - inputRowBytesCountWithoutPadding;
-
-    std::unique_ptr<const Bitmap24Pixel[]> inputRow = std::make_unique<Bitmap24Pixel[]>(inputWidthPx);
-    std::unique_ptr<Bitmap24Pixel[]> outputRow = std::make_unique<Bitmap24Pixel[]>(outputWidthPx + 1);
-
     bitmapOutputFileHeader.bfSize = sizeof(BitmapFileHeader) + sizeof(BitmapInfoHeaderV3) + outputRowBytesCountWithPadding * outputHeight;
     bitmapOutputFileHeader.bfOffBits = sizeof(BitmapFileHeader) + sizeof(BitmapInfoHeaderV3);
-    outputStream.write((char*)&bitmapOutputFileHeader, sizeof(BitmapFileHeader));
-    outputStream.write((char*)&bitmapOutputInfoHeader, sizeof(BitmapInfoHeaderV3));
 
     bitmapOutputInfoHeader.biWidth = outputWidthPx;
     bitmapOutputInfoHeader.biHeight = outputHeight;
+
+    std::unique_ptr<MappedBitmapWriter> output;
+    try {
+        output = std::make_unique<MappedBitmapWriter>(argv[3], bitmapOutputFileHeader, bitmapOutputInfoHeader,
+                                                      outputWidthPx, outputHeight);
+    } catch (const std::exception& exception) {
+        cerr << exception.what() << endl;
+        return 2;
+    }
     std::vector<Eigen::Matrix3cd> tMatrix(inputWidthPx * inputHeightPx); //rawFile
     vector<int> classifications(inputWidthPx * inputHeightPx);
 
@@ -420,14 +410,8 @@ int main(int argc, char** argv) {
         }
     }
 
-    inputStream.seekg(bitmapInputFileHeader.bfOffBits, ios_base::beg);
-
     for (int32_t i = 0; i < inputHeightPx; i++) {
-        inputStream.read((char*)inputRow.get(), inputRowBytesCountWithoutPadding);
-        inputStream.seekg(paddingBytes, ios_base::cur);
-        if (inputStream.fail()) {
-            cerr << "Error reading source image!" << endl;
-        }
+        const Bitmap24Pixel* inputRow = reinterpret_cast<const Bitmap24Pixel*>(input->getRow(i));
         for (int32_t j = 0; j < inputWidthPx; j++) {
             if (workMode == WorkMode::ClassificateWishart16 || workMode == WorkMode::Classificate16) {
                 classifications[i * inputWidthPx + j] = static_cast<int>(classificateClaudePotierExtendedToZone((inputRow[j])));
@@ -442,8 +426,6 @@ int main(int argc, char** argv) {
         classesCount = 17;
     }
 
-    inputStream.seekg(bitmapInputFileHeader.bfOffBits, ios_base::beg);
-
     vector<Eigen::Matrix3cd> T_avg(classesCount, Eigen::Matrix3cd::Zero());
     vector<int64_t> dividers(classesCount, 0);
     for (int64_t i = 0; i < tMatrix.size(); i++) {
@@ -468,11 +450,7 @@ int main(int argc, char** argv) {
     }
 
     for (int32_t i = 0; i < inputHeightPx; i++) {
-        inputStream.read((char*)inputRow.get(), inputRowBytesCountWithoutPadding);
-        inputStream.seekg(paddingBytes, ios_base::cur);
-        if (inputStream.fail()) {
-            cerr << "Error reading source image!" << endl;
-        }
+        Bitmap24Pixel* outputRow = reinterpret_cast<Bitmap24Pixel*>(output->getRow(i));
         for (int32_t j = 0; j < inputWidthPx; j++) {
             int pixelIndex = i * inputWidthPx + j;
             int pixelClass = classifications[pixelIndex];
@@ -482,11 +460,8 @@ int main(int argc, char** argv) {
                 outputRow[j] = getPixelByZone(static_cast<ZoneClaudePotier16>(pixelClass));
             }
         }
-        outputStream.write((char*)outputRow.get(), outputRowBytesCountWithPadding);
     }
 
-    outputStream.close();
-    inputStream.close();
     cout << "Success!" << endl;
     return 0;
 }
@@ -3,31 +3,107 @@
 
 #include <cmath>
 #include <memory>
-#include "pixeltraits.h"
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+#ifdef __linux__
+#include <unistd.h>
+#endif
+#include "../common/pixeltraits.h"
+#include "../common/interpolationmode.h"
 #include "bitmap.h"
-#include "imagenecessaryinfo.h"
-#include "rotatematrix.h"
+#include "../common/imagenecessaryinfo.h"
+#include "../common/rotatematrix.h"
+#include "../common/affinegather.h"
+#include "hugepagearray.h"
 
-enum class InterpolationMode
+enum class RotationMode
 {
-    NearestNeighbour,
-    Bilinear,
-    Bicubic,
-    Lanczos3
+    Direct,
+    ThreeShear
 };
 
 template<typename PixelType = Bitmap24Pixel>
 class BitmapMatrix {
-    std::unique_ptr<Bitmap24Pixel[]> _bitmap;
+    HugePageArray<PixelType> _bitmap;
     int64_t _width;
     int64_t _height;
     PixelType _defaultPixelType = PixelTraits<PixelType>::getDefaultPixel();
 
+    // Kernel radius around the reverse mapped tile, enough for every interpolation mode
+    static constexpr int64_t TILE_SOURCE_MARGIN = MAX_INTERPOLATION_RADIUS;
+
+    // Source pixels of the current output tile, see calculateOutputTile
+    std::vector<PixelType> _tileSource;
+
+    // Source coordinates are calculated for blocks of RotateMatrix::ROW_BLOCK_LENGTH pixels,
+    // nearest neighbour skips bounds checks of every pixel. Where AVX2 is available Bitmap24Pixel bilinear is interpolated
+    // 4 pixels at once, the kernel table modes 8 pixels at once in float.
+    // Pixels of parPlane are the same as of _bitmap, the rest is read from _bitmap.
+    void calculateOutputRowSegment(int64_t parRow, int64_t parFirstCol, int64_t parColsCount, const ImageNecessaryInfo& parOutputImageInfo,
+                                   PixelType* parOutPixels, InterpolationMode parInterpolationMode, const GatherPlane<PixelType>& parPlane) {
+        double xs[RotateMatrix::ROW_BLOCK_LENGTH];
+        double ys[RotateMatrix::ROW_BLOCK_LENGTH];
+
+        bool isVectorPlane = std::is_same_v<PixelType, Bitmap24Pixel> && isAffineGatherSupported(parPlane);
+
+        for (int64_t blockBegin = 0; blockBegin < parColsCount; blockBegin += RotateMatrix::ROW_BLOCK_LENGTH) {
+            int64_t blockLength = std::min<int64_t>(RotateMatrix::ROW_BLOCK_LENGTH, parColsCount - blockBegin);
+            parOutputImageInfo.getRotateMatrix().getXYReverseRowCoordinates(parFirstCol + blockBegin, parRow, blockLength, xs, ys);
+            PixelType* outBlock = parOutPixels + blockBegin;
+
+            if (parInterpolationMode == InterpolationMode::NearestNeighbour) {
+                gatherNearest(parPlane, xs, ys, blockLength, outBlock, _defaultPixelType);
+                continue;
+            }
+            int64_t k = 0;
+            if constexpr (std::is_same_v<PixelType, Bitmap24Pixel>) {
+#ifdef AFFINE_GATHER_X86
+                if (isVectorPlane) {
+                    auto fallback = [&](int64_t l) { outBlock[l] = calculatePixel(xs[l], ys[l], parInterpolationMode); };
+                    if (parInterpolationMode == InterpolationMode::Bilinear) {
+                        k = interpolateBilinearAvx2(parPlane, xs, ys, blockLength, outBlock, fallback);
+                    } else {
+                        visitInterpolationKernel(parInterpolationMode, [&](auto parKernel) {
+                            k = interpolateKernelAvx2<decltype(parKernel)>(parPlane, xs, ys, blockLength, outBlock, fallback);
+                        });
+                    }
+                }
+#endif
+            }
+            for (; k < blockLength; k++) {
+                outBlock[k] = calculatePixel(xs[k], ys[k], parInterpolationMode);
+            }
+        }
+    }
+
+    // Pixels (floor(y) - RADIUS + 1 .. floor(y) + RADIUS) x (floor(x) - RADIUS + 1 .. floor(x) + RADIUS) weighted by KERNEL_TABLE<Kernel>
+    template<typename Kernel>
+    PixelType interpolateKernel(double parX, double parY) {
+        constexpr int64_t TAPS_COUNT = 2 * Kernel::RADIUS;
+        int64_t x1 = floor(parX);
+        int64_t y1 = floor(parY);
+        PixelType pixels[TAPS_COUNT][TAPS_COUNT];
+        for (int64_t j = 0; j < TAPS_COUNT; j++) {
+            for (int64_t i = 0; i < TAPS_COUNT; i++) {
+                pixels[j][i] = *(*this)(y1 + j - Kernel::RADIUS + 1, x1 + i - Kernel::RADIUS + 1);
+            }
+        }
+        return PixelTraits<PixelType>::template interpolateKernel<Kernel>(pixels, parX - x1, parY - y1);
+    }
+
+    GatherPlane<PixelType> getPlane() const {
+        return {_bitmap.get(), _width, 0, _height - 1, 0, _width - 1};
+    }
+
 public:
     BitmapMatrix(int64_t parWidth, int64_t parHeight) {
         _width = parWidth;
         _height = parHeight;
-        _bitmap = std::make_unique<PixelType[]>(parWidth * parHeight);
+        // One more pixel, so the last one can be loaded as a 32-bit word
+        _bitmap = makeHugePageArray<PixelType>(parWidth * parHeight + 1);
+        _bitmap[parWidth * parHeight] = PixelType();
     }
 
     uint32_t getWidth() const {
@@ -91,58 +167,121 @@ public:
         };
     }
 
+    PixelType calculatePixel(double parX, double parY, InterpolationMode parInterpolationMode) {
+        if ((int)parY < 0 || (int)parX < 0 || (int)parY >= getHeight() || (int)parX >= getWidth()) {
+            return _defaultPixelType;
+        }
+
+        if (parInterpolationMode == InterpolationMode::NearestNeighbour) {
+            return *(*this)(static_cast<int64_t>(parY), static_cast<int64_t>(parX));
+        }
+        int x1 = floor(parX);
+        int y1 = floor(parY);
+        int x2 = ceil(parX);
+        int y2 = ceil(parY);
+        double dx = parX - x1;
+        double dy = parY - y1;
+
+        if (parInterpolationMode == InterpolationMode::Bilinear) {
+
+            PixelType p1 = *(*this)(y1, x1);
+            PixelType p2 = *(*this)(y1, x2);
+            PixelType p3 = *(*this)(y2, x1);
+            PixelType p4 = *(*this)(y2, x2);
+
+
+            return PixelTraits<PixelType>::interpolateBilinear(p1, p2, p3, p4, dx, dy);
+        } else if (parInterpolationMode == InterpolationMode::Bicubic) {
+            PixelType pixels[4][4];
+            for (int j = -2; j < 2; ++j) {
+                for (int k = -2; k < 2; ++k) {
+                    pixels[j + 2][k + 2] = *(*this)(y1 + j, x1 + k);
+                }
+            }
+            return PixelTraits<PixelType>::interpolateBicubic(pixels, dx, dy);
+        }
+
+        PixelType pixel = _defaultPixelType;
+        visitInterpolationKernel(parInterpolationMode, [&](auto parKernel) {
+            pixel = interpolateKernel<decltype(parKernel)>(parX, parY);
+        });
+        return pixel;
+    }
+
     void calculateOutputRow(int64_t parRow, const ImageNecessaryInfo& parOutputImageInfo,
                             PixelType* parOutPixelRow, InterpolationMode parInterpolationMode = InterpolationMode::Bicubic) {
-        for (int64_t i = 0; i < parOutputImageInfo.getWidth(); i++) {
-            std::pair<double, double> pixelCoordinates = parOutputImageInfo.getRotateMatrix().getXYReverseCoordinates(i, parRow);
-            double x = pixelCoordinates.first;
-            double y = pixelCoordinates.second;
+        calculateOutputRowSegment(parRow, 0, parOutputImageInfo.getWidth(), parOutputImageInfo, parOutPixelRow, parInterpolationMode, getPlane());
+    }
 
-            if ((int)y < 0 || (int)x < 0 || (int)y >= getHeight() || (int)x >= getWidth()) {
-                parOutPixelRow[i] = _defaultPixelType;
-                continue;
+    // Side of square output tiles whose pixels and source working set (see calculateOutputTile) fit in half of L2
+    int64_t getOutputTileSide(const ImageNecessaryInfo& parOutputImageInfo) const {
+        int64_t cacheSize = 1024 * 1024;
+#ifdef _SC_LEVEL2_CACHE_SIZE
+        if (sysconf(_SC_LEVEL2_CACHE_SIZE) > 0) {
+            cacheSize = sysconf(_SC_LEVEL2_CACHE_SIZE);
+        }
+#endif
+        const RotateMatrix& rotateMatrix = parOutputImageInfo.getRotateMatrix();
+        // Source side of one output pixel side
+        double scale = (std::abs(cos(rotateMatrix.getPhi())) + std::abs(sin(rotateMatrix.getPhi()))) / rotateMatrix.getZoom();
+        int64_t side = RotateMatrix::ROW_BLOCK_LENGTH / 4;
+        while (side < 4096) {
+            int64_t nextSide = side * 2;
+            double sourceSide = nextSide * scale + 2 * TILE_SOURCE_MARGIN;
+            if ((sourceSide * sourceSide + nextSide * nextSide) * sizeof(PixelType) > cacheSize / 2) {
+                break;
             }
+            side = nextSide;
+        }
+        return side;
+    }
 
-            if (parInterpolationMode == InterpolationMode::NearestNeighbour) {
-                parOutPixelRow[i] = *(*this)(static_cast<int64_t>(pixelCoordinates.second),
-                                             static_cast<int64_t>(pixelCoordinates.first));
-                continue;
-            }
-            int x1 = floor(pixelCoordinates.first);
-            int y1 = floor(pixelCoordinates.second);
-            int x2 = ceil(pixelCoordinates.first);
-            int y2 = ceil(pixelCoordinates.second);
-            double dx = pixelCoordinates.first - x1;
-            double dy = pixelCoordinates.second - y1;
-
-            if (parInterpolationMode == InterpolationMode::Bilinear) {
-
-                PixelType p1 = *(*this)(y1, x1);
-                PixelType p2 = *(*this)(y1, x2);
-                PixelType p3 = *(*this)(y2, x1);
-                PixelType p4 = *(*this)(y2, x2);
-
-
-                parOutPixelRow[i] = PixelTraits<PixelType>::interpolateBilinear(p1, p2, p3, p4, dx, dy);
-            } else if (parInterpolationMode == InterpolationMode::Bicubic) {
-                PixelType pixels[4][4];
-                for (int j = -2; j < 2; ++j) {
-                    for (int k = -2; k < 2; ++k) {
-                        pixels[j + 2][k + 2] = *(*this)(y1 + j, x1 + k);
-                    }
+    // Output rows parFirstRow.. x cols parFirstCol.., parGetOutputRow(row) returns the whole output row.
+    // The tile's source working set is the bounding box of its reverse mapped corners plus the kernel radius. With
+    // parIsSourceCopied it is copied into a contiguous buffer first, so nearest neighbour and the AVX2 interpolations
+    // read a few pages instead of one page per source row. The result is the same as of calculateOutputRow.
+    template<typename OutputRowFunction>
+    void calculateOutputTile(int64_t parFirstRow, int64_t parRowsCount, int64_t parFirstCol, int64_t parColsCount,
+                             const ImageNecessaryInfo& parOutputImageInfo, OutputRowFunction parGetOutputRow,
+                             InterpolationMode parInterpolationMode, bool parIsSourceCopied) {
+        GatherPlane<PixelType> plane = getPlane();
+        bool isPlaneUsed = parInterpolationMode == InterpolationMode::NearestNeighbour ||
+                           (std::is_same_v<PixelType, Bitmap24Pixel> && (parInterpolationMode == InterpolationMode::Bilinear ||
+                                                                         isKernelTableInterpolation(parInterpolationMode)));
+        if (parIsSourceCopied && isPlaneUsed) {
+            double minX = INFINITY;
+            double maxX = -INFINITY;
+            double minY = INFINITY;
+            double maxY = -INFINITY;
+            for (int64_t row : {parFirstRow, parFirstRow + parRowsCount - 1}) {
+                for (int64_t col : {parFirstCol, parFirstCol + parColsCount - 1}) {
+                    std::pair<double, double> coordinates = parOutputImageInfo.getRotateMatrix().getXYReverseCoordinates(col, row);
+                    minX = std::min(minX, coordinates.first);
+                    maxX = std::max(maxX, coordinates.first);
+                    minY = std::min(minY, coordinates.second);
+                    maxY = std::max(maxY, coordinates.second);
                 }
-                parOutPixelRow[i] = PixelTraits<PixelType>::interpolateBicubic(pixels, dx, dy);
-            } else if (parInterpolationMode == InterpolationMode::Lanczos3) {
-                PixelType pixels[6][6];
-                for (int j = -2; j <= 3; ++j) {
-                    for (int i = -2; i <= 3; ++i) {
-                        pixels[j + 2][i + 2] = *(*this)(static_cast<int64_t>(pixelCoordinates.second) + j,
-                                                        static_cast<int64_t>(pixelCoordinates.first) + i);
-                    }
+            }
+            int64_t minCol = std::max<int64_t>(0, static_cast<int64_t>(floor(minX)) - TILE_SOURCE_MARGIN);
+            int64_t maxCol = std::min<int64_t>(_width - 1, static_cast<int64_t>(ceil(maxX)) + TILE_SOURCE_MARGIN);
+            int64_t minRow = std::max<int64_t>(0, static_cast<int64_t>(floor(minY)) - TILE_SOURCE_MARGIN);
+            int64_t maxRow = std::min<int64_t>(_height - 1, static_cast<int64_t>(ceil(maxY)) + TILE_SOURCE_MARGIN);
+            if (minCol > maxCol || minRow > maxRow) {
+                // Whole tile is outside of the source
+                plane = {_bitmap.get(), _width, 0, -1, 0, -1};
+            } else {
+                int64_t stride = maxCol - minCol + 1;
+                _tileSource.resize(stride * (maxRow - minRow + 1) + 1);
+                for (int64_t row = minRow; row <= maxRow; row++) {
+                    memcpy(_tileSource.data() + (row - minRow) * stride, _bitmap.get() + row * _width + minCol, stride * sizeof(PixelType));
                 }
-                parOutPixelRow[i] = PixelTraits<PixelType>::interpolateLanczos(pixels, dx, dy);
+                plane = {_tileSource.data(), stride, minRow, maxRow, minCol, maxCol};
             }
+        }
 
+        for (int64_t row = parFirstRow; row < parFirstRow + parRowsCount; row++) {
+            calculateOutputRowSegment(row, parFirstCol, parColsCount, parOutputImageInfo, parGetOutputRow(row) + parFirstCol,
+                                      parInterpolationMode, plane);
         }
     }
 };
@@ -0,0 +1,55 @@
+#ifndef HUGEPAGEARRAY_H
+#define HUGEPAGEARRAY_H
+
+#include <memory>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// Arrays of at least HUGE_PAGE_SIZE are aligned to it and advised to be backed by transparent huge pages:
+// rotation at arbitrary angles reads a new source row almost every pixel, with 4 KiB pages that is a TLB miss.
+// Elements are not initialized.
+constexpr uint64_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+template<typename T>
+struct HugePageArrayDeleter {
+    void operator()(T* parArray) const {
+#ifdef __linux__
+        std::free(parArray);
+#else
+        ::operator delete[](parArray);
+#endif
+    }
+};
+
+template<typename T>
+using HugePageArray = std::unique_ptr<T[], HugePageArrayDeleter<T>>;
+
+template<typename T>
+HugePageArray<T> makeHugePageArray(uint64_t parCount) {
+    uint64_t size = parCount * sizeof(T);
+#ifdef __linux__
+    if (size >= HUGE_PAGE_SIZE) {
+        size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        void* array = std::aligned_alloc(HUGE_PAGE_SIZE, size);
+        if (!array) {
+            throw std::bad_alloc();
+        }
+        madvise(array, size, MADV_HUGEPAGE);
+        return HugePageArray<T>(static_cast<T*>(array));
+    }
+    void* array = std::malloc(size);
+    if (!array) {
+        throw std::bad_alloc();
+    }
+    return HugePageArray<T>(static_cast<T*>(array));
+#else
+    return HugePageArray<T>(static_cast<T*>(::operator new[](size)));
+#endif
+}
+
+#endif // HUGEPAGEARRAY_H
@@ -1,29 +1,40 @@
 #include "bitmap.h"
 #include "bitmapmatrix.h"
+#include "separableresampler.h"
+#include "shearrotator.h"
+#include "pixelrotationcheck.h"
+#include "../common/kerneltablecheck.h"
+#include "../common/mappedbitmap.h"
 
 #include <cstring>
 #include <iostream>
 #include <cstdint>
-#include <fstream>
 #include <memory>
+#include <algorithm>
 
 using namespace std;
 
 
 int main(int argc, char** argv) {
+    // -check-pixels: rotation of linear planes of Bitmap24Pixel and of the TIFF pixel types
+    if (argc >= 2 && !strcmp(argv[1], "-check-pixels")) {
+        return runPixelRotationCheck();
+    }
+    // -check-kernels: rows of the interpolation kernel tables against the kernel functions
+    if (argc >= 2 && !strcmp(argv[1], "-check-kernels")) {
+        return runKernelTableCheck();
+    }
+
     if (argc < 6) {
         cerr << "Wrong parameters count!" << endl;
         return 1;
     }
 
-    ifstream inputStream;
-    inputStream.open(argv[1], ios_base::binary);
-
-    ofstream outputStream;
-    outputStream.open(argv[2], ios_base::binary);
-
-    if (!inputStream.is_open() || !outputStream.is_open()) {
-        cerr << "Can't open input files!" << endl;
+    std::unique_ptr<MappedBitmapReader> input;
+    try {
+        input = std::make_unique<MappedBitmapReader>(argv[1]);
+    } catch (const std::exception& exception) {
+        cerr << exception.what() << endl;
         return 2;
     }
 
@@ -36,15 +47,7 @@ int main(int argc, char** argv) {
     }
 
     InterpolationMode interpolationMode;
-    if (!strcmp("--nearestNeighbour", argv[4])) {
-        interpolationMode = InterpolationMode::NearestNeighbour;
-    } else if (!strcmp("--bilinear", argv[4])) {
-        interpolationMode = InterpolationMode::Bilinear;
-    } else if (!strcmp("--bicubic", argv[4])) {
-        interpolationMode = InterpolationMode::Bicubic;
-    } else if (!strcmp("--lanczos3", argv[4])) {
-        interpolationMode = InterpolationMode::Lanczos3;
-    } else {
+    if (!parseInterpolationMode(argv[4], interpolationMode)) {
         cerr << "Can't parse interpolation mode!" << endl;
         return 4;
     }
@@ -61,52 +64,47 @@ int main(int argc, char** argv) {
         return 5;
     }
 
-    BitmapFileHeader bitmapInputFileHeader;
-    BitmapInfoHeaderV3 bitmapInputInfoHeader;
-
-    inputStream.read((char*)&bitmapInputFileHeader, sizeof(BitmapFileHeader));
-    if (bitmapInputFileHeader.bfType != 0x4d42 || inputStream.fail()) {
-        cerr << "Not BMP file!" << endl;
-        return 5;
+    RotationMode rotationMode = RotationMode::Direct;
+    if (argc > 6) {
+        if (!strcmp("--direct", argv[6])) {
+            rotationMode = RotationMode::Direct;
+        } else if (!strcmp("--threeShear", argv[6])) {
+            rotationMode = RotationMode::ThreeShear;
+        } else {
+            cerr << "Can't parse rotation mode!" << endl;
+            return 8;
+        }
     }
 
-    inputStream.read((char*)&bitmapInputInfoHeader, sizeof(BitmapInfoHeaderV3));
-    inputStream.seekg(bitmapInputFileHeader.bfOffBits, ios_base::beg);
+    BitmapFileHeader bitmapInputFileHeader;
+    BitmapInfoHeaderV3 bitmapInputInfoHeader;
 
-    if (inputStream.fail()) {
-        cerr << "Error reading source file!" << endl;
+    try {
+        input->readHeaders(bitmapInputFileHeader, bitmapInputInfoHeader);
+    } catch (const std::exception& exception) {
+        cerr << exception.what() << endl;
         return 6;
     }
 
-    if (bitmapInputInfoHeader.biBitCount != 24) {
+    if (input->getBitCount() != 24) {
         cerr << "Not 24 bit BMP file!" << endl;
         return 7;
     }
 
-    int32_t inputWidthPx = bitmapInputInfoHeader.biWidth;
-    int32_t inputHeightPx = bitmapInputInfoHeader.biHeight;
+    int32_t inputWidthPx = input->getWidth();
+    int32_t inputHeightPx = input->getHeight();
 
     BitmapFileHeader bitmapOutputFileHeader = bitmapInputFileHeader;
     BitmapInfoHeaderV3 bitmapOutputInfoHeader = bitmapInputInfoHeader;
 
     uint64_t inputRowBytesCountWithoutPadding = inputWidthPx * 3;
 
-    uint64_t inputRowBytesCountWithPadding = getRowSizeWithPadding(inputRowBytesCountWithoutPadding);
-
-    uint64_t inputPaddingBytes = inputRowBytesCountWithPadding - inputRowBytesCountWithoutPadding;
-
     BitmapMatrix inputBitmapMatrix(inputWidthPx, inputHeightPx);
 
-    inputStream.seekg(bitmapInputFileHeader.bfOffBits, ios_base::beg);
+    input->adviseSequential();
     for (int64_t i = 0; i < inputHeightPx; i++) {
         uint64_t row = inputHeightPx - i - 1;
-        inputStream.read(reinterpret_cast<char*>(inputBitmapMatrix(row)), inputRowBytesCountWithoutPadding);
-        inputStream.seekg(inputPaddingBytes, ios::cur);
-    }
-
-    if (inputStream.fail()) {
-        cerr << "Error reading source file!" << endl;
-        return 8;
+        memcpy(inputBitmapMatrix(row), input->getRow(i), inputRowBytesCountWithoutPadding);
     }
 
     ImageNecessaryInfo outputImageInfo = inputBitmapMatrix.getRotatedImageInfo(degrees * M_PI / 180, zoom);
@@ -119,20 +117,45 @@ int main(int argc, char** argv) {
 
     uint64_t outputRowBytesCountWithoutPadding = outputWidthPx * 3;
     uint64_t outputRowBytesCountWithPadding = getRowSizeWithPadding(outputRowBytesCountWithoutPadding);
-    uint64_t outputPaddingBytes = outputRowBytesCountWithPadding - outputRowBytesCountWithoutPadding;
 
     bitmapOutputFileHeader.bfSize = sizeof(BitmapFileHeader) + sizeof(BitmapInfoHeaderV3) + outputRowBytesCountWithPadding * outputHeightPx;
     bitmapOutputFileHeader.bfOffBits = sizeof(BitmapFileHeader) + sizeof(BitmapInfoHeaderV3);
-    outputStream.write((char*)&bitmapOutputFileHeader, sizeof(BitmapFileHeader));
-    outputStream.write((char*)&bitmapOutputInfoHeader, sizeof(BitmapInfoHeaderV3));
 
-    std::unique_ptr<Bitmap24Pixel[]> outputRow = std::make_unique<Bitmap24Pixel[]>(outputWidthPx);
+    std::unique_ptr<MappedBitmapWriter> output;
+    try {
+        output = std::make_unique<MappedBitmapWriter>(argv[2], bitmapOutputFileHeader, bitmapOutputInfoHeader,
+                                                      outputWidthPx, outputHeightPx);
+    } catch (const std::exception& exception) {
+        cerr << exception.what() << endl;
+        return 2;
+    }
+
+    auto getOutputRow = [&](int64_t parRow) {
+        return reinterpret_cast<Bitmap24Pixel*>(output->getRow(outputHeightPx - parRow - 1));
+    };
+
+    if (rotationMode == RotationMode::ThreeShear) {
+        ShearRotator shearRotator(inputBitmapMatrix, outputImageInfo, interpolationMode);
+        shearRotator.rotate(getOutputRow);
+        return 0;
+    }
+
+    if (SeparableResampler::isSupported(outputImageInfo, interpolationMode)) {
+        SeparableResampler separableResampler(inputBitmapMatrix, outputImageInfo, interpolationMode);
+        for (int64_t i = 0; i < outputHeightPx; i++) {
+            uint64_t row = outputHeightPx - i - 1;
+            separableResampler.calculateOutputRow(row, reinterpret_cast<Bitmap24Pixel*>(output->getRow(i)));
+        }
+        return 0;
+    }
 
-    for (int64_t i = 0; i < outputHeightPx; i++) {
-        uint64_t row = outputHeightPx - i - 1;
-        inputBitmapMatrix.calculateOutputRow(row, outputImageInfo, outputRow.get(), interpolationMode);
-        outputStream.write(reinterpret_cast<char*>(outputRow.get()), outputRowBytesCountWithoutPadding);
-        outputStream.write(reinterpret_cast<char*>(outputRow.get()), outputPaddingBytes);
+    int64_t tileSide = inputBitmapMatrix.getOutputTileSide(outputImageInfo);
+    for (int64_t firstRow = 0; firstRow < outputHeightPx; firstRow += tileSide) {
+        for (int64_t firstCol = 0; firstCol < outputWidthPx; firstCol += tileSide) {
+            inputBitmapMatrix.calculateOutputTile(firstRow, std::min(tileSide, outputHeightPx - firstRow),
+                                                  firstCol, std::min(tileSide, outputWidthPx - firstCol),
+                                                  outputImageInfo, getOutputRow, interpolationMode, true);
+        }
     }
 
     return 0;
@@ -0,0 +1,96 @@
+#ifndef PIXELROTATIONCHECK_H
+#define PIXELROTATIONCHECK_H
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "bitmap.h"
+#include "bitmapmatrix.h"
+#include "../common/linearplane.h"
+
+// Rotates a linear plane of PixelType row by row and tile by tile. Returns true if both results are the same and
+// match the plane: at the reverse mapped coordinates for bilinear, at the truncated ones for nearest neighbour,
+// the default pixel outside of the source
+template <typename PixelType>
+inline bool checkPlaneRotation(const char* parPixelName, InterpolationMode parInterpolationMode) {
+    constexpr int64_t SOURCE_WIDTH = 61;
+    constexpr int64_t SOURCE_HEIGHT = 41;
+    constexpr int64_t TILE_SIDE = 16;
+    constexpr double DEGREES = 30;
+    constexpr double ZOOM = 1.3;
+
+    LinearPlane<PixelType> plane;
+    BitmapMatrix<PixelType> bitmapMatrix(SOURCE_WIDTH, SOURCE_HEIGHT);
+    for (uint64_t row = 0; row < SOURCE_HEIGHT; row++) {
+        for (int64_t col = 0; col < SOURCE_WIDTH; col++) {
+            bitmapMatrix(row)[col] = plane.getPixel(col, row);
+        }
+    }
+
+    ImageNecessaryInfo outputImageInfo = bitmapMatrix.getRotatedImageInfo(DEGREES * M_PI / 180, ZOOM);
+    int64_t width = outputImageInfo.getWidth();
+    int64_t height = outputImageInfo.getHeight();
+    std::vector<PixelType> rowsOutput(width * height);
+    std::vector<PixelType> tilesOutput(width * height);
+    for (int64_t row = 0; row < height; row++) {
+        bitmapMatrix.calculateOutputRow(row, outputImageInfo, rowsOutput.data() + row * width, parInterpolationMode);
+    }
+    auto getTilesOutputRow = [&](int64_t parRow) {
+        return tilesOutput.data() + parRow * width;
+    };
+    for (int64_t firstRow = 0; firstRow < height; firstRow += TILE_SIDE) {
+        for (int64_t firstCol = 0; firstCol < width; firstCol += TILE_SIDE) {
+            bitmapMatrix.calculateOutputTile(firstRow, std::min(TILE_SIDE, height - firstRow), firstCol, std::min(TILE_SIDE, width - firstCol),
+                                             outputImageInfo, getTilesOutputRow, parInterpolationMode, true);
+        }
+    }
+
+    bool isNearest = parInterpolationMode == InterpolationMode::NearestNeighbour;
+    PixelType defaultPixel = PixelTraits<PixelType>::getDefaultPixel();
+    double maxError = 0;
+    int64_t checkedCount = 0;
+    int64_t wrongCount = 0;
+    for (int64_t row = 0; row < height; row++) {
+        for (int64_t col = 0; col < width; col++) {
+            const PixelType& pixel = rowsOutput[row * width + col];
+            if (!LinearPlane<PixelType>::isSame(pixel, tilesOutput[row * width + col])) {
+                wrongCount++;
+            }
+            std::pair<double, double> coordinates = outputImageInfo.getRotateMatrix().getXYReverseCoordinates(col, row);
+            double x = coordinates.first;
+            double y = coordinates.second;
+            if (x <= -1 || y <= -1 || x >= SOURCE_WIDTH || y >= SOURCE_HEIGHT) {
+                if (!LinearPlane<PixelType>::isSame(pixel, defaultPixel)) {
+                    wrongCount++;
+                }
+                continue;
+            }
+            // Bilinear neighbours of the border are mirrored
+            if (x < 0 || y < 0 || (!isNearest && (x > SOURCE_WIDTH - 1 || y > SOURCE_HEIGHT - 1))) {
+                continue;
+            }
+            maxError = std::max(maxError, isNearest ? plane.getError(pixel, std::floor(x), std::floor(y)) : plane.getError(pixel, x, y));
+            checkedCount++;
+        }
+    }
+
+    std::cout << parPixelName << (isNearest ? " nearest neighbour" : " bilinear") << ": max error " << maxError << " of "
+              << checkedCount << " pixels, wrong pixels: " << wrongCount << std::endl;
+    return checkedCount > 0 && maxError <= LinearPlane<PixelType>::getTolerance() && wrongCount == 0;
+}
+
+// Rotation of every pixel type the BitmapMatrix is instantiated for, returns 0 if it is correct
+inline int runPixelRotationCheck() {
+    bool isCorrect = true;
+    for (InterpolationMode interpolationMode : {InterpolationMode::NearestNeighbour, InterpolationMode::Bilinear}) {
+        isCorrect &= checkPlaneRotation<Bitmap24Pixel>("Bitmap24Pixel", interpolationMode);
+        isCorrect &= checkPlaneRotation<Tiff16RGBPixel>("Tiff16RGBPixel", interpolationMode);
+        isCorrect &= checkPlaneRotation<FloatPixel>("FloatPixel", interpolationMode);
+        isCorrect &= checkPlaneRotation<Complex16Pixel>("Complex16Pixel", interpolationMode);
+    }
+    std::cout << (isCorrect ? "Check passed" : "Check failed") << std::endl;
+    return isCorrect ? 0 : 1;
+}
+
+#endif // PIXELROTATIONCHECK_H
@@ -0,0 +1,330 @@
+#ifndef SHEARROTATOR_H
+#define SHEARROTATOR_H
+
+#include <cmath>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include "bitmap.h"
+#include "bitmapmatrix.h"
+#include "../common/pixeltraits.h"
+#include "../common/kerneltables.h"
+#include "../common/imagenecessaryinfo.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SHEAR_ROTATOR_X86
+#endif
+
+// Rotation as three shears (Paeth). The reverse mapping of RotateMatrix is
+// source = sign * X(a) * Y(b) * X(a) * ((x2 - deltaWidth) / zoom, (y2 - deltaHeight) / zoom)
+// with X(a) = [1 a; 0 1], Y(b) = [1 0; b 1], a = -tan(phi / 2), b = sin(phi). Angles beyond +-90 degrees are
+// rotated by 180 degrees more (sign = -1), so |a| <= 1. Zoom and offsets are folded into the second and the third
+// passes, so every pixel is interpolated exactly three times, each time along one line:
+//  1. source rows -> rows of the first image, stored transposed (one line per column),
+//  2. its lines -> columns of the second image at the output rows, stored row by row,
+//  3. rows of the second image -> output rows.
+// Every pass reads whole contiguous lines, the work buffers are one line plus a block of lines for the transposed
+// stores. Kernels are 1D: 3 x 6 taps per pixel for Lanczos3 instead of 6 x 6 of the direct mode. Pixels outside
+// of the source are background, so borders are antialiased instead of cut by the truncated coordinate test.
+// Lines are resampled in fixed point: integer channels, Q14 int16_t weights (KERNEL_TABLE rows of the nearest phase,
+// Bicubic is the Catmull-Rom kernel), 32-bit sums rounded to the nearest value.
+class ShearRotator
+{
+private:
+    // Default pixels on both sides of the work line, enough for the widest kernel
+    static constexpr int64_t LINE_MARGIN = 6;
+    // Lines resampled before their transposed store, so that every store fills this many neighbour pixels
+    static constexpr int64_t TRANSPOSE_BLOCK_LINES = 16;
+    static constexpr double NEAREST_TOLERANCE = 1e-9;
+    static constexpr int32_t NO_TAPS = -1;
+    static constexpr int64_t FIXED_POINT_SHIFT = KernelTable<CatmullRomKernel, int16_t>::FIXED_POINT_SHIFT;
+    static constexpr int32_t FIXED_POINT_ONE = KernelTable<CatmullRomKernel, int16_t>::FIXED_POINT_ONE;
+
+    BitmapMatrix<Bitmap24Pixel>& _source;
+    InterpolationMode _interpolationMode;
+    int64_t _outputWidth;
+    int64_t _outputHeight;
+
+    double _sign;
+    double _shearX;
+    double _shearY;
+    double _zoom;
+    double _deltaWidth;
+    double _deltaHeight;
+
+    // Columns of the second image are integer u in _firstColumn .. _firstColumn + _columnsCount - 1
+    int64_t _firstColumn;
+    int64_t _columnsCount;
+
+    int64_t _tapsCount;
+    int64_t _firstTapOffset;
+    bool _isAvx2Supported;
+
+    // Line being resampled, 4 channels per pixel (blue, green, red, 0), LINE_MARGIN default pixels on both sides
+    std::vector<int32_t> _line;
+    std::vector<Bitmap24Pixel> _transposeBlock;
+
+    // Work line position of the first tap of every output pixel (NO_TAPS for background) and offset of its weights,
+    // pixels with the same fractional part of the coordinate share weights
+    std::vector<int32_t> _firstTaps;
+    std::vector<int32_t> _weightOffsets;
+    std::vector<int16_t> _weights;
+
+    void loadLine(const Bitmap24Pixel* parLine, int64_t parLength) {
+        int32_t maxValue = Bitmap24Pixel::getMaxChannelValue();
+        _line.resize((parLength + 2 * LINE_MARGIN) * 4);
+        for (int64_t i = 0; i < LINE_MARGIN; i++) {
+            for (int32_t* pixel : {_line.data() + i * 4, _line.data() + (LINE_MARGIN + parLength + i) * 4}) {
+                pixel[0] = pixel[1] = pixel[2] = maxValue;
+                pixel[3] = 0;
+            }
+        }
+        int32_t* pixel = _line.data() + LINE_MARGIN * 4;
+        for (int64_t i = 0; i < parLength; i++, pixel += 4) {
+            pixel[0] = parLine[i].blue;
+            pixel[1] = parLine[i].green;
+            pixel[2] = parLine[i].red;
+            pixel[3] = 0;
+        }
+    }
+
+    // Kernel centered on the coordinate: tap k is pixel floor(coordinate) + _firstTapOffset + k, weights sum to FIXED_POINT_ONE
+    void calculateWeights(double parDelta, int16_t* parWeights) const {
+        auto copyNearestRow = [&](auto parKernel) {
+            const int16_t* row = KERNEL_TABLE<decltype(parKernel), int16_t>.getNearestRow(parDelta);
+            std::copy(row, row + _tapsCount, parWeights);
+        };
+        switch (_interpolationMode) {
+        case InterpolationMode::NearestNeighbour:
+            // Truncated as in the direct mode, a coordinate just below an integer because of rounding errors
+            // of the shear factors (tan(pi / 4) < 1) takes the pixel at that integer
+            parWeights[0] = parDelta < 1 - NEAREST_TOLERANCE ? FIXED_POINT_ONE : 0;
+            parWeights[1] = FIXED_POINT_ONE - parWeights[0];
+            break;
+        case InterpolationMode::Bilinear:
+            parWeights[1] = static_cast<int16_t>(parDelta * FIXED_POINT_ONE + 0.5);
+            parWeights[0] = FIXED_POINT_ONE - parWeights[1];
+            break;
+        case InterpolationMode::Bicubic:
+            copyNearestRow(CatmullRomKernel());
+            break;
+        default:
+            visitInterpolationKernel(_interpolationMode, copyNearestRow);
+            break;
+        }
+    }
+
+    static uint8_t roundChannel(int32_t parValue) {
+        int32_t value = (parValue + FIXED_POINT_ONE / 2) >> FIXED_POINT_SHIFT;
+        return static_cast<uint8_t>(std::clamp<int32_t>(value, 0, Bitmap24Pixel::getMaxChannelValue()));
+    }
+
+    // Taps of the loaded line of parLength pixels sampled at parStart + parStep * i.
+    // Weights are recalculated only when the fractional part changes, for |step| = 1 that is once per line.
+    void calculateTaps(int64_t parLength, double parStart, double parStep, int64_t parCount) {
+        _firstTaps.resize(parCount);
+        _weightOffsets.resize(parCount);
+        _weights.clear();
+        double previousDelta = -1;
+        for (int64_t i = 0; i < parCount; i++) {
+            double coordinate = parStart + parStep * i;
+            // Taps outside of the work line are all background
+            if (coordinate < -LINE_MARGIN || coordinate > parLength + LINE_MARGIN) {
+                _firstTaps[i] = NO_TAPS;
+                continue;
+            }
+            // floor() without the libm call of baseline x86-64
+            int64_t first = static_cast<int64_t>(coordinate);
+            first -= first > coordinate;
+            double delta = coordinate - first;
+            first += _firstTapOffset;
+            if (first < -LINE_MARGIN || first + _tapsCount > parLength + LINE_MARGIN) {
+                _firstTaps[i] = NO_TAPS;
+                continue;
+            }
+            _firstTaps[i] = static_cast<int32_t>(first + LINE_MARGIN);
+
+            if (delta != previousDelta) {
+                _weights.resize(_weights.size() + _tapsCount);
+                calculateWeights(delta, _weights.data() + _weights.size() - _tapsCount);
+                previousDelta = delta;
+            }
+            _weightOffsets[i] = static_cast<int32_t>(_weights.size() - _tapsCount);
+        }
+    }
+
+    // Loaded line sampled at parStart + parStep * i, rounded to the nearest value
+    void resampleLine(int64_t parLength, double parStart, double parStep, int64_t parCount, Bitmap24Pixel* parOut) {
+        calculateTaps(parLength, parStart, parStep, parCount);
+#ifdef SHEAR_ROTATOR_X86
+        if (_isAvx2Supported) {
+            convolveAvx2(parCount, parOut);
+            return;
+        }
+#endif
+        const Bitmap24Pixel defaultPixel = PixelTraits<Bitmap24Pixel>::getDefaultPixel();
+        for (int64_t i = 0; i < parCount; i++) {
+            Bitmap24Pixel& pixel = parOut[i];
+            if (_firstTaps[i] == NO_TAPS) {
+                pixel = defaultPixel;
+                continue;
+            }
+            const int32_t* taps = _line.data() + _firstTaps[i] * 4;
+            const int16_t* weights = _weights.data() + _weightOffsets[i];
+            int32_t blue = 0;
+            int32_t green = 0;
+            int32_t red = 0;
+            for (int64_t k = 0; k < _tapsCount; k++) {
+                blue += weights[k] * taps[k * 4];
+                green += weights[k] * taps[k * 4 + 1];
+                red += weights[k] * taps[k * 4 + 2];
+            }
+            pixel.blue = roundChannel(blue);
+            pixel.green = roundChannel(green);
+            pixel.red = roundChannel(red);
+        }
+    }
+
+#ifdef SHEAR_ROTATOR_X86
+    // All channels of two taps in one vector (taps count is even), the same integer sums as the scalar loop.
+    // Saturating packs clamp the rounded channels to 0..255.
+    __attribute__((target("avx2")))
+    void convolveAvx2(int64_t parCount, Bitmap24Pixel* parOut) const {
+        const Bitmap24Pixel defaultPixel = PixelTraits<Bitmap24Pixel>::getDefaultPixel();
+        const __m128i half = _mm_set1_epi32(FIXED_POINT_ONE / 2);
+        for (int64_t i = 0; i < parCount; i++) {
+            Bitmap24Pixel& pixel = parOut[i];
+            if (_firstTaps[i] == NO_TAPS) {
+                pixel = defaultPixel;
+                continue;
+            }
+            const int32_t* taps = _line.data() + _firstTaps[i] * 4;
+            const int16_t* weights = _weights.data() + _weightOffsets[i];
+            __m256i sum = _mm256_setzero_si256();
+            for (int64_t k = 0; k < _tapsCount; k += 2) {
+                __m256i tapsPair = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(taps + k * 4));
+                __m256i weightsPair = _mm256_set_m128i(_mm_set1_epi32(weights[k + 1]), _mm_set1_epi32(weights[k]));
+                sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(weightsPair, tapsPair));
+            }
+            __m128i value = _mm_add_epi32(_mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1)), half);
+            __m128i channels = _mm_srai_epi32(value, FIXED_POINT_SHIFT);
+            channels = _mm_packus_epi16(_mm_packs_epi32(channels, channels), channels);
+            int32_t bytes = _mm_cvtsi128_si32(channels);
+            memcpy(reinterpret_cast<uint8_t*>(&pixel), &bytes, sizeof(Bitmap24Pixel));
+        }
+    }
+#endif
+
+    // parResampleLine(line, out) fills parCount pixels of the line, they are stored to parOut as column line
+    template<typename ResampleLineFunction>
+    void resampleTransposed(int64_t parLinesCount, int64_t parCount, Bitmap24Pixel* parOut, ResampleLineFunction parResampleLine) {
+        _transposeBlock.resize(TRANSPOSE_BLOCK_LINES * parCount);
+        for (int64_t firstLine = 0; firstLine < parLinesCount; firstLine += TRANSPOSE_BLOCK_LINES) {
+            int64_t linesCount = std::min(TRANSPOSE_BLOCK_LINES, parLinesCount - firstLine);
+            for (int64_t l = 0; l < linesCount; l++) {
+                parResampleLine(firstLine + l, _transposeBlock.data() + l * parCount);
+            }
+            for (int64_t i = 0; i < parCount; i++) {
+                Bitmap24Pixel* out = parOut + i * parLinesCount + firstLine;
+                for (int64_t l = 0; l < linesCount; l++) {
+                    out[l] = _transposeBlock[l * parCount + i];
+                }
+            }
+        }
+    }
+
+public:
+    ShearRotator(BitmapMatrix<Bitmap24Pixel>& parSource, const ImageNecessaryInfo& parOutputImageInfo,
+                 InterpolationMode parInterpolationMode)
+        : _source(parSource), _interpolationMode(parInterpolationMode) {
+        _outputWidth = parOutputImageInfo.getWidth();
+        _outputHeight = parOutputImageInfo.getHeight();
+
+        const RotateMatrix& rotateMatrix = parOutputImageInfo.getRotateMatrix();
+        double phi = std::remainder(rotateMatrix.getPhi(), 2 * M_PI);
+        _sign = 1;
+        if (std::abs(phi) > M_PI / 2) {
+            _sign = -1;
+            phi -= std::copysign(M_PI, phi);
+        }
+        _shearX = -std::tan(phi / 2);
+        _shearY = std::sin(phi);
+        _zoom = rotateMatrix.getZoom();
+        _deltaWidth = rotateMatrix.getDeltaWidth();
+        _deltaHeight = rotateMatrix.getDeltaHeight();
+
+        switch (_interpolationMode) {
+        case InterpolationMode::NearestNeighbour:
+        case InterpolationMode::Bilinear:
+            _tapsCount = 2;
+            _firstTapOffset = 0;
+            break;
+        case InterpolationMode::Bicubic:
+            _tapsCount = 4;
+            _firstTapOffset = -1;
+            break;
+        default:
+            visitInterpolationKernel(_interpolationMode, [&](auto parKernel) {
+                _tapsCount = 2 * decltype(parKernel)::RADIUS;
+                _firstTapOffset = 1 - decltype(parKernel)::RADIUS;
+            });
+            break;
+        }
+
+#ifdef SHEAR_ROTATOR_X86
+        __builtin_cpu_init();
+        _isAvx2Supported = __builtin_cpu_supports("avx2");
+#else
+        _isAvx2Supported = false;
+#endif
+
+        // The third pass reads u = (x2 - deltaWidth) / zoom + a * (y2 - deltaHeight) / zoom plus the kernel radius
+        double minU = INFINITY;
+        double maxU = -INFINITY;
+        for (double x : {0.0, static_cast<double>(_outputWidth - 1)}) {
+            for (double y : {0.0, static_cast<double>(_outputHeight - 1)}) {
+                double u = (x - _deltaWidth) / _zoom + _shearX * (y - _deltaHeight) / _zoom;
+                minU = std::min(minU, u);
+                maxU = std::max(maxU, u);
+            }
+        }
+        _firstColumn = static_cast<int64_t>(floor(minU)) - MAX_INTERPOLATION_RADIUS;
+        _columnsCount = static_cast<int64_t>(ceil(maxU)) + MAX_INTERPOLATION_RADIUS - _firstColumn + 1;
+    }
+
+    // parGetOutputRow(row) returns pixels of the output row numbered as in BitmapMatrix::calculateOutputRow
+    template<typename OutputRowFunction>
+    void rotate(OutputRowFunction parGetOutputRow) {
+        int64_t sourceWidth = _source.getWidth();
+        int64_t sourceHeight = _source.getHeight();
+
+        // First image (u, v) = source(sign * (u + a * v), sign * v), line of column u holds v = sign * source row
+        std::vector<Bitmap24Pixel> firstImage(_columnsCount * sourceHeight);
+        resampleTransposed(sourceHeight, _columnsCount, firstImage.data(), [&](int64_t parRow, Bitmap24Pixel* parOut) {
+            loadLine(_source(static_cast<uint64_t>(parRow)), sourceWidth);
+            double start = _sign * (_firstColumn + _shearX * _sign * parRow);
+            resampleLine(sourceWidth, start, _sign, _columnsCount, parOut);
+        });
+
+        // Second image (u, w) = first image (u, w + b * u) at w = (y2 - deltaHeight) / zoom of every output row
+        std::vector<Bitmap24Pixel> secondImage(_outputHeight * _columnsCount);
+        resampleTransposed(_columnsCount, _outputHeight, secondImage.data(), [&](int64_t parColumn, Bitmap24Pixel* parOut) {
+            loadLine(firstImage.data() + parColumn * sourceHeight, sourceHeight);
+            double start = _sign * (-_deltaHeight / _zoom + _shearY * (_firstColumn + parColumn));
+            resampleLine(sourceHeight, start, _sign / _zoom, _outputHeight, parOut);
+        });
+        std::vector<Bitmap24Pixel>().swap(firstImage);
+
+        // Output (x2, y2) = second image ((x2 - deltaWidth) / zoom + a * w, w)
+        for (int64_t row = 0; row < _outputHeight; row++) {
+            loadLine(secondImage.data() + row * _columnsCount, _columnsCount);
+            double w = (row - _deltaHeight) / _zoom;
+            double start = -_deltaWidth / _zoom + _shearX * w - _firstColumn;
+            resampleLine(_columnsCount, start, 1 / _zoom, _outputWidth, parGetOutputRow(row));
+        }
+    }
+};
+
+#endif // SHEARROTATOR_H
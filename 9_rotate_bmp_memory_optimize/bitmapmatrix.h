@@ -3,18 +3,14 @@
 
 #include <cmath>
 #include <memory>
-#include "pixeltraits.h"
+#include <algorithm>
+#include <type_traits>
+#include "../common/pixeltraits.h"
+#include "../common/interpolationmode.h"
 #include "bitmap.h"
-#include "imagenecessaryinfo.h"
-#include "rotatematrix.h"
-
-enum class InterpolationMode
-{
-    NearestNeighbour,
-    Bilinear,
-    Bicubic,
-    Lanczos3
-};
+#include "../common/imagenecessaryinfo.h"
+#include "../common/rotatematrix.h"
+#include "../common/affinegather.h"
 
 struct ChunkInfo {
     double aX;
@@ -29,7 +25,7 @@ struct ChunkInfo {
 
 template<typename PixelType = Bitmap24Pixel>
 class BitmapOptimizeMatrix {
-    std::unique_ptr<Bitmap24Pixel[]> _chunkBitmap;
+    std::unique_ptr<PixelType[]> _chunkBitmap;
     int64_t _fullWidth;
     int64_t _fullHeight;
 
@@ -109,7 +105,8 @@ public:
 
 
 
-        _chunkBitmap = std::make_unique<PixelType[]>((_pixelsPerChunkSideInput + 2 * _padding) * (_pixelsPerChunkSideInput + 2 * _padding) * 4 / (parZoom));
+        // One more pixel, so the last one can be loaded as a 32-bit word
+        _chunkBitmap = std::make_unique<PixelType[]>((_pixelsPerChunkSideInput + 2 * _padding) * (_pixelsPerChunkSideInput + 2 * _padding) * 4 / (parZoom) + 1);
 
         return {
             width,
@@ -137,10 +134,8 @@ public:
         };
     }
 
-    void calculateOutputChunk(int64_t parWidth, double parHeight, double parAlpha, double parZoom, const ImageNecessaryInfo& parOutputImageInfo,
-                            PixelType* parOutChunkData, InterpolationMode parInterpolationMode = InterpolationMode::NearestNeighbour, int64_t parPadding = 0, double parOffsetX = 0, double parOffsetY = 0) {
-
-
+    // Offset added to the reverse mapped coordinates of output chunk pixels in calculateOutputChunk
+    std::pair<double, double> getChunkSourceOffset(double parAlpha, double parZoom) const {
         RotateMatrix rotateMatrix = RotateMatrix(parAlpha, 0, 0, parZoom);
         std::pair<double, double> leftDown = rotateMatrix.getNewPixelCoordinates(0, 0);
         std::pair<double, double> leftUpper = rotateMatrix.getNewPixelCoordinates(0, _pixelsPerChunkSideOutput);
@@ -150,61 +145,116 @@ public:
         double minX = std::min(std::min(leftDown.first, leftUpper.first), std::min(rightDown.first, rightUpper.first));
         double minY = std::min(std::min(leftDown.second, leftUpper.second), std::min(rightDown.second, rightUpper.second));
 
-
         double deltaWidth = -minX;
         double deltaHeight = -minY;
+        return {deltaHeight / parZoom / parZoom, deltaWidth / parZoom / parZoom};
+    }
+
+    // Source coordinates of every chunk row are calculated for blocks of RotateMatrix::ROW_BLOCK_LENGTH pixels,
+    // Bitmap24Pixel bilinear and kernel table modes are interpolated with AVX2 where it is available
+    void calculateOutputChunk(int64_t parWidth, double parHeight, double parAlpha, double parZoom, const ImageNecessaryInfo& parOutputImageInfo,
+                            PixelType* parOutChunkData, InterpolationMode parInterpolationMode = InterpolationMode::NearestNeighbour, int64_t parPadding = 0, double parOffsetX = 0, double parOffsetY = 0) {
+
+
+        RotateMatrix rotateMatrix = RotateMatrix(parAlpha, 0, 0, parZoom);
         _padding = parPadding;
 
-        int currentPixelIndex = -1;
-        for (int64_t i = 0; i < parWidth; i++) {
-            for (int64_t j = 0; j < parHeight; j++) {
-                currentPixelIndex++;
-                std::pair<double, double> pixelCoordinates = rotateMatrix.getXYReverseCoordinates(j, i);
+        std::pair<double, double> offset = getChunkSourceOffset(parAlpha, parZoom);
+        double offsetX = offset.first;
+        double offsetY = offset.second;
+        int64_t stride = _padding + _pixelsPerChunkSideInput + _padding;
+        GatherPlane<PixelType> plane = {_chunkBitmap.get(), stride, -_padding, _pixelsPerChunkSideInput + _padding - 1,
+                                         -_padding, _pixelsPerChunkSideInput + _padding - 1};
+        bool isVectorPlane = std::is_same_v<PixelType, Bitmap24Pixel> && isAffineGatherSupported(plane);
 
-                pixelCoordinates.first = pixelCoordinates.first + deltaHeight / parZoom / parZoom + parOffsetX;
-                pixelCoordinates.second = pixelCoordinates.second + deltaWidth / parZoom / parZoom + parOffsetY;
+        double xs[RotateMatrix::ROW_BLOCK_LENGTH];
+        double ys[RotateMatrix::ROW_BLOCK_LENGTH];
+        for (int64_t i = 0; i < parWidth; i++) {
+            for (int64_t blockBegin = 0; blockBegin < parHeight; blockBegin += RotateMatrix::ROW_BLOCK_LENGTH) {
+                int64_t blockLength = std::min<int64_t>(RotateMatrix::ROW_BLOCK_LENGTH, std::ceil(parHeight) - blockBegin);
+                rotateMatrix.getXYReverseRowCoordinates(blockBegin, i, blockLength, xs, ys);
+                for (int64_t k = 0; k < blockLength; k++) {
+                    xs[k] = xs[k] + offsetX + parOffsetX;
+                    ys[k] = ys[k] + offsetY + parOffsetY;
+                }
+                PixelType* outBlock = parOutChunkData + static_cast<int64_t>(std::ceil(parHeight)) * i + blockBegin;
 
                 if (parInterpolationMode == InterpolationMode::NearestNeighbour) {
-                    parOutChunkData[currentPixelIndex] = *(*this)(static_cast<int64_t>(pixelCoordinates.second),
-                                                 static_cast<int64_t>(pixelCoordinates.first));
+                    gatherNearest(plane, xs, ys, blockLength, outBlock, _defaultPixelType);
                     continue;
                 }
-
-                int x1 = floor(pixelCoordinates.first);
-                int y1 = floor(pixelCoordinates.second);
-                int x2 = ceil(pixelCoordinates.first);
-                int y2 = ceil(pixelCoordinates.second);
-                double dx = pixelCoordinates.first - x1;
-                double dy = pixelCoordinates.second - y1;
-
-                if (parInterpolationMode == InterpolationMode::Bilinear) {
-
-                    PixelType p1 = *(*this)(y1, x1);
-                    PixelType p2 = *(*this)(y1, x2);
-                    PixelType p3 = *(*this)(y2, x1);
-                    PixelType p4 = *(*this)(y2, x2);
-
-                    parOutChunkData[currentPixelIndex] = PixelTraits<PixelType>::interpolateBilinear(p1, p2, p3, p4, dx, dy);
-                } else if (parInterpolationMode == InterpolationMode::Bicubic) {
-                    PixelType pixels[4][4];
-                    for (int j = -2; j < 2; ++j) {
-                        for (int k = -2; k < 2; ++k) {
-                            pixels[j + 2][k + 2] = *(*this)(y1 + j, x1 + k);
-                        }
-                    }
-                    parOutChunkData[currentPixelIndex] = PixelTraits<PixelType>::interpolateBicubic(pixels, dx, dy);
-                } else if (parInterpolationMode == InterpolationMode::Lanczos3) {
-                    PixelType pixels[6][6];
-                    for (int j = -2; j <= 3; ++j) {
-                        for (int i = -2; i <= 3; ++i) {
-                            pixels[j + 2][i + 2] = *(*this)(static_cast<int64_t>(pixelCoordinates.second) + j,
-                                                            static_cast<int64_t>(pixelCoordinates.first) + i);
+                int64_t k = 0;
+                if constexpr (std::is_same_v<PixelType, Bitmap24Pixel>) {
+#ifdef AFFINE_GATHER_X86
+                    if (isVectorPlane) {
+                        auto fallback = [&](int64_t l) { outBlock[l] = calculatePixel(xs[l], ys[l], parInterpolationMode); };
+                        if (parInterpolationMode == InterpolationMode::Bilinear) {
+                            k = interpolateBilinearAvx2(plane, xs, ys, blockLength, outBlock, fallback);
+                        } else {
+                            visitInterpolationKernel(parInterpolationMode, [&](auto parKernel) {
+                                k = interpolateKernelAvx2<decltype(parKernel)>(plane, xs, ys, blockLength, outBlock, fallback);
+                            });
                         }
                     }
-                    parOutChunkData[currentPixelIndex] = PixelTraits<PixelType>::interpolateLanczos(pixels, dx, dy);
+#endif
+                }
+                for (; k < blockLength; k++) {
+                    outBlock[k] = calculatePixel(xs[k], ys[k], parInterpolationMode);
+                }
+            }
+        }
+    }
+
+    PixelType calculatePixel(double parX, double parY, InterpolationMode parInterpolationMode) {
+        if (parInterpolationMode == InterpolationMode::NearestNeighbour) {
+            return *(*this)(static_cast<int64_t>(parY), static_cast<int64_t>(parX));
+        }
+
+        int x1 = floor(parX);
+        int y1 = floor(parY);
+        int x2 = ceil(parX);
+        int y2 = ceil(parY);
+        double dx = parX - x1;
+        double dy = parY - y1;
+
+        if (parInterpolationMode == InterpolationMode::Bilinear) {
+
+            PixelType p1 = *(*this)(y1, x1);
+            PixelType p2 = *(*this)(y1, x2);
+            PixelType p3 = *(*this)(y2, x1);
+            PixelType p4 = *(*this)(y2, x2);
+
+            return PixelTraits<PixelType>::interpolateBilinear(p1, p2, p3, p4, dx, dy);
+        } else if (parInterpolationMode == InterpolationMode::Bicubic) {
+            PixelType pixels[4][4];
+            for (int j = -2; j < 2; ++j) {
+                for (int k = -2; k < 2; ++k) {
+                    pixels[j + 2][k + 2] = *(*this)(y1 + j, x1 + k);
                 }
             }
+            return PixelTraits<PixelType>::interpolateBicubic(pixels, dx, dy);
+        }
+
+        PixelType pixel = _defaultPixelType;
+        visitInterpolationKernel(parInterpolationMode, [&](auto parKernel) {
+            pixel = interpolateKernel<decltype(parKernel)>(parX, parY);
+        });
+        return pixel;
+    }
+
+    // Pixels (floor(y) - RADIUS + 1 .. floor(y) + RADIUS) x (floor(x) - RADIUS + 1 .. floor(x) + RADIUS) weighted by KERNEL_TABLE<Kernel>
+    template<typename Kernel>
+    PixelType interpolateKernel(double parX, double parY) {
+        constexpr int64_t TAPS_COUNT = 2 * Kernel::RADIUS;
+        int64_t x1 = floor(parX);
+        int64_t y1 = floor(parY);
+        PixelType pixels[TAPS_COUNT][TAPS_COUNT];
+        for (int64_t j = 0; j < TAPS_COUNT; j++) {
+            for (int64_t i = 0; i < TAPS_COUNT; i++) {
+                pixels[j][i] = *(*this)(y1 + j - Kernel::RADIUS + 1, x1 + i - Kernel::RADIUS + 1);
+            }
         }
+        return PixelTraits<PixelType>::template interpolateKernel<Kernel>(pixels, parX - x1, parY - y1);
     }
 };
 
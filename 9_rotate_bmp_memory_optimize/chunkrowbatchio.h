@@ -0,0 +1,396 @@
+#ifndef CHUNKROWBATCHIO_H
+#define CHUNKROWBATCHIO_H
+
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <memory>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include "../common/mappedbitmap.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#define CHUNK_IO_VECTORED
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define CHUNK_IO_URING
+#endif
+
+enum class ChunkIoMode : uint8_t {
+    Mapped,
+    IoUring,
+    Vectored
+};
+
+inline const char* getChunkIoModeName(ChunkIoMode parMode) {
+    switch (parMode) {
+    case ChunkIoMode::IoUring:
+        return "io_uring";
+    case ChunkIoMode::Vectored:
+        return "preadv/pwritev";
+    default:
+        return "mmap";
+    }
+}
+
+// Part of one bitmap row: row in bottom-up order, byte offset inside the row
+struct RowTransfer {
+    int64_t row;
+    uint64_t rowOffset;
+    uint8_t* buffer;
+    uint64_t bytesCount;
+};
+
+#ifdef CHUNK_IO_VECTORED
+inline void transferFully(int parFileDescriptor, uint8_t* parBuffer, uint64_t parBytesCount, uint64_t parFileOffset, bool parIsWrite) {
+    while (parBytesCount > 0) {
+        ssize_t result = parIsWrite ? pwrite(parFileDescriptor, parBuffer, parBytesCount, parFileOffset)
+                                    : pread(parFileDescriptor, parBuffer, parBytesCount, parFileOffset);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            throw std::runtime_error(parIsWrite ? "Error writing to file!" : "Error reading source file!");
+        }
+        parBuffer += result;
+        parBytesCount -= result;
+        parFileOffset += result;
+    }
+}
+#endif
+
+#ifdef CHUNK_IO_URING
+// Minimal io_uring over raw syscalls: a batch of reads or writes is queued and waited for as a whole
+class IoUring {
+    int _ringFileDescriptor = -1;
+    uint8_t* _submissionRing = nullptr;
+    uint64_t _submissionRingSize = 0;
+    uint8_t* _completionRing = nullptr;
+    uint64_t _completionRingSize = 0;
+    io_uring_sqe* _submissionEntries = nullptr;
+    uint64_t _submissionEntriesSize = 0;
+    io_uring_params _params;
+
+    unsigned* submissionField(uint32_t parOffset) const {
+        return reinterpret_cast<unsigned*>(_submissionRing + parOffset);
+    }
+
+    unsigned* completionField(uint32_t parOffset) const {
+        return reinterpret_cast<unsigned*>(_completionRing + parOffset);
+    }
+
+    void release() {
+        if (_submissionEntries) {
+            munmap(_submissionEntries, _submissionEntriesSize);
+        }
+        if (_completionRing && _completionRing != _submissionRing) {
+            munmap(_completionRing, _completionRingSize);
+        }
+        if (_submissionRing) {
+            munmap(_submissionRing, _submissionRingSize);
+        }
+        if (_ringFileDescriptor >= 0) {
+            close(_ringFileDescriptor);
+        }
+    }
+
+    static void* mapRing(int parFileDescriptor, uint64_t parSize, uint64_t parOffset) {
+        void* address = mmap(nullptr, parSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, parFileDescriptor, parOffset);
+        return address == MAP_FAILED ? nullptr : address;
+    }
+
+public:
+    IoUring(unsigned parEntries) {
+        memset(&_params, 0, sizeof(_params));
+        _ringFileDescriptor = syscall(__NR_io_uring_setup, parEntries, &_params);
+        if (_ringFileDescriptor < 0) {
+            throw std::runtime_error("io_uring is not supported!");
+        }
+
+        _submissionRingSize = _params.sq_off.array + _params.sq_entries * sizeof(unsigned);
+        _completionRingSize = _params.cq_off.cqes + _params.cq_entries * sizeof(io_uring_cqe);
+        if (_params.features & IORING_FEAT_SINGLE_MMAP) {
+            _submissionRingSize = _completionRingSize = std::max(_submissionRingSize, _completionRingSize);
+        }
+
+        _submissionRing = static_cast<uint8_t*>(mapRing(_ringFileDescriptor, _submissionRingSize, IORING_OFF_SQ_RING));
+        if (_submissionRing && (_params.features & IORING_FEAT_SINGLE_MMAP)) {
+            _completionRing = _submissionRing;
+        } else if (_submissionRing) {
+            _completionRing = static_cast<uint8_t*>(mapRing(_ringFileDescriptor, _completionRingSize, IORING_OFF_CQ_RING));
+        }
+        _submissionEntriesSize = _params.sq_entries * sizeof(io_uring_sqe);
+        if (_completionRing) {
+            _submissionEntries = static_cast<io_uring_sqe*>(mapRing(_ringFileDescriptor, _submissionEntriesSize, IORING_OFF_SQES));
+        }
+        if (!_submissionEntries) {
+            release();
+            throw std::runtime_error("Can't map io_uring!");
+        }
+    }
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    ~IoUring() {
+        release();
+    }
+
+    void transfer(int parFileDescriptor, const std::vector<RowTransfer>& parTransfers, const std::vector<uint64_t>& parFileOffsets, bool parIsWrite) {
+        unsigned* submissionTail = submissionField(_params.sq_off.tail);
+        unsigned submissionMask = *submissionField(_params.sq_off.ring_mask);
+        unsigned* submissionArray = submissionField(_params.sq_off.array);
+        unsigned* completionHead = completionField(_params.cq_off.head);
+        unsigned* completionTail = completionField(_params.cq_off.tail);
+        unsigned completionMask = *completionField(_params.cq_off.ring_mask);
+        io_uring_cqe* completionEntries = reinterpret_cast<io_uring_cqe*>(_completionRing + _params.cq_off.cqes);
+
+        for (uint64_t batchBegin = 0; batchBegin < parTransfers.size(); batchBegin += _params.sq_entries) {
+            unsigned batchSize = std::min<uint64_t>(_params.sq_entries, parTransfers.size() - batchBegin);
+
+            unsigned tail = *submissionTail;
+            for (unsigned i = 0; i < batchSize; i++) {
+                const RowTransfer& rowTransfer = parTransfers[batchBegin + i];
+                unsigned index = tail & submissionMask;
+                io_uring_sqe* entry = _submissionEntries + index;
+                memset(entry, 0, sizeof(io_uring_sqe));
+                entry->opcode = parIsWrite ? IORING_OP_WRITE : IORING_OP_READ;
+                entry->fd = parFileDescriptor;
+                entry->off = parFileOffsets[batchBegin + i];
+                entry->addr = reinterpret_cast<uint64_t>(rowTransfer.buffer);
+                entry->len = rowTransfer.bytesCount;
+                entry->user_data = batchBegin + i;
+                submissionArray[index] = index;
+                tail++;
+            }
+            __atomic_store_n(submissionTail, tail, __ATOMIC_RELEASE);
+
+            unsigned submittedCount = 0;
+            unsigned completedCount = 0;
+            while (completedCount < batchSize) {
+                int result = syscall(__NR_io_uring_enter, _ringFileDescriptor, batchSize - submittedCount,
+                                     batchSize - completedCount, IORING_ENTER_GETEVENTS, nullptr, 0);
+                if (result < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw std::runtime_error("io_uring_enter failed!");
+                }
+                submittedCount += result;
+
+                unsigned head = *completionHead;
+                unsigned completionTailValue = __atomic_load_n(completionTail, __ATOMIC_ACQUIRE);
+                for (; head != completionTailValue; head++, completedCount++) {
+                    const io_uring_cqe& completion = completionEntries[head & completionMask];
+                    const RowTransfer& rowTransfer = parTransfers[completion.user_data];
+                    if (completion.res < 0) {
+                        throw std::runtime_error(parIsWrite ? "Error writing to file!" : "Error reading source file!");
+                    }
+                    if (static_cast<uint64_t>(completion.res) < rowTransfer.bytesCount) {
+                        transferFully(parFileDescriptor, rowTransfer.buffer + completion.res, rowTransfer.bytesCount - completion.res,
+                                      parFileOffsets[completion.user_data] + completion.res, parIsWrite);
+                    }
+                }
+                __atomic_store_n(completionHead, head, __ATOMIC_RELEASE);
+            }
+        }
+    }
+};
+#endif
+
+// Reads input rows parts into chunk scratch and writes output rows parts of a chunk as one batch:
+// memcpy from mappings, one io_uring submission, or preadv/pwritev of coalesced neighbour rows
+class ChunkRowBatchIo {
+    static constexpr unsigned RING_ENTRIES_COUNT = 256;
+    static constexpr uint64_t MAX_READ_GAP_BYTES = 4096;
+
+    const MappedBitmapReader& _input;
+    const MappedBitmapWriter& _output;
+    ChunkIoMode _mode;
+    int _inputFileDescriptor = -1;
+    int _outputFileDescriptor = -1;
+#ifdef CHUNK_IO_URING
+    std::unique_ptr<IoUring> _ring;
+#endif
+    std::unique_ptr<uint8_t[]> _gapBuffer;
+    std::vector<uint64_t> _fileOffsets;
+    std::vector<uint64_t> _order;
+
+    void closeFiles() {
+#ifdef CHUNK_IO_VECTORED
+        if (_inputFileDescriptor >= 0) {
+            close(_inputFileDescriptor);
+        }
+        if (_outputFileDescriptor >= 0) {
+            close(_outputFileDescriptor);
+        }
+#endif
+        _inputFileDescriptor = -1;
+        _outputFileDescriptor = -1;
+    }
+
+    void prepareFileOffsets(const std::vector<RowTransfer>& parTransfers, bool parIsWrite) {
+        _fileOffsets.resize(parTransfers.size());
+        for (uint64_t i = 0; i < parTransfers.size(); i++) {
+            uint64_t rowFileOffset = parIsWrite ? _output.getRowFileOffset(parTransfers[i].row) : _input.getRowFileOffset(parTransfers[i].row);
+            _fileOffsets[i] = rowFileOffset + parTransfers[i].rowOffset;
+        }
+    }
+
+#ifdef CHUNK_IO_VECTORED
+    // Neighbour parts are merged into one call, gaps up to MAX_READ_GAP_BYTES are read to a scratch buffer
+    void transferVectored(int parFileDescriptor, const std::vector<RowTransfer>& parTransfers, bool parIsWrite) {
+        _order.resize(parTransfers.size());
+        for (uint64_t i = 0; i < _order.size(); i++) {
+            _order[i] = i;
+        }
+        std::sort(_order.begin(), _order.end(), [this](uint64_t parLeft, uint64_t parRight) {
+            return _fileOffsets[parLeft] < _fileOffsets[parRight];
+        });
+
+        uint64_t maxGapBytes = parIsWrite ? 0 : MAX_READ_GAP_BYTES;
+        std::vector<iovec> vectors;
+        uint64_t runBegin = 0;
+        uint64_t runEnd = 0;
+
+        auto flush = [&]() {
+            ssize_t result;
+            do {
+                result = parIsWrite ? pwritev(parFileDescriptor, vectors.data(), vectors.size(), runBegin)
+                                    : preadv(parFileDescriptor, vectors.data(), vectors.size(), runBegin);
+            } while (result < 0 && errno == EINTR);
+            if (result < 0) {
+                throw std::runtime_error(parIsWrite ? "Error writing to file!" : "Error reading source file!");
+            }
+
+            // Short transfer is rare, the rest of the run is finished part by part
+            uint64_t doneBytesCount = result;
+            uint64_t fileOffset = runBegin;
+            for (const iovec& vector : vectors) {
+                if (doneBytesCount < vector.iov_len && vector.iov_base != _gapBuffer.get()) {
+                    transferFully(parFileDescriptor, static_cast<uint8_t*>(vector.iov_base) + doneBytesCount,
+                                  vector.iov_len - doneBytesCount, fileOffset + doneBytesCount, parIsWrite);
+                }
+                doneBytesCount -= std::min<uint64_t>(doneBytesCount, vector.iov_len);
+                fileOffset += vector.iov_len;
+            }
+            vectors.clear();
+        };
+
+        for (uint64_t index : _order) {
+            const RowTransfer& rowTransfer = parTransfers[index];
+            if (rowTransfer.bytesCount == 0) {
+                continue;
+            }
+            uint64_t fileOffset = _fileOffsets[index];
+            bool isNeighbour = !vectors.empty() && fileOffset >= runEnd && fileOffset - runEnd <= maxGapBytes
+                               && vectors.size() + 2 <= IOV_MAX;
+            if (!isNeighbour && !vectors.empty()) {
+                flush();
+            }
+            if (vectors.empty()) {
+                runBegin = fileOffset;
+                runEnd = fileOffset;
+            }
+            if (fileOffset > runEnd) {
+                vectors.push_back({_gapBuffer.get(), fileOffset - runEnd});
+            }
+            vectors.push_back({rowTransfer.buffer, rowTransfer.bytesCount});
+            runEnd = fileOffset + rowTransfer.bytesCount;
+        }
+        if (!vectors.empty()) {
+            flush();
+        }
+    }
+#endif
+
+    void transfer(const std::vector<RowTransfer>& parTransfers, bool parIsWrite) {
+        if (_mode == ChunkIoMode::Mapped) {
+            for (const RowTransfer& rowTransfer : parTransfers) {
+                if (parIsWrite) {
+                    memcpy(_output.getRow(rowTransfer.row) + rowTransfer.rowOffset, rowTransfer.buffer, rowTransfer.bytesCount);
+                } else {
+                    memcpy(rowTransfer.buffer, _input.getRow(rowTransfer.row) + rowTransfer.rowOffset, rowTransfer.bytesCount);
+                }
+            }
+            return;
+        }
+
+        prepareFileOffsets(parTransfers, parIsWrite);
+        int fileDescriptor = parIsWrite ? _outputFileDescriptor : _inputFileDescriptor;
+#ifdef CHUNK_IO_URING
+        if (_mode == ChunkIoMode::IoUring) {
+            _ring->transfer(fileDescriptor, parTransfers, _fileOffsets, parIsWrite);
+            return;
+        }
+#endif
+#ifdef CHUNK_IO_VECTORED
+        transferVectored(fileDescriptor, parTransfers, parIsWrite);
+#endif
+    }
+
+public:
+    // Files are opened once more for positional I/O, headers and file size are already handled by the mappings.
+    // Unsupported modes fall back to preadv/pwritev and then to mappings.
+    ChunkRowBatchIo(const MappedBitmapReader& parInput, const MappedBitmapWriter& parOutput,
+                    const std::string& parInputFileName, const std::string& parOutputFileName, ChunkIoMode parMode)
+        : _input(parInput), _output(parOutput), _mode(parMode) {
+#ifdef CHUNK_IO_URING
+        if (_mode == ChunkIoMode::IoUring) {
+            try {
+                _ring = std::make_unique<IoUring>(RING_ENTRIES_COUNT);
+            } catch (const std::exception&) {
+                _mode = ChunkIoMode::Vectored;
+            }
+        }
+#else
+        if (_mode == ChunkIoMode::IoUring) {
+            _mode = ChunkIoMode::Vectored;
+        }
+#endif
+#ifdef CHUNK_IO_VECTORED
+        if (_mode != ChunkIoMode::Mapped) {
+            _inputFileDescriptor = open(parInputFileName.c_str(), O_RDONLY);
+            _outputFileDescriptor = open(parOutputFileName.c_str(), O_WRONLY);
+            if (_inputFileDescriptor < 0 || _outputFileDescriptor < 0) {
+                closeFiles();
+                throw std::runtime_error("Can't open files!");
+            }
+            _gapBuffer = std::make_unique<uint8_t[]>(MAX_READ_GAP_BYTES);
+        }
+#else
+        _mode = ChunkIoMode::Mapped;
+#endif
+    }
+
+    ChunkRowBatchIo(const ChunkRowBatchIo&) = delete;
+    ChunkRowBatchIo& operator=(const ChunkRowBatchIo&) = delete;
+
+    ~ChunkRowBatchIo() {
+        closeFiles();
+    }
+
+    ChunkIoMode getMode() const {
+        return _mode;
+    }
+
+    void readRows(const std::vector<RowTransfer>& parTransfers) {
+        transfer(parTransfers, false);
+    }
+
+    void writeRows(const std::vector<RowTransfer>& parTransfers) {
+        transfer(parTransfers, true);
+    }
+};
+
+#endif // CHUNKROWBATCHIO_H
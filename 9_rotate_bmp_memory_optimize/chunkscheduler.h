@@ -0,0 +1,127 @@
+#ifndef CHUNKSCHEDULER_H
+#define CHUNKSCHEDULER_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <algorithm>
+#include <condition_variable>
+
+// Output chunks are taken by workers from a shared counter in increasing order, so a free worker
+// always steals the next unprocessed chunk. Every worker owns its scratch and output tile, finished
+// tiles are written by the calling thread in chunk order. A worker waits until its tile is written
+// before taking the next chunk, so memory is bounded by threads count x chunk size.
+class ChunkScheduler {
+    static constexpr int64_t NO_CHUNK = -1;
+
+    int64_t _chunksCount;
+    uint64_t _threadsCount;
+    std::atomic<int64_t> _nextChunk;
+
+    std::mutex _mutex;
+    std::condition_variable _tileReady;
+    std::condition_variable _tileWritten;
+    std::vector<int64_t> _readyChunks;
+    bool _isStopped;
+    std::exception_ptr _error;
+
+    void stop(std::exception_ptr parError) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_error) {
+                _error = parError;
+            }
+            _isStopped = true;
+        }
+        _tileReady.notify_all();
+        _tileWritten.notify_all();
+    }
+
+    template<typename ProcessFunction>
+    void runWorker(uint64_t parWorker, ProcessFunction& parProcess) {
+        try {
+            for (int64_t chunk = _nextChunk++; chunk < _chunksCount; chunk = _nextChunk++) {
+                parProcess(parWorker, chunk);
+
+                std::unique_lock<std::mutex> lock(_mutex);
+                if (_isStopped) {
+                    return;
+                }
+                _readyChunks[parWorker] = chunk;
+                _tileReady.notify_all();
+                _tileWritten.wait(lock, [&]() { return _readyChunks[parWorker] == NO_CHUNK || _isStopped; });
+                if (_isStopped) {
+                    return;
+                }
+            }
+        } catch (...) {
+            stop(std::current_exception());
+        }
+    }
+
+public:
+    ChunkScheduler(int64_t parChunksCount, uint64_t parThreadsCount) {
+        _chunksCount = parChunksCount;
+        _threadsCount = std::clamp<uint64_t>(parThreadsCount, 1, std::max<int64_t>(parChunksCount, 1));
+        _nextChunk = 0;
+        _readyChunks.assign(_threadsCount, NO_CHUNK);
+        _isStopped = false;
+    }
+
+    static uint64_t getDefaultThreadsCount() {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    uint64_t getThreadsCount() const {
+        return _threadsCount;
+    }
+
+    // parProcess(worker, chunk) fills the worker's tile, parWrite(worker, chunk) stores it,
+    // the first exception of either stops all workers and is rethrown
+    template<typename ProcessFunction, typename WriteFunction>
+    void run(ProcessFunction parProcess, WriteFunction parWrite) {
+        std::vector<std::thread> threads;
+        for (uint64_t worker = 0; worker < _threadsCount; worker++) {
+            threads.emplace_back([this, worker, &parProcess]() { runWorker(worker, parProcess); });
+        }
+
+        try {
+            for (int64_t chunk = 0; chunk < _chunksCount; chunk++) {
+                uint64_t worker = 0;
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _tileReady.wait(lock, [&]() {
+                        return _isStopped || std::find(_readyChunks.begin(), _readyChunks.end(), chunk) != _readyChunks.end();
+                    });
+                    if (_isStopped) {
+                        break;
+                    }
+                    worker = std::find(_readyChunks.begin(), _readyChunks.end(), chunk) - _readyChunks.begin();
+                }
+
+                parWrite(worker, chunk);
+
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _readyChunks[worker] = NO_CHUNK;
+                }
+                _tileWritten.notify_all();
+            }
+        } catch (...) {
+            stop(std::current_exception());
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        if (_error) {
+            std::rethrow_exception(_error);
+        }
+    }
+};
+
+#endif // CHUNKSCHEDULER_H
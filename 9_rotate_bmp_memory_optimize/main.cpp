@@ -1,10 +1,15 @@
 #include "bitmap.h"
 #include "bitmapmatrix.h"
+#include "chunkrowbatchio.h"
+#include "chunkscheduler.h"
+#include "pixelrotationcheck.h"
+#include "../common/kerneltablecheck.h"
+#include "../common/mappedbitmap.h"
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
 #include <cstdint>
-#include <fstream>
 #include <memory>
 #include <vector>
 
@@ -12,21 +17,28 @@ using namespace std;
 
 
 int main(int argc, char** argv) {
+    // -check-pixels: rotation of chunks of linear planes of Bitmap24Pixel and of the TIFF pixel types
+    if (argc >= 2 && !strcmp(argv[1], "-check-pixels")) {
+        return runPixelRotationCheck();
+    }
+    // -check-kernels: rows of the interpolation kernel tables against the kernel functions
+    if (argc >= 2 && !strcmp(argv[1], "-check-kernels")) {
+        return runKernelTableCheck();
+    }
+
     if (argc < 6) {
         cerr << "Wrong parameters count!" << endl;
         return 1;
     }
 
-    ifstream inputStream;
-    inputStream.open(argv[1], ios_base::binary);
-
-    ofstream outputStream;
-    outputStream.open(argv[2], ios_base::binary);
-
-    if (!inputStream.is_open() || !outputStream.is_open()) {
-        cerr << "Can't open input files!" << endl;
+    std::unique_ptr<MappedBitmapReader> input;
+    try {
+        input = std::make_unique<MappedBitmapReader>(argv[1]);
+    } catch (const std::exception& exception) {
+        cerr << exception.what() << endl;
         return 2;
     }
+    input->adviseRandom();
 
     double degrees = 0;
     try {
@@ -37,15 +49,7 @@ int main(int argc, char** argv) {
     }
 
     InterpolationMode interpolationMode;
-    if (!strcmp("--nearestNeighbour", argv[4])) {
-        interpolationMode = InterpolationMode::NearestNeighbour;
-    } else if (!strcmp("--bilinear", argv[4])) {
-        interpolationMode = InterpolationMode::Bilinear;
-    } else if (!strcmp("--bicubic", argv[4])) {
-        interpolationMode = InterpolationMode::Bicubic;
-    } else if (!strcmp("--lanczos3", argv[4])) {
-        interpolationMode = InterpolationMode::Lanczos3;
-    } else {
+    if (!parseInterpolationMode(argv[4], interpolationMode)) {
         cerr << "Can't parse interpolation mode!" << endl;
         return 4;
     }
@@ -62,51 +66,65 @@ int main(int argc, char** argv) {
         return 5;
     }
 
-    BitmapFileHeader bitmapInputFileHeader;
-    BitmapInfoHeaderV3 bitmapInputInfoHeader;
+    ChunkIoMode chunkIoMode = ChunkIoMode::Mapped;
+    if (argc >= 7) {
+        if (!strcmp("--mmap", argv[6])) {
+            chunkIoMode = ChunkIoMode::Mapped;
+        } else if (!strcmp("--io_uring", argv[6])) {
+            chunkIoMode = ChunkIoMode::IoUring;
+        } else if (!strcmp("--preadv", argv[6])) {
+            chunkIoMode = ChunkIoMode::Vectored;
+        } else {
+            cerr << "Can't parse I/O mode!" << endl;
+            return 4;
+        }
+    }
 
-    inputStream.read((char*)&bitmapInputFileHeader, sizeof(BitmapFileHeader));
-    if (bitmapInputFileHeader.bfType != 0x4d42 || inputStream.fail()) {
-        cerr << "Not BMP file!" << endl;
-        return 5;
+    uint64_t threadsCount = ChunkScheduler::getDefaultThreadsCount();
+    if (argc >= 8) {
+        try {
+            threadsCount = stoull(argv[7]);
+        } catch (const std::exception& e) {
+            threadsCount = 0;
+        }
+        if (threadsCount == 0) {
+            cerr << "Can't parse threads count!" << endl;
+            return 10;
+        }
     }
 
-    inputStream.read((char*)&bitmapInputInfoHeader, sizeof(BitmapInfoHeaderV3));
-    inputStream.seekg(bitmapInputFileHeader.bfOffBits, ios_base::beg);
+    BitmapFileHeader bitmapInputFileHeader;
+    BitmapInfoHeaderV3 bitmapInputInfoHeader;
 
-    if (inputStream.fail()) {
-        cerr << "Error reading source file!" << endl;
+    try {
+        input->readHeaders(bitmapInputFileHeader, bitmapInputInfoHeader);
+    } catch (const std::exception& exception) {
+        cerr << exception.what() << endl;
         return 6;
     }
 
-    if (bitmapInputInfoHeader.biBitCount != 24) {
+    if (input->getBitCount() != 24) {
         cerr << "Not 24 bit BMP file!" << endl;
         return 7;
     }
 
-    int32_t inputWidthPx = bitmapInputInfoHeader.biWidth;
-    int32_t inputHeightPx = bitmapInputInfoHeader.biHeight;
+    int32_t inputWidthPx = input->getWidth();
+    int32_t inputHeightPx = input->getHeight();
 
     BitmapFileHeader bitmapOutputFileHeader = bitmapInputFileHeader;
     BitmapInfoHeaderV3 bitmapOutputInfoHeader = bitmapInputInfoHeader;
 
     int64_t inputRowBytesCountWithoutPadding = inputWidthPx * 3;
 
-    int64_t inputRowBytesCountWithPadding = getRowSizeWithPadding(inputRowBytesCountWithoutPadding);
-
-    int64_t inputPaddingBytes = inputRowBytesCountWithPadding - inputRowBytesCountWithoutPadding;
-
 
     int64_t pixelsPerChunkSideOutput = 100;
 
     int64_t deltaPadding = 5;
 
 
-    BitmapOptimizeMatrix inputBitmapMatrix(inputWidthPx, inputHeightPx, pixelsPerChunkSideOutput);
+    auto inputBitmapMatrix = std::make_unique<BitmapOptimizeMatrix<>>(inputWidthPx, inputHeightPx, pixelsPerChunkSideOutput);
 
-    inputStream.seekg(bitmapInputFileHeader.bfOffBits, ios_base::beg);
-
-    ImageNecessaryInfo outputImageInfo = inputBitmapMatrix.calculateRotatedImageInfo(degrees * M_PI / 180, zoom, deltaPadding);
+    ImageNecessaryInfo outputImageInfo = inputBitmapMatrix->calculateRotatedImageInfo(degrees * M_PI / 180, zoom, deltaPadding);
 
     int64_t outputWidthPx = outputImageInfo.getWidth();
     int64_t outputHeightPx = outputImageInfo.getHeight();
@@ -119,9 +137,15 @@ int main(int argc, char** argv) {
 
     bitmapOutputFileHeader.bfSize = sizeof(BitmapFileHeader) + sizeof(BitmapInfoHeaderV3) + outputRowBytesCountWithPadding * outputHeightPx;
     bitmapOutputFileHeader.bfOffBits = sizeof(BitmapFileHeader) + sizeof(BitmapInfoHeaderV3);
-    outputStream.write((char*)&bitmapOutputFileHeader, sizeof(BitmapFileHeader));
-    outputStream.write((char*)&bitmapOutputInfoHeader, sizeof(BitmapInfoHeaderV3));
-    std::unique_ptr<Bitmap24Pixel[]> outputChunk = std::make_unique<Bitmap24Pixel[]>(pixelsPerChunkSideOutput * pixelsPerChunkSideOutput);
+
+    std::unique_ptr<MappedBitmapWriter> output;
+    try {
+        output = std::make_unique<MappedBitmapWriter>(argv[2], bitmapOutputFileHeader, bitmapOutputInfoHeader,
+                                                      outputWidthPx, outputHeightPx);
+    } catch (const std::exception& exception) {
+        cerr << "Can't init output file!" << endl;
+        return 6;
+    }
 
 
     auto chunksPerWidthOutput = (outputWidthPx + pixelsPerChunkSideOutput - 1) / pixelsPerChunkSideOutput;
@@ -132,21 +156,43 @@ int main(int argc, char** argv) {
 
 
 
-    ChunkInfo chunkInfoOutput;
-
-    size_t bufferSize = outputRowBytesCountWithPadding;
-    vector<char>buffer(bufferSize, 0);
-
-    for (size_t i = 0; i < outputHeightPx; ++i) {
-        if (outputStream.fail()) {
-            cerr << "Can't init output file!" << endl;
-            return 6;
+    std::unique_ptr<ChunkRowBatchIo> chunkIo;
+    try {
+        chunkIo = std::make_unique<ChunkRowBatchIo>(*input, *output, argv[1], argv[2], chunkIoMode);
+    } catch (const std::exception& exception) {
+        cerr << exception.what() << endl;
+        return 2;
+    }
+    cout << "Chunk I/O: " << getChunkIoModeName(chunkIo->getMode()) << endl;
+
+    ChunkScheduler chunkScheduler(chunksCount, threadsCount);
+    cout << "Threads: " << chunkScheduler.getThreadsCount() << endl;
+
+    // Every worker has its own input scratch, output tile and reader (io_uring rings can't be shared),
+    // the first worker reuses the matrix the output size was calculated with
+    vector<unique_ptr<BitmapOptimizeMatrix<>>> inputBitmapMatrices;
+    vector<unique_ptr<Bitmap24Pixel[]>> outputChunks;
+    vector<unique_ptr<ChunkRowBatchIo>> chunkReaders;
+    vector<vector<RowTransfer>> readTransfers(chunkScheduler.getThreadsCount());
+    std::atomic<bool> isReadFailed = false;
+    try {
+        for (uint64_t worker = 0; worker < chunkScheduler.getThreadsCount(); worker++) {
+            if (worker == 0) {
+                inputBitmapMatrices.push_back(std::move(inputBitmapMatrix));
+            } else {
+                inputBitmapMatrices.push_back(std::make_unique<BitmapOptimizeMatrix<>>(inputWidthPx, inputHeightPx, pixelsPerChunkSideOutput));
+                inputBitmapMatrices.back()->calculateRotatedImageInfo(degrees * M_PI / 180, zoom, deltaPadding);
+            }
+            outputChunks.push_back(std::make_unique<Bitmap24Pixel[]>(pixelsPerChunkSideOutput * pixelsPerChunkSideOutput));
+            chunkReaders.push_back(std::make_unique<ChunkRowBatchIo>(*input, *output, argv[1], argv[2], chunkIo->getMode()));
         }
-        outputStream.write(buffer.data(), bufferSize);
+    } catch (const std::exception& exception) {
+        cerr << exception.what() << endl;
+        return 2;
     }
 
-    for (int64_t i = 0; i < chunksCount ; i++) {
-
+    auto getOutputChunkInfo = [&](int64_t i) {
+        ChunkInfo chunkInfoOutput;
         chunkInfoOutput.aX = (i % chunksPerWidthOutput) * pixelsPerChunkSideOutput;
         chunkInfoOutput.bX = (i % chunksPerWidthOutput) * pixelsPerChunkSideOutput + pixelsPerChunkSideOutput;
         chunkInfoOutput.cX = (i % chunksPerWidthOutput) * pixelsPerChunkSideOutput;
@@ -157,8 +203,15 @@ int main(int argc, char** argv) {
         chunkInfoOutput.bY = (i / chunksPerWidthOutput) * pixelsPerChunkSideOutput;
         chunkInfoOutput.cY = (i / chunksPerWidthOutput) * pixelsPerChunkSideOutput + pixelsPerChunkSideOutput;
         chunkInfoOutput.dY = (i / chunksPerWidthOutput) * pixelsPerChunkSideOutput + pixelsPerChunkSideOutput;
+        return chunkInfoOutput;
+    };
+
+    auto processChunk = [&](uint64_t worker, int64_t i) {
+        BitmapOptimizeMatrix<>& workerBitmapMatrix = *inputBitmapMatrices[worker];
+        vector<RowTransfer>& workerReadTransfers = readTransfers[worker];
+        ChunkInfo chunkInfoOutput = getOutputChunkInfo(i);
 
-        ChunkInfo inputChunkInfo = inputBitmapMatrix.calculateRowColsInputImage(chunkInfoOutput, outputImageInfo);
+        ChunkInfo inputChunkInfo = workerBitmapMatrix.calculateRowColsInputImage(chunkInfoOutput, outputImageInfo);
 
         double minXDouble = std::min(std::min(inputChunkInfo.aX, inputChunkInfo.bX), std::min(inputChunkInfo.cX, inputChunkInfo.dX));
         double minYDouble = std::min(std::min(inputChunkInfo.aY, inputChunkInfo.bY), std::min(inputChunkInfo.cY, inputChunkInfo.dY));
@@ -175,12 +228,13 @@ int main(int argc, char** argv) {
         int64_t height = maxY - minY;
 
         int rowCounter = -1;
+        workerReadTransfers.clear();
 
-        inputBitmapMatrix._pixelsPerChunkSideInput = width;
-        inputBitmapMatrix._padding = 0;
+        workerBitmapMatrix._pixelsPerChunkSideInput = width;
+        workerBitmapMatrix._padding = 0;
         for (int x = 0; x < width; x++) {
             for (int y = 0; y < height; y++) {
-                auto pixel = inputBitmapMatrix(x, y);
+                auto pixel = workerBitmapMatrix(x, y);
                 pixel->red = 255;
                 pixel->green = 255;
                 pixel->blue = 255;
@@ -200,29 +254,34 @@ int main(int argc, char** argv) {
             int64_t col = minX >= 0 ? minX : 0;
             int64_t xPadding = minX >= 0 ? 0 : -minX;
 
-            int64_t bytesToRead = (width - xPadding) * 3;
-            int64_t bytesToRowEnd = std::max(inputRowBytesCountWithoutPadding - minX * 3, 0L);
-
-            inputStream.seekg(bitmapInputFileHeader.bfOffBits + row * inputRowBytesCountWithPadding + (col) * 3, std::ios::beg);
+            int64_t bytesToRead = std::min((width - xPadding) * 3, inputRowBytesCountWithoutPadding - col * 3);
 
             if (bytesToRead > 0) {
-                inputStream.read(reinterpret_cast<char*>(inputBitmapMatrix(rowCounter) + xPadding), std::min(bytesToRead, bytesToRowEnd));
+                workerReadTransfers.push_back({row, static_cast<uint64_t>(col * 3), reinterpret_cast<uint8_t*>(workerBitmapMatrix(rowCounter) + xPadding),
+                                               static_cast<uint64_t>(bytesToRead)});
             }
         }
 
-        if (inputStream.fail()) {
-            std::cerr << "Error reading source file!" << std::endl;
-            return 8;
+        try {
+            chunkReaders[worker]->readRows(workerReadTransfers);
+        } catch (...) {
+            isReadFailed = true;
+            throw;
         }
 
 
         width -= 2 * deltaPadding;
         height -= 2 * deltaPadding;
-        inputBitmapMatrix._pixelsPerChunkSideInput = width;
+        workerBitmapMatrix._pixelsPerChunkSideInput = width;
 
-        inputBitmapMatrix.calculateOutputChunk(pixelsPerChunkSideOutput, pixelsPerChunkSideOutput, degrees * M_PI / 180, zoom, outputImageInfo, outputChunk.get(), interpolationMode, deltaPadding,
+        workerBitmapMatrix.calculateOutputChunk(pixelsPerChunkSideOutput, pixelsPerChunkSideOutput, degrees * M_PI / 180, zoom, outputImageInfo, outputChunks[worker].get(), interpolationMode, deltaPadding,
                                                  (-minX + minXDouble - deltaPadding),  (-minY + minYDouble - deltaPadding));
+    };
 
+    vector<RowTransfer> writeTransfers;
+    auto writeChunk = [&](uint64_t worker, int64_t i) {
+        ChunkInfo chunkInfoOutput = getOutputChunkInfo(i);
+        writeTransfers.clear();
 
         for (int64_t y = 0; y < pixelsPerChunkSideOutput; y++) {
             int64_t outputRow = outputImageInfo.getHeight() - ((chunkInfoOutput.aY) + y) - 1; // Перевод в BMP-координаты
@@ -231,13 +290,19 @@ int main(int argc, char** argv) {
                 continue;
             }
 
-            int64_t fileOffset = bitmapOutputFileHeader.bfOffBits + outputRow * outputRowBytesCountWithPadding + chunkInfoOutput.aX * 3;
-            outputStream.seekp(fileOffset, std::ios::beg);
-
             int64_t currentWidth = std::min(std::abs(outputWidthPx - (int64_t)chunkInfoOutput.aX), pixelsPerChunkSideOutput);
-            outputStream.write(reinterpret_cast<char*>(outputChunk.get() + y * pixelsPerChunkSideOutput), currentWidth * 3);
-
+            writeTransfers.push_back({outputRow, static_cast<uint64_t>(chunkInfoOutput.aX) * 3,
+                                      reinterpret_cast<uint8_t*>(outputChunks[worker].get() + y * pixelsPerChunkSideOutput), static_cast<uint64_t>(currentWidth * 3)});
         }
+
+        chunkIo->writeRows(writeTransfers);
+    };
+
+    try {
+        chunkScheduler.run(processChunk, writeChunk);
+    } catch (const std::exception& exception) {
+        cerr << exception.what() << endl;
+        return isReadFailed ? 8 : 9;
     }
 
     return 0;
@@ -0,0 +1,90 @@
+#ifndef PIXELROTATIONCHECK_H
+#define PIXELROTATIONCHECK_H
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "bitmap.h"
+#include "bitmapmatrix.h"
+#include "../common/linearplane.h"
+
+// Rotates one chunk of a linear plane of PixelType, the input chunk with its padding is filled as by main. Returns true
+// if the output chunk matches the plane: at the reverse mapped coordinates for bilinear, at the truncated ones for
+// nearest neighbour, the default pixel outside of the padding
+template <typename PixelType>
+inline bool checkChunkRotation(const char* parPixelName, InterpolationMode parInterpolationMode) {
+    constexpr int64_t CHUNK_SIDE = 40;
+    constexpr int64_t PADDING = 5;
+    constexpr double DEGREES = 30;
+    constexpr double ZOOM = 1.3;
+    constexpr double CHUNK_OFFSET = -PADDING + 0.375;
+    double alpha = DEGREES * M_PI / 180;
+
+    LinearPlane<PixelType> plane;
+    BitmapOptimizeMatrix<PixelType> bitmapMatrix(3 * CHUNK_SIDE, 2 * CHUNK_SIDE, CHUNK_SIDE);
+    ImageNecessaryInfo outputImageInfo = bitmapMatrix.calculateRotatedImageInfo(alpha, ZOOM, PADDING);
+    for (int64_t row = -PADDING; row < CHUNK_SIDE + PADDING; row++) {
+        for (int64_t col = -PADDING; col < CHUNK_SIDE + PADDING; col++) {
+            *bitmapMatrix(row, col) = plane.getPixel(col, row);
+        }
+    }
+
+    std::vector<PixelType> outputChunk(CHUNK_SIDE * CHUNK_SIDE);
+    bitmapMatrix.calculateOutputChunk(CHUNK_SIDE, CHUNK_SIDE, alpha, ZOOM, outputImageInfo, outputChunk.data(), parInterpolationMode,
+                                      PADDING, CHUNK_OFFSET, CHUNK_OFFSET);
+
+    RotateMatrix rotateMatrix(alpha, 0, 0, ZOOM);
+    std::pair<double, double> offset = bitmapMatrix.getChunkSourceOffset(alpha, ZOOM);
+    bool isNearest = parInterpolationMode == InterpolationMode::NearestNeighbour;
+    PixelType defaultPixel = PixelTraits<PixelType>::getDefaultPixel();
+    double maxError = 0;
+    int64_t checkedCount = 0;
+    int64_t wrongCount = 0;
+    for (int64_t row = 0; row < CHUNK_SIDE; row++) {
+        for (int64_t col = 0; col < CHUNK_SIDE; col++) {
+            const PixelType& pixel = outputChunk[row * CHUNK_SIDE + col];
+            std::pair<double, double> coordinates = rotateMatrix.getXYReverseCoordinates(col, row);
+            double x = coordinates.first + offset.first + CHUNK_OFFSET;
+            double y = coordinates.second + offset.second + CHUNK_OFFSET;
+            if (isNearest) {
+                int64_t sourceCol = static_cast<int64_t>(x);
+                int64_t sourceRow = static_cast<int64_t>(y);
+                if (sourceCol < -PADDING || sourceRow < -PADDING || sourceCol >= CHUNK_SIDE + PADDING || sourceRow >= CHUNK_SIDE + PADDING) {
+                    if (!LinearPlane<PixelType>::isSame(pixel, defaultPixel)) {
+                        wrongCount++;
+                    }
+                    continue;
+                }
+                maxError = std::max(maxError, plane.getError(pixel, sourceCol, sourceRow));
+                checkedCount++;
+                continue;
+            }
+            if (std::floor(x) < -PADDING || std::floor(y) < -PADDING || std::ceil(x) > CHUNK_SIDE + PADDING - 1 ||
+                std::ceil(y) > CHUNK_SIDE + PADDING - 1) {
+                continue;
+            }
+            maxError = std::max(maxError, plane.getError(pixel, x, y));
+            checkedCount++;
+        }
+    }
+
+    std::cout << parPixelName << (isNearest ? " nearest neighbour" : " bilinear") << ": max error " << maxError << " of "
+              << checkedCount << " pixels, wrong pixels: " << wrongCount << std::endl;
+    return checkedCount > 0 && maxError <= LinearPlane<PixelType>::getTolerance() && wrongCount == 0;
+}
+
+// Rotation of every pixel type the BitmapOptimizeMatrix is instantiated for, returns 0 if it is correct
+inline int runPixelRotationCheck() {
+    bool isCorrect = true;
+    for (InterpolationMode interpolationMode : {InterpolationMode::NearestNeighbour, InterpolationMode::Bilinear}) {
+        isCorrect &= checkChunkRotation<Bitmap24Pixel>("Bitmap24Pixel", interpolationMode);
+        isCorrect &= checkChunkRotation<Tiff16RGBPixel>("Tiff16RGBPixel", interpolationMode);
+        isCorrect &= checkChunkRotation<FloatPixel>("FloatPixel", interpolationMode);
+        isCorrect &= checkChunkRotation<Complex16Pixel>("Complex16Pixel", interpolationMode);
+    }
+    std::cout << (isCorrect ? "Check passed" : "Check failed") << std::endl;
+    return isCorrect ? 0 : 1;
+}
+
+#endif // PIXELROTATIONCHECK_H
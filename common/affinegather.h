@@ -0,0 +1,235 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <climits>
+#include "kerneltables.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AFFINE_GATHER_X86
+#endif
+
+// Pixels of a plane that can be read without bounds checks: rows minRow..maxRow, cols minCol..maxCol,
+// origin points to pixel (minRow, minCol). Vector code loads pixels as 32-bit words, so one more byte after the last pixel must be readable.
+template<typename PixelType>
+struct GatherPlane {
+    const PixelType* origin;
+    int64_t stride;
+    int64_t minRow;
+    int64_t maxRow;
+    int64_t minCol;
+    int64_t maxCol;
+};
+
+// AVX2 interpolation of this plane
+template<typename PixelType>
+inline bool isAffineGatherSupported(const GatherPlane<PixelType>& parPlane) {
+#ifdef AFFINE_GATHER_X86
+    static const bool isAvx2Supported = []() {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+    }();
+
+    // Pixel indexes of vector gathers are 32-bit
+    int64_t lastIndex = (parPlane.maxRow - parPlane.minRow) * parPlane.stride + parPlane.maxCol - parPlane.minCol;
+    return isAvx2Supported && lastIndex < INT32_MAX;
+#else
+    return false;
+#endif
+}
+
+// Nearest neighbour (truncated coordinates) of any pixel type, pixels outside of the plane are parDefaultPixel
+template<typename PixelType>
+inline void gatherNearest(const GatherPlane<PixelType>& parPlane, const double* parX, const double* parY, int64_t parCount,
+                          PixelType* parOut, const PixelType& parDefaultPixel) {
+    for (int64_t k = 0; k < parCount; k++) {
+        int64_t col = static_cast<int64_t>(parX[k]);
+        int64_t row = static_cast<int64_t>(parY[k]);
+        bool isInside = row >= parPlane.minRow && row <= parPlane.maxRow && col >= parPlane.minCol && col <= parPlane.maxCol;
+        parOut[k] = isInside ? parPlane.origin[(row - parPlane.minRow) * parPlane.stride + col - parPlane.minCol] : parDefaultPixel;
+    }
+}
+
+#ifdef AFFINE_GATHER_X86
+// Vector code is for pixels of three 8-bit channels (Bitmap24Pixel), channel k is byte k of the pixel.
+// Separate loads are used instead of vpgatherdd, which is slower on CPUs with the gather data sampling mitigation
+template<typename PixelType>
+__attribute__((target("avx2")))
+inline __m128i gatherPixelsAvx2(const GatherPlane<PixelType>& parPlane, __m128i parRows, __m128i parCols) {
+    int32_t indexes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(indexes),
+                     _mm_add_epi32(_mm_mullo_epi32(parRows, _mm_set1_epi32(static_cast<int32_t>(parPlane.stride))), parCols));
+    int32_t pixels[4];
+    for (int64_t l = 0; l < 4; l++) {
+        memcpy(pixels + l, parPlane.origin + indexes[l], sizeof(int32_t));
+    }
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+}
+
+__attribute__((target("avx2")))
+inline __m256d getChannelAvx2(__m128i parPixels, int parShift) {
+    return _mm256_cvtepi32_pd(_mm_and_si128(_mm_srli_epi32(parPixels, parShift), _mm_set1_epi32(0xff)));
+}
+
+template<typename PixelType>
+inline void storePixels(PixelType* parOut, const int32_t parPixels[4]) {
+    for (int64_t l = 0; l < 4; l++) {
+        memcpy(reinterpret_cast<uint8_t*>(parOut + l), parPixels + l, sizeof(PixelType));
+    }
+}
+
+// Bilinear interpolation of 4 pixels per step with the same operations order as PixelTraits::interpolateBilinear.
+// Steps with any of 4 neighbourhoods outside of the plane are calculated by parFallback(index).
+// Returns count of processed pixels, the rest (less than 4) is left to the caller.
+template<typename PixelType, typename Fallback>
+__attribute__((target("avx2")))
+inline int64_t interpolateBilinearAvx2(const GatherPlane<PixelType>& parPlane, const double* parX, const double* parY, int64_t parCount,
+                                       PixelType* parOut, Fallback& parFallback) {
+    static_assert(sizeof(PixelType) == 3, "Pixels of three 8-bit channels are interpolated");
+    const __m256d one = _mm256_set1_pd(1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m256d minCol = _mm256_set1_pd(static_cast<double>(parPlane.minCol));
+    const __m256d maxCol = _mm256_set1_pd(static_cast<double>(parPlane.maxCol));
+    const __m256d minRow = _mm256_set1_pd(static_cast<double>(parPlane.minRow));
+    const __m256d maxRow = _mm256_set1_pd(static_cast<double>(parPlane.maxRow));
+
+    int64_t k = 0;
+    for (; k + 4 <= parCount; k += 4) {
+        __m256d x = _mm256_loadu_pd(parX + k);
+        __m256d y = _mm256_loadu_pd(parY + k);
+        __m256d x1 = _mm256_floor_pd(x);
+        __m256d y1 = _mm256_floor_pd(y);
+        __m256d x2 = _mm256_ceil_pd(x);
+        __m256d y2 = _mm256_ceil_pd(y);
+
+        __m256d inside = _mm256_and_pd(_mm256_and_pd(_mm256_cmp_pd(x1, minCol, _CMP_GE_OQ), _mm256_cmp_pd(x2, maxCol, _CMP_LE_OQ)),
+                                       _mm256_and_pd(_mm256_cmp_pd(y1, minRow, _CMP_GE_OQ), _mm256_cmp_pd(y2, maxRow, _CMP_LE_OQ)));
+        if (_mm256_movemask_pd(inside) != 0xf) {
+            for (int64_t l = k; l < k + 4; l++) {
+                parFallback(l);
+            }
+            continue;
+        }
+
+        __m256d dx = _mm256_sub_pd(x, x1);
+        __m256d dy = _mm256_sub_pd(y, y1);
+        __m256d w1 = _mm256_mul_pd(_mm256_sub_pd(one, dx), _mm256_sub_pd(one, dy));
+        __m256d w2 = _mm256_mul_pd(dx, _mm256_sub_pd(one, dy));
+        __m256d w3 = _mm256_mul_pd(_mm256_sub_pd(one, dx), dy);
+        __m256d w4 = _mm256_mul_pd(dx, dy);
+
+        // Rows and cols relative to the plane origin
+        __m128i cols1 = _mm256_cvttpd_epi32(_mm256_sub_pd(x1, minCol));
+        __m128i rows1 = _mm256_cvttpd_epi32(_mm256_sub_pd(y1, minRow));
+        __m128i cols2 = _mm256_cvttpd_epi32(_mm256_sub_pd(x2, minCol));
+        __m128i rows2 = _mm256_cvttpd_epi32(_mm256_sub_pd(y2, minRow));
+        __m128i p1 = gatherPixelsAvx2(parPlane, rows1, cols1);
+        __m128i p2 = gatherPixelsAvx2(parPlane, rows1, cols2);
+        __m128i p3 = gatherPixelsAvx2(parPlane, rows2, cols1);
+        __m128i p4 = gatherPixelsAvx2(parPlane, rows2, cols2);
+
+        __m128i result = zero;
+        for (int shift = 0; shift <= 16; shift += 8) {
+            __m256d value = _mm256_mul_pd(w1, getChannelAvx2(p1, shift));
+            value = _mm256_add_pd(value, _mm256_mul_pd(w2, getChannelAvx2(p2, shift)));
+            value = _mm256_add_pd(value, _mm256_mul_pd(w3, getChannelAvx2(p3, shift)));
+            value = _mm256_add_pd(value, _mm256_mul_pd(w4, getChannelAvx2(p4, shift)));
+            result = _mm_or_si128(result, _mm_slli_epi32(_mm256_cvttpd_epi32(value), shift));
+        }
+
+        int32_t pixels[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels), result);
+        storePixels(parOut + k, pixels);
+    }
+    return k;
+}
+
+// Interpolation of 8 pixels per step in float with KERNEL_TABLE<Kernel, float> rows, taps are the same as of
+// PixelInterpolation::interpolateKernel: taps of a row are summed first, then weighted by the row weight.
+// Results are truncated as PixelTraits::makePixel and differ from the double calculation only by rounding.
+// Steps with any tap outside of the plane are calculated by parFallback(index).
+// Returns count of processed pixels, the rest (less than 8) is left to the caller.
+template<typename Kernel, typename PixelType, typename Fallback>
+__attribute__((target("avx2")))
+inline int64_t interpolateKernelAvx2(const GatherPlane<PixelType>& parPlane, const double* parX, const double* parY, int64_t parCount,
+                                     PixelType* parOut, Fallback& parFallback) {
+    static_assert(sizeof(PixelType) == 3, "Pixels of three 8-bit channels are interpolated");
+    constexpr int64_t RADIUS = Kernel::RADIUS;
+    constexpr int64_t TAPS_COUNT = 2 * RADIUS;
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 maxValue = _mm256_set1_ps(255);
+    const __m256i channelMask = _mm256_set1_epi32(0xff);
+
+    int64_t k = 0;
+    for (; k + 8 <= parCount; k += 8) {
+        alignas(32) float weightsX[TAPS_COUNT][8];
+        alignas(32) float weightsY[TAPS_COUNT][8];
+        alignas(32) int32_t firstCols[8];
+        alignas(32) int32_t firstRows[8];
+        bool isInside = true;
+        for (int64_t l = 0; l < 8; l++) {
+            double x1 = std::floor(parX[k + l]);
+            double y1 = std::floor(parY[k + l]);
+            isInside = x1 - RADIUS + 1 >= parPlane.minCol && x1 + RADIUS <= parPlane.maxCol &&
+                       y1 - RADIUS + 1 >= parPlane.minRow && y1 + RADIUS <= parPlane.maxRow;
+            if (!isInside) {
+                break;
+            }
+            // Relative to the plane origin
+            firstCols[l] = static_cast<int32_t>(x1 - RADIUS + 1 - parPlane.minCol);
+            firstRows[l] = static_cast<int32_t>(y1 - RADIUS + 1 - parPlane.minRow);
+            float weights[TAPS_COUNT];
+            KERNEL_TABLE<Kernel, float>.getWeights(parX[k + l] - x1, weights);
+            for (int64_t t = 0; t < TAPS_COUNT; t++) {
+                weightsX[t][l] = weights[t];
+            }
+            KERNEL_TABLE<Kernel, float>.getWeights(parY[k + l] - y1, weights);
+            for (int64_t t = 0; t < TAPS_COUNT; t++) {
+                weightsY[t][l] = weights[t];
+            }
+        }
+        if (!isInside) {
+            for (int64_t l = k; l < k + 8; l++) {
+                parFallback(l);
+            }
+            continue;
+        }
+
+        __m256i cols = _mm256_load_si256(reinterpret_cast<const __m256i*>(firstCols));
+        __m256i rows = _mm256_load_si256(reinterpret_cast<const __m256i*>(firstRows));
+        __m256 values[3] = {zero, zero, zero};
+        for (int64_t j = 0; j < TAPS_COUNT; j++) {
+            __m256i tapRows = _mm256_add_epi32(rows, _mm256_set1_epi32(static_cast<int32_t>(j)));
+            __m256 rowValues[3] = {zero, zero, zero};
+            for (int64_t i = 0; i < TAPS_COUNT; i++) {
+                __m256i tapCols = _mm256_add_epi32(cols, _mm256_set1_epi32(static_cast<int32_t>(i)));
+                __m256i pixels = _mm256_set_m128i(
+                    gatherPixelsAvx2(parPlane, _mm256_extracti128_si256(tapRows, 1), _mm256_extracti128_si256(tapCols, 1)),
+                    gatherPixelsAvx2(parPlane, _mm256_castsi256_si128(tapRows), _mm256_castsi256_si128(tapCols)));
+                __m256 weightX = _mm256_load_ps(weightsX[i]);
+                for (int c = 0; c < 3; c++) {
+                    __m256 channel = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(pixels, 8 * c), channelMask));
+                    rowValues[c] = _mm256_add_ps(rowValues[c], _mm256_mul_ps(weightX, channel));
+                }
+            }
+            __m256 weightY = _mm256_load_ps(weightsY[j]);
+            for (int c = 0; c < 3; c++) {
+                values[c] = _mm256_add_ps(values[c], _mm256_mul_ps(weightY, rowValues[c]));
+            }
+        }
+
+        __m256i result = _mm256_setzero_si256();
+        for (int c = 0; c < 3; c++) {
+            __m256i channel = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(values[c], zero), maxValue));
+            result = _mm256_or_si256(result, _mm256_slli_epi32(channel, 8 * c));
+        }
+        alignas(32) int32_t pixels[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(pixels), result);
+        storePixels(parOut + k, pixels);
+        storePixels(parOut + k + 4, pixels + 4);
+    }
+    return k;
+}
+#endif
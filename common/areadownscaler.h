@@ -0,0 +1,125 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+// Box filter downscale by a real factor >= 1. Output pixel (x, y) is the mean of the source area
+// [x * factor, (x + 1) * factor) x [y * factor, (y + 1) * factor) clipped to the image, border pixels of the area are
+// weighted by their coverage. Input rows are added once and in order: every row is summed into float sums of one or two
+// output rows, the columns are reduced when an output row is complete. T has red, green and blue channels of one type.
+template<typename T>
+class AreaDownscaler {
+    using ChannelType = decltype(T::red);
+    static_assert(sizeof(T) == 3 * sizeof(ChannelType), "Pixel must be three packed channels");
+
+    uint64_t inputWidth;
+    uint64_t inputHeight;
+    uint64_t outputWidth;
+    uint64_t outputHeight;
+    double factor;
+
+    // Taps columnTapsOffsets[x] .. columnTapsOffsets[x + 1] - 1 are input columns of output column x with their weights
+    std::vector<uint64_t> columnTapsOffsets;
+    std::vector<uint64_t> columnTaps;
+    std::vector<float> columnWeights;
+
+    std::vector<float> currentSums;
+    std::vector<float> nextSums;
+    std::vector<T> outputRow;
+    uint64_t inputRowIndex = 0;
+    uint64_t outputRowIndex = 0;
+
+    static uint64_t getOutputSize(uint64_t inputSize, double factor) {
+        return std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(inputSize / factor - 1e-9)));
+    }
+
+    // End of the source interval of output index, the last one ends at the image border
+    double getIntervalEnd(uint64_t index, uint64_t outputSize, uint64_t inputSize) const {
+        return index + 1 == outputSize ? inputSize : std::min((index + 1) * factor, static_cast<double>(inputSize));
+    }
+
+    static void accumulateRow(float* sums, const ChannelType* channels, uint64_t channelsCount, float weight) {
+        for (uint64_t i = 0; i < channelsCount; i++) {
+            sums[i] += weight * channels[i];
+        }
+    }
+
+    template<typename Tfunc>
+    void emitRow(Tfunc rowCallback) {
+        double rowStart = outputRowIndex * factor;
+        float rowArea = getIntervalEnd(outputRowIndex, outputHeight, inputHeight) - rowStart;
+        for (uint64_t x = 0; x < outputWidth; x++) {
+            float values[3] = {0, 0, 0};
+            for (uint64_t k = columnTapsOffsets[x]; k < columnTapsOffsets[x + 1]; k++) {
+                const float* sums = currentSums.data() + columnTaps[k] * 3;
+                values[0] += columnWeights[k] * sums[0];
+                values[1] += columnWeights[k] * sums[1];
+                values[2] += columnWeights[k] * sums[2];
+            }
+            outputRow[x].red = static_cast<ChannelType>(values[0] / rowArea + 0.5f);
+            outputRow[x].green = static_cast<ChannelType>(values[1] / rowArea + 0.5f);
+            outputRow[x].blue = static_cast<ChannelType>(values[2] / rowArea + 0.5f);
+        }
+        rowCallback(outputRowIndex, outputRow.data());
+        std::swap(currentSums, nextSums);
+        std::fill(nextSums.begin(), nextSums.end(), 0.0f);
+        outputRowIndex++;
+    }
+
+public:
+    AreaDownscaler(uint64_t inputWidth, uint64_t inputHeight, double factor)
+        : inputWidth(inputWidth), inputHeight(inputHeight), factor(factor) {
+        outputWidth = getOutputSize(inputWidth, factor);
+        outputHeight = getOutputSize(inputHeight, factor);
+
+        // Column weights are normalized by the column width, rows by the row height in emitRow
+        columnTapsOffsets.push_back(0);
+        for (uint64_t x = 0; x < outputWidth; x++) {
+            double start = x * factor;
+            double end = getIntervalEnd(x, outputWidth, inputWidth);
+            for (uint64_t column = static_cast<uint64_t>(start); column < end; column++) {
+                double coverage = std::min<double>(column + 1, end) - std::max<double>(column, start);
+                if (coverage > 0) {
+                    columnTaps.push_back(column);
+                    columnWeights.push_back(coverage / (end - start));
+                }
+            }
+            columnTapsOffsets.push_back(columnTaps.size());
+        }
+
+        currentSums.assign(inputWidth * 3, 0.0f);
+        nextSums.assign(inputWidth * 3, 0.0f);
+        outputRow.resize(outputWidth);
+    }
+
+    uint64_t getOutputWidth() const {
+        return outputWidth;
+    }
+
+    uint64_t getOutputHeight() const {
+        return outputHeight;
+    }
+
+    // rowCallback(outputRowIndex, const T* outputRow) is called for every output row once it is complete
+    template<typename Tfunc>
+    void addRow(const T* inputRow, Tfunc rowCallback) {
+        const ChannelType* channels = reinterpret_cast<const ChannelType*>(inputRow);
+        double rowEnd = getIntervalEnd(outputRowIndex, outputHeight, inputHeight);
+        float currentWeight = std::min(1.0, rowEnd - inputRowIndex);
+        accumulateRow(currentSums.data(), channels, inputWidth * 3, currentWeight);
+        if (currentWeight < 1.0f) {
+            accumulateRow(nextSums.data(), channels, inputWidth * 3, 1.0f - currentWeight);
+        }
+        inputRowIndex++;
+
+        if (inputRowIndex >= rowEnd) {
+            emitRow(rowCallback);
+        }
+        if (inputRowIndex == inputHeight) {
+            while (outputRowIndex < outputHeight) {
+                emitRow(rowCallback);
+            }
+        }
+    }
+};
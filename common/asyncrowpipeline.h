@@ -0,0 +1,207 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <exception>
+#include <stdexcept>
+#include <algorithm>
+#include <condition_variable>
+#include "mappedbitmap.h"
+
+// Bounded single-producer single-consumer queue of fixed size rows.
+// Slot returned by beginPush/beginPop belongs to the caller until endPush/endPop.
+class BoundedRowQueue
+{
+private:
+    std::unique_ptr<uint8_t[]> data;
+    uint64_t rowBytesCount;
+    uint64_t capacity;
+    uint64_t headIndex;
+    uint64_t count;
+    bool isClosed;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+
+public:
+    BoundedRowQueue(uint64_t rowBytesCount, uint64_t capacity)
+        : rowBytesCount(rowBytesCount), capacity(std::max<uint64_t>(capacity, 1)),
+          headIndex(0), count(0), isClosed(false) {
+        data = std::make_unique<uint8_t[]>(this->capacity * rowBytesCount);
+    }
+
+    // nullptr if queue is closed
+    uint8_t* beginPush() {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this]() { return count < capacity || isClosed; });
+        if (isClosed) {
+            return nullptr;
+        }
+        return data.get() + ((headIndex + count) % capacity) * rowBytesCount;
+    }
+
+    void endPush() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            count++;
+        }
+        notEmpty.notify_one();
+    }
+
+    // nullptr if queue is closed and all pushed rows are already popped
+    const uint8_t* beginPop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this]() { return count > 0 || isClosed; });
+        if (count == 0) {
+            return nullptr;
+        }
+        return data.get() + headIndex * rowBytesCount;
+    }
+
+    void endPop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            headIndex = (headIndex + 1) % capacity;
+            count--;
+        }
+        notFull.notify_one();
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            isClosed = true;
+        }
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+};
+
+// Queue length for rows of this size: enough to hide page faults of a few megabytes, at least double buffering
+inline uint64_t getDefaultRowQueueLength(uint64_t rowBytesCount) {
+    constexpr uint64_t QUEUE_BYTES_COUNT = 4 << 20;
+    constexpr uint64_t MAX_QUEUE_LENGTH = 64;
+    return std::clamp<uint64_t>(QUEUE_BYTES_COUNT / std::max<uint64_t>(rowBytesCount, 1), 2, MAX_QUEUE_LENGTH);
+}
+
+// Reader thread copies rows of the mapped input (bottom-up order, with padding) into the queue ahead of the consumer,
+// so page faults on cold input are taken outside of the compute loop
+class AsyncBitmapRowReader
+{
+private:
+    const MappedBitmapReader& input;
+    uint64_t rowBytesCount;
+    BoundedRowQueue queue;
+    std::exception_ptr error;
+    std::thread thread;
+
+    void readRows() {
+        try {
+            for (int64_t row = 0; row < input.getHeight(); row++) {
+                uint8_t* slot = queue.beginPush();
+                if (!slot) {
+                    return;
+                }
+                memcpy(slot, input.getRow(row), rowBytesCount);
+                queue.endPush();
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+        queue.close();
+    }
+
+public:
+    AsyncBitmapRowReader(const MappedBitmapReader& input, uint64_t queueLength)
+        : input(input), rowBytesCount(input.getRowBytesCountWithPadding()), queue(rowBytesCount, queueLength) {
+        thread = std::thread(&AsyncBitmapRowReader::readRows, this);
+    }
+
+    AsyncBitmapRowReader(const AsyncBitmapRowReader&) = delete;
+    AsyncBitmapRowReader& operator=(const AsyncBitmapRowReader&) = delete;
+
+    ~AsyncBitmapRowReader() {
+        queue.close();
+        thread.join();
+    }
+
+    // Copies next row (bytesCount <= row size with padding)
+    void readRow(void* destination, uint64_t bytesCount) {
+        const uint8_t* slot = queue.beginPop();
+        if (!slot) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            throw std::runtime_error("Error reading source image!");
+        }
+        memcpy(destination, slot, std::min(bytesCount, rowBytesCount));
+        queue.endPop();
+    }
+};
+
+// Writer thread drains finished rows into the mapped output in bottom-up order,
+// finish() waits until all of them are written
+class AsyncBitmapRowWriter
+{
+private:
+    const MappedBitmapWriter& output;
+    uint64_t rowBytesCount;
+    BoundedRowQueue queue;
+    std::exception_ptr error;
+    std::thread thread;
+
+    void writeRows() {
+        try {
+            int64_t row = 0;
+            while (const uint8_t* slot = queue.beginPop()) {
+                memcpy(output.getRow(row++), slot, rowBytesCount);
+                queue.endPop();
+            }
+        } catch (...) {
+            error = std::current_exception();
+            queue.close();
+        }
+    }
+
+public:
+    AsyncBitmapRowWriter(const MappedBitmapWriter& output, uint64_t queueLength)
+        : output(output), rowBytesCount(output.getRowBytesCountWithPadding()), queue(rowBytesCount, queueLength) {
+        thread = std::thread(&AsyncBitmapRowWriter::writeRows, this);
+    }
+
+    AsyncBitmapRowWriter(const AsyncBitmapRowWriter&) = delete;
+    AsyncBitmapRowWriter& operator=(const AsyncBitmapRowWriter&) = delete;
+
+    ~AsyncBitmapRowWriter() {
+        queue.close();
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    // Queues next row (bytesCount <= row size with padding, the rest of the row is zero)
+    void writeRow(const void* source, uint64_t bytesCount) {
+        uint8_t* slot = queue.beginPush();
+        if (!slot) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            throw std::logic_error("Rows can't be written after finish!");
+        }
+        uint64_t copiedBytesCount = std::min(bytesCount, rowBytesCount);
+        memcpy(slot, source, copiedBytesCount);
+        memset(slot + copiedBytesCount, 0, rowBytesCount - copiedBytesCount);
+        queue.endPush();
+    }
+
+    void finish() {
+        queue.close();
+        thread.join();
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
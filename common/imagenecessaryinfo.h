@@ -1,5 +1,4 @@
-#ifndef IMAGENECESSARYINFO_H
-#define IMAGENECESSARYINFO_H
+#pragma once
 
 #include "rotatematrix.h"
 #include <cstdint>
@@ -28,5 +27,3 @@ public:
         return _rotateMatrix;
     }
 };
-
-#endif // IMAGENECESSARYINFO_H
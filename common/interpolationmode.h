@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include "kerneltables.h"
+
+// Interpolation of the rotation tools. Lanczos and the cubic filters after Bicubic are weighted by KERNEL_TABLE rows,
+// see visitInterpolationKernel
+enum class InterpolationMode
+{
+    NearestNeighbour,
+    Bilinear,
+    Bicubic,
+    Lanczos3,
+    Lanczos2,
+    Lanczos4,
+    CatmullRom,
+    Mitchell
+};
+
+// Largest kernel radius of all modes
+constexpr int64_t MAX_INTERPOLATION_RADIUS = Lanczos4Kernel::RADIUS;
+
+// Calls parFunction(Kernel()) with the kernel of a mode interpolated by KERNEL_TABLE, returns false for the other modes
+template<typename Function>
+inline bool visitInterpolationKernel(InterpolationMode parInterpolationMode, Function parFunction) {
+    switch (parInterpolationMode) {
+    case InterpolationMode::Lanczos2:
+        parFunction(Lanczos2Kernel());
+        return true;
+    case InterpolationMode::Lanczos3:
+        parFunction(Lanczos3Kernel());
+        return true;
+    case InterpolationMode::Lanczos4:
+        parFunction(Lanczos4Kernel());
+        return true;
+    case InterpolationMode::CatmullRom:
+        parFunction(CatmullRomKernel());
+        return true;
+    case InterpolationMode::Mitchell:
+        parFunction(MitchellKernel());
+        return true;
+    default:
+        return false;
+    }
+}
+
+inline bool isKernelTableInterpolation(InterpolationMode parInterpolationMode) {
+    return visitInterpolationKernel(parInterpolationMode, [](auto) {});
+}
+
+// Mode of a command line option: --nearestNeighbour, --bilinear, --bicubic, --lanczos2, --lanczos3, --lanczos4,
+// --catmullRom or --mitchell
+inline bool parseInterpolationMode(const char* parOption, InterpolationMode& parInterpolationMode) {
+    static const std::pair<const char*, InterpolationMode> OPTIONS[] = {
+        {"--nearestNeighbour", InterpolationMode::NearestNeighbour},
+        {"--bilinear", InterpolationMode::Bilinear},
+        {"--bicubic", InterpolationMode::Bicubic},
+        {"--lanczos2", InterpolationMode::Lanczos2},
+        {"--lanczos3", InterpolationMode::Lanczos3},
+        {"--lanczos4", InterpolationMode::Lanczos4},
+        {"--catmullRom", InterpolationMode::CatmullRom},
+        {"--mitchell", InterpolationMode::Mitchell}
+    };
+    for (const auto& option : OPTIONS) {
+        if (!strcmp(option.first, parOption)) {
+            parInterpolationMode = option.second;
+            return true;
+        }
+    }
+    return false;
+}
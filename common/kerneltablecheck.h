@@ -0,0 +1,104 @@
+#pragma once
+
+#include "kerneltables.h"
+#include "pixel.h"
+#include "pixeltraits.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+
+// Exact weights of the taps of delta, normalized to the sum 1 as the table rows
+template <typename Kernel>
+inline void getExactKernelWeights(double parDelta, double parWeights[2 * Kernel::RADIUS]) {
+    double sumWeight = 0;
+    for (int64_t k = 0; k < 2 * Kernel::RADIUS; k++) {
+        parWeights[k] = Kernel::getWeight(parDelta - (k - Kernel::RADIUS + 1));
+        sumWeight += parWeights[k];
+    }
+    for (int64_t k = 0; k < 2 * Kernel::RADIUS; k++) {
+        parWeights[k] /= sumWeight;
+    }
+}
+
+// Returns true if the double, float and int16_t rows of KERNEL_TABLE<Kernel> and its interpolated weights match
+// the kernel function. Interpolation between 256 phases is exact to about 1e-5, fixed point rows to half a unit
+// per tap plus the rounding error moved to the biggest tap.
+template <typename Kernel>
+inline bool checkKernelTable(const char* parKernelName) {
+    constexpr int64_t TAPS_COUNT = 2 * Kernel::RADIUS;
+    constexpr int64_t PHASES_COUNT = DEFAULT_KERNEL_PHASES;
+    constexpr double ONE = KernelTable<Kernel, int16_t>::FIXED_POINT_ONE;
+    constexpr double DOUBLE_TOLERANCE = 1e-12;
+    constexpr double FLOAT_TOLERANCE = 1e-6;
+    constexpr double INTERPOLATION_TOLERANCE = 1e-4;
+    constexpr double FIXED_POINT_TOLERANCE = (TAPS_COUNT / 2 + 0.5) / ONE;
+
+    double maxDoubleError = 0;
+    double maxFloatError = 0;
+    double maxFixedPointError = 0;
+    int64_t wrongSumsCount = 0;
+    for (int64_t phase = 0; phase <= PHASES_COUNT; phase++) {
+        double exactWeights[TAPS_COUNT];
+        getExactKernelWeights<Kernel>(static_cast<double>(phase) / PHASES_COUNT, exactWeights);
+        const double* doubleRow = KERNEL_TABLE<Kernel>.getRow(phase);
+        const float* floatRow = KERNEL_TABLE<Kernel, float>.getRow(phase);
+        const int16_t* fixedPointRow = KERNEL_TABLE<Kernel, int16_t>.getRow(phase);
+        int64_t fixedPointSum = 0;
+        for (int64_t k = 0; k < TAPS_COUNT; k++) {
+            maxDoubleError = std::max(maxDoubleError, std::abs(doubleRow[k] - exactWeights[k]));
+            maxFloatError = std::max(maxFloatError, std::abs(floatRow[k] - doubleRow[k]));
+            maxFixedPointError = std::max(maxFixedPointError, std::abs(fixedPointRow[k] / ONE - exactWeights[k]));
+            fixedPointSum += fixedPointRow[k];
+        }
+        if (fixedPointSum != ONE) {
+            wrongSumsCount++;
+        }
+    }
+
+    std::mt19937_64 generator(TAPS_COUNT);
+    std::uniform_real_distribution<double> deltaDistribution(0, 1);
+    double maxInterpolationError = 0;
+    for (int64_t i = 0; i < 10000; i++) {
+        double delta = deltaDistribution(generator);
+        double exactWeights[TAPS_COUNT];
+        double weights[TAPS_COUNT];
+        getExactKernelWeights<Kernel>(delta, exactWeights);
+        KERNEL_TABLE<Kernel>.getWeights(delta, weights);
+        for (int64_t k = 0; k < TAPS_COUNT; k++) {
+            maxInterpolationError = std::max(maxInterpolationError, std::abs(weights[k] - exactWeights[k]));
+        }
+    }
+
+    std::cout << parKernelName << ": double rows error " << maxDoubleError << ", float rows error " << maxFloatError
+              << ", fixed point rows error " << maxFixedPointError << ", wrong fixed point sums: " << wrongSumsCount
+              << ", interpolated weights error " << maxInterpolationError << std::endl;
+    return maxDoubleError <= DOUBLE_TOLERANCE && maxFloatError <= FLOAT_TOLERANCE && maxFixedPointError <= FIXED_POINT_TOLERANCE &&
+           wrongSumsCount == 0 && maxInterpolationError <= INTERPOLATION_TOLERANCE;
+}
+
+// Kernel functions against the standard library and the cubic weight of bicubic interpolation
+inline bool checkKernelFunctions() {
+    double maxSinError = 0;
+    double maxCubicError = 0;
+    for (int64_t i = -4000; i <= 4000; i++) {
+        double x = i / 1000.0;
+        maxSinError = std::max(maxSinError, std::abs(KernelMath::sinPi(x) - std::sin(KernelMath::PI * x)));
+        maxCubicError = std::max(maxCubicError, std::abs(CatmullRomKernel::getWeight(x) - PixelTraits<Bitmap24Pixel>::cubicWeight(x)));
+    }
+    std::cout << "sinPi error " << maxSinError << ", Catmull-Rom error " << maxCubicError << std::endl;
+    return maxSinError <= 1e-12 && maxCubicError <= 1e-12;
+}
+
+// Tables of every kernel of the rotation tools, returns 0 if they are correct
+inline int runKernelTableCheck() {
+    bool isCorrect = checkKernelFunctions();
+    isCorrect &= checkKernelTable<Lanczos2Kernel>("Lanczos2");
+    isCorrect &= checkKernelTable<Lanczos3Kernel>("Lanczos3");
+    isCorrect &= checkKernelTable<Lanczos4Kernel>("Lanczos4");
+    isCorrect &= checkKernelTable<CatmullRomKernel>("Catmull-Rom");
+    isCorrect &= checkKernelTable<MitchellKernel>("Mitchell");
+    std::cout << (isCorrect ? "Check passed" : "Check failed") << std::endl;
+    return isCorrect ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+// Interpolation kernels. Taps of a sample at coordinate c are pixels floor(c) - RADIUS + 1 .. floor(c) + RADIUS,
+// tap k has weight getWeight(delta - (k - RADIUS + 1)), delta = c - floor(c)
+namespace KernelMath {
+    constexpr double PI = 3.14159265358979323846;
+
+    // sin(pi * x), constexpr: reduced to [-0.5, 0.5] and summed as Taylor series
+    constexpr double sinPi(double parX) {
+        double turns = parX / 2;
+        int64_t wholeTurns = static_cast<int64_t>(turns);
+        double x = parX - 2.0 * wholeTurns;
+        if (x > 1) {
+            x -= 2;
+        } else if (x < -1) {
+            x += 2;
+        }
+        if (x > 0.5) {
+            x = 1 - x;
+        } else if (x < -0.5) {
+            x = -1 - x;
+        }
+
+        double angle = PI * x;
+        double term = angle;
+        double sum = angle;
+        for (int64_t i = 1; i < 12; i++) {
+            term *= -angle * angle / ((2 * i) * (2 * i + 1));
+            sum += term;
+        }
+        return sum;
+    }
+
+    constexpr double sinc(double parX) {
+        if (parX == 0) {
+            return 1.0;
+        }
+        return sinPi(parX) / (PI * parX);
+    }
+
+    constexpr double abs(double parX) {
+        return parX < 0 ? -parX : parX;
+    }
+
+    constexpr double lanczos(double parX, int64_t parA) {
+        if (abs(parX) >= parA) {
+            return 0.0;
+        }
+        return sinc(parX) * sinc(parX / parA);
+    }
+
+    // Mitchell-Netravali family of cubic filters
+    constexpr double cubic(double parX, double parB, double parC) {
+        double x = abs(parX);
+        if (x < 1) {
+            return ((12 - 9 * parB - 6 * parC) * x * x * x + (-18 + 12 * parB + 6 * parC) * x * x + (6 - 2 * parB)) / 6;
+        } else if (x < 2) {
+            return ((-parB - 6 * parC) * x * x * x + (6 * parB + 30 * parC) * x * x + (-12 * parB - 48 * parC) * x +
+                    (8 * parB + 24 * parC)) / 6;
+        }
+        return 0.0;
+    }
+}
+
+struct Lanczos2Kernel {
+    static constexpr int64_t RADIUS = 2;
+    static constexpr double getWeight(double parX) {
+        return KernelMath::lanczos(parX, RADIUS);
+    }
+};
+
+struct Lanczos3Kernel {
+    static constexpr int64_t RADIUS = 3;
+    static constexpr double getWeight(double parX) {
+        return KernelMath::lanczos(parX, RADIUS);
+    }
+};
+
+struct Lanczos4Kernel {
+    static constexpr int64_t RADIUS = 4;
+    static constexpr double getWeight(double parX) {
+        return KernelMath::lanczos(parX, RADIUS);
+    }
+};
+
+// Same as PixelTraits::cubicWeight with a = -0.5
+struct CatmullRomKernel {
+    static constexpr int64_t RADIUS = 2;
+    static constexpr double getWeight(double parX) {
+        return KernelMath::cubic(parX, 0, 0.5);
+    }
+};
+
+struct MitchellKernel {
+    static constexpr int64_t RADIUS = 2;
+    static constexpr double getWeight(double parX) {
+        return KernelMath::cubic(parX, 1.0 / 3, 1.0 / 3);
+    }
+};
+
+// Weights of all taps for parPhases + 1 sub-pixel phases delta = phase / parPhases, taps of a phase are stored together,
+// so one lookup gives the whole kernel row. Rows are normalized to the sum 1, int16_t rows are fixed point with
+// the sum FIXED_POINT_ONE exactly. Tables are generated at compile time, see KERNEL_TABLE.
+constexpr int64_t DEFAULT_KERNEL_PHASES = 256;
+
+template<typename Kernel, typename WeightType = double, int64_t parPhases = DEFAULT_KERNEL_PHASES>
+class KernelTable
+{
+    static_assert(std::is_same_v<WeightType, double> || std::is_same_v<WeightType, float> || std::is_same_v<WeightType, int16_t>);
+
+public:
+    static constexpr int64_t RADIUS = Kernel::RADIUS;
+    static constexpr int64_t TAPS_COUNT = 2 * Kernel::RADIUS;
+    static constexpr int64_t PHASES_COUNT = parPhases;
+    static constexpr int64_t FIXED_POINT_SHIFT = 14;
+    static constexpr int64_t FIXED_POINT_ONE = int64_t(1) << FIXED_POINT_SHIFT;
+
+private:
+    std::array<WeightType, (parPhases + 1) * TAPS_COUNT> _rows;
+
+    static constexpr int64_t roundToInteger(double parValue) {
+        return parValue < 0 ? -static_cast<int64_t>(-parValue + 0.5) : static_cast<int64_t>(parValue + 0.5);
+    }
+
+public:
+    constexpr KernelTable() : _rows() {
+        for (int64_t phase = 0; phase <= parPhases; phase++) {
+            double delta = static_cast<double>(phase) / parPhases;
+            double weights[TAPS_COUNT] = {};
+            double sumWeight = 0;
+            for (int64_t k = 0; k < TAPS_COUNT; k++) {
+                weights[k] = Kernel::getWeight(delta - (k - RADIUS + 1));
+                sumWeight += weights[k];
+            }
+
+            WeightType* row = _rows.data() + phase * TAPS_COUNT;
+            if constexpr (std::is_same_v<WeightType, int16_t>) {
+                // The rounding error goes to the biggest tap
+                int64_t sumFixed = 0;
+                int64_t biggestTap = 0;
+                for (int64_t k = 0; k < TAPS_COUNT; k++) {
+                    row[k] = static_cast<int16_t>(roundToInteger(weights[k] / sumWeight * FIXED_POINT_ONE));
+                    sumFixed += row[k];
+                    if (row[k] > row[biggestTap]) {
+                        biggestTap = k;
+                    }
+                }
+                row[biggestTap] = static_cast<int16_t>(row[biggestTap] + FIXED_POINT_ONE - sumFixed);
+            } else {
+                for (int64_t k = 0; k < TAPS_COUNT; k++) {
+                    row[k] = static_cast<WeightType>(weights[k] / sumWeight);
+                }
+            }
+        }
+    }
+
+    constexpr const WeightType* getRow(int64_t parPhase) const {
+        return _rows.data() + parPhase * TAPS_COUNT;
+    }
+
+    // Row of the nearest phase, parDelta in [0, 1]
+    const WeightType* getNearestRow(double parDelta) const {
+        return getRow(static_cast<int64_t>(parDelta * parPhases + 0.5));
+    }
+
+    // Weights linearly interpolated between the two neighbour phases, parDelta in [0, 1]
+    template<typename OutputType>
+    void getWeights(double parDelta, OutputType* parWeights) const {
+        static_assert(!std::is_same_v<WeightType, int16_t>, "Fixed point rows are used as is, see getNearestRow");
+        double position = parDelta * parPhases;
+        int64_t phase = std::min<int64_t>(static_cast<int64_t>(position), parPhases - 1);
+        double fraction = position - phase;
+        const WeightType* row = getRow(phase);
+        const WeightType* nextRow = row + TAPS_COUNT;
+        for (int64_t k = 0; k < TAPS_COUNT; k++) {
+            parWeights[k] = row[k] + (nextRow[k] - row[k]) * fraction;
+        }
+    }
+};
+
+template<typename Kernel, typename WeightType = double, int64_t parPhases = DEFAULT_KERNEL_PHASES>
+inline constexpr KernelTable<Kernel, WeightType, parPhases> KERNEL_TABLE{};
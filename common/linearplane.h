@@ -0,0 +1,68 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include "pixeltraits.h"
+
+// Source plane of the rotation self-checks: every channel is a linear function of the pixel coordinates with integer
+// values at integer coordinates, so bilinear interpolation reproduces it up to rounding and a rotated plane can be checked
+// pixel by pixel. Values of 8-bit channels stay in range for coordinates -5..65, other integer channels are scaled
+// to their range, real channels are negative.
+template <typename PixelType>
+class LinearPlane {
+    using Traits = PixelTraits<PixelType>;
+    using ChannelType = typename Traits::ChannelType;
+
+    static constexpr double BASES[3] = {20, 40, 230};
+    static constexpr double SLOPES_X[3] = {1, 2, -1};
+    static constexpr double SLOPES_Y[3] = {2, 1, -1};
+
+    static double getScale() {
+        if constexpr (std::is_integral_v<ChannelType>) {
+            return PixelType::getMaxChannelValue() / 255.0;
+        } else {
+            return -3.25;
+        }
+    }
+
+public:
+    void getValues(double parX, double parY, double parValues[Traits::CHANNELS_COUNT]) const {
+        for (int64_t c = 0; c < Traits::CHANNELS_COUNT; c++) {
+            parValues[c] = getScale() * (BASES[c] + SLOPES_X[c] * parX + SLOPES_Y[c] * parY);
+        }
+    }
+
+    PixelType getPixel(int64_t parCol, int64_t parRow) const {
+        double values[Traits::CHANNELS_COUNT];
+        getValues(parCol, parRow, values);
+        return Traits::makePixel(values);
+    }
+
+    // Largest channel difference of the pixel from the plane at (parX, parY)
+    double getError(const PixelType& parPixel, double parX, double parY) const {
+        double values[Traits::CHANNELS_COUNT];
+        double channels[Traits::CHANNELS_COUNT];
+        getValues(parX, parY, values);
+        Traits::getChannels(parPixel, channels);
+        double error = 0;
+        for (int64_t c = 0; c < Traits::CHANNELS_COUNT; c++) {
+            error = std::max(error, std::abs(channels[c] - values[c]));
+        }
+        return error;
+    }
+
+    // Integer channels are truncated, real ones are rounded to float at worst
+    static double getTolerance() {
+        return std::is_integral_v<ChannelType> ? 1.0 : 1e-3;
+    }
+
+    static bool isSame(const PixelType& parPixel1, const PixelType& parPixel2) {
+        double channels1[Traits::CHANNELS_COUNT];
+        double channels2[Traits::CHANNELS_COUNT];
+        Traits::getChannels(parPixel1, channels1);
+        Traits::getChannels(parPixel2, channels2);
+        return std::equal(channels1, channels1 + Traits::CHANNELS_COUNT, channels2);
+    }
+};
@@ -0,0 +1,306 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Rows of BMP pixel data are aligned to 4 bytes
+inline uint64_t getBitmapRowBytesCount(int32_t width, uint16_t bitCount) {
+    return (static_cast<uint64_t>(width) * bitCount / 8 + 3) & ~3ull;
+}
+
+// Whole file mapped to memory: read-only for existing files, read-write for created ones
+class MappedFile
+{
+private:
+#ifdef _WIN32
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mappingHandle = nullptr;
+#else
+    int fileDescriptor = -1;
+#endif
+    uint8_t* data = nullptr;
+    uint64_t size = 0;
+
+    void release() {
+#ifdef _WIN32
+        if (data) {
+            UnmapViewOfFile(data);
+        }
+        if (mappingHandle) {
+            CloseHandle(mappingHandle);
+        }
+        if (fileHandle != INVALID_HANDLE_VALUE) {
+            CloseHandle(fileHandle);
+        }
+        fileHandle = INVALID_HANDLE_VALUE;
+        mappingHandle = nullptr;
+#else
+        if (data) {
+            munmap(data, size);
+        }
+        if (fileDescriptor >= 0) {
+            close(fileDescriptor);
+        }
+        fileDescriptor = -1;
+#endif
+        data = nullptr;
+        size = 0;
+    }
+
+    void map(bool isWritable) {
+#ifdef _WIN32
+        mappingHandle = CreateFileMappingA(fileHandle, nullptr, isWritable ? PAGE_READWRITE : PAGE_READONLY,
+                                           static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr);
+        if (!mappingHandle) {
+            release();
+            throw std::runtime_error("Can't map file!");
+        }
+        data = static_cast<uint8_t*>(MapViewOfFile(mappingHandle, isWritable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size));
+        if (!data) {
+            release();
+            throw std::runtime_error("Can't map file!");
+        }
+#else
+        void* address = mmap(nullptr, size, isWritable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fileDescriptor, 0);
+        if (address == MAP_FAILED) {
+            release();
+            throw std::runtime_error("Can't map file!");
+        }
+        data = static_cast<uint8_t*>(address);
+#endif
+    }
+
+public:
+    MappedFile(const std::string& fileName) {
+#ifdef _WIN32
+        fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        LARGE_INTEGER fileSize;
+        if (fileHandle == INVALID_HANDLE_VALUE || !GetFileSizeEx(fileHandle, &fileSize)) {
+            release();
+            throw std::runtime_error("Can't open file " + fileName + "!");
+        }
+        size = fileSize.QuadPart;
+#else
+        fileDescriptor = open(fileName.c_str(), O_RDONLY);
+        struct stat fileStat;
+        if (fileDescriptor < 0 || fstat(fileDescriptor, &fileStat) != 0) {
+            release();
+            throw std::runtime_error("Can't open file " + fileName + "!");
+        }
+        size = fileStat.st_size;
+#endif
+        if (size == 0) {
+            release();
+            throw std::runtime_error("File " + fileName + " is empty!");
+        }
+        map(false);
+    }
+
+    MappedFile(const std::string& fileName, uint64_t fileSize) {
+        size = fileSize;
+#ifdef _WIN32
+        fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE) {
+            release();
+            throw std::runtime_error("Can't create file " + fileName + "!");
+        }
+#else
+        fileDescriptor = open(fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fileDescriptor < 0 || ftruncate(fileDescriptor, size) != 0) {
+            release();
+            throw std::runtime_error("Can't create file " + fileName + "!");
+        }
+#endif
+        map(true);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            release();
+#ifdef _WIN32
+            std::swap(fileHandle, other.fileHandle);
+            std::swap(mappingHandle, other.mappingHandle);
+#else
+            std::swap(fileDescriptor, other.fileDescriptor);
+#endif
+            std::swap(data, other.data);
+            std::swap(size, other.size);
+        }
+        return *this;
+    }
+
+    ~MappedFile() {
+        release();
+    }
+
+    uint8_t* getData() const {
+        return data;
+    }
+
+    uint64_t getSize() const {
+        return size;
+    }
+
+    void adviseSequential() const {
+#ifndef _WIN32
+        madvise(data, size, MADV_SEQUENTIAL);
+#endif
+    }
+
+    void adviseRandom() const {
+#ifndef _WIN32
+        madvise(data, size, MADV_RANDOM);
+#endif
+    }
+};
+
+// Rows are addressed in the usual bottom-up BMP order (row 0 is the bottom one),
+// also for top-down files with negative biHeight. Rows point straight into the mapped file.
+class MappedBitmapReader
+{
+private:
+    static constexpr uint64_t FILE_HEADER_SIZE = 14;
+    static constexpr uint64_t MIN_HEADERS_SIZE = FILE_HEADER_SIZE + 16;
+
+    MappedFile file;
+    uint64_t dataOffset;
+    int32_t width;
+    int32_t height;
+    uint16_t bitCount;
+    bool isTopDown;
+    uint64_t rowBytesCountWithPadding;
+
+    template<typename T>
+    T readHeaderField(uint64_t offset) const {
+        T value;
+        memcpy(&value, file.getData() + offset, sizeof(T));
+        return value;
+    }
+
+public:
+    static constexpr uint16_t BITMAP_TYPE = 0x4d42;
+
+    MappedBitmapReader(const std::string& fileName) : file(fileName) {
+        if (file.getSize() < MIN_HEADERS_SIZE || readHeaderField<uint16_t>(0) != BITMAP_TYPE) {
+            throw std::runtime_error("Not BMP file!");
+        }
+
+        dataOffset = readHeaderField<uint32_t>(10);
+        width = readHeaderField<int32_t>(FILE_HEADER_SIZE + 4);
+        int32_t signedHeight = readHeaderField<int32_t>(FILE_HEADER_SIZE + 8);
+        bitCount = readHeaderField<uint16_t>(FILE_HEADER_SIZE + 14);
+        isTopDown = signedHeight < 0;
+        height = isTopDown ? -signedHeight : signedHeight;
+
+        if (width <= 0 || height <= 0) {
+            throw std::runtime_error("Error reading source file!");
+        }
+        rowBytesCountWithPadding = getBitmapRowBytesCount(width, bitCount);
+        if (dataOffset + rowBytesCountWithPadding * height > file.getSize()) {
+            throw std::runtime_error("Error reading source file!");
+        }
+    }
+
+    // Copies headers of the tool's own layout, e.g. BitmapFileHeader + BitmapInfoHeaderV3
+    template<typename FileHeader, typename InfoHeader>
+    void readHeaders(FileHeader& fileHeader, InfoHeader& infoHeader) const {
+        if (sizeof(FileHeader) + sizeof(InfoHeader) > dataOffset) {
+            throw std::runtime_error("Error reading source file!");
+        }
+        memcpy(&fileHeader, file.getData(), sizeof(FileHeader));
+        memcpy(&infoHeader, file.getData() + sizeof(FileHeader), sizeof(InfoHeader));
+    }
+
+    uint64_t getDataOffset() const {
+        return dataOffset;
+    }
+
+    int32_t getWidth() const {
+        return width;
+    }
+
+    int32_t getHeight() const {
+        return height;
+    }
+
+    uint16_t getBitCount() const {
+        return bitCount;
+    }
+
+    uint64_t getRowBytesCountWithPadding() const {
+        return rowBytesCountWithPadding;
+    }
+
+    uint64_t getRowFileOffset(int64_t row) const {
+        int64_t storedRow = isTopDown ? height - row - 1 : row;
+        return dataOffset + storedRow * rowBytesCountWithPadding;
+    }
+
+    const uint8_t* getRow(int64_t row) const {
+        return file.getData() + getRowFileOffset(row);
+    }
+
+    void adviseSequential() const {
+        file.adviseSequential();
+    }
+
+    void adviseRandom() const {
+        file.adviseRandom();
+    }
+};
+
+// Output file is created with its final size, headers are copied from the caller,
+// rows (bottom-up order) are written in place, padding bytes stay zero.
+class MappedBitmapWriter
+{
+private:
+    MappedFile file;
+    uint64_t dataOffset;
+    uint64_t rowBytesCountWithPadding;
+
+public:
+    // Headers are written as is, so bfOffBits must be sizeof(FileHeader) + sizeof(InfoHeader)
+    template<typename FileHeader, typename InfoHeader>
+    MappedBitmapWriter(const std::string& fileName, const FileHeader& fileHeader, const InfoHeader& infoHeader,
+                       int32_t width, int32_t height, uint16_t bitCount = 24)
+        : file(fileName, sizeof(FileHeader) + sizeof(InfoHeader) + getBitmapRowBytesCount(width, bitCount) * height) {
+        dataOffset = sizeof(FileHeader) + sizeof(InfoHeader);
+        rowBytesCountWithPadding = getBitmapRowBytesCount(width, bitCount);
+        memcpy(file.getData(), &fileHeader, sizeof(FileHeader));
+        memcpy(file.getData() + sizeof(FileHeader), &infoHeader, sizeof(InfoHeader));
+    }
+
+    uint64_t getRowBytesCountWithPadding() const {
+        return rowBytesCountWithPadding;
+    }
+
+    uint64_t getRowFileOffset(int64_t row) const {
+        return dataOffset + row * rowBytesCountWithPadding;
+    }
+
+    uint8_t* getRow(int64_t row) const {
+        return file.getData() + getRowFileOffset(row);
+    }
+};
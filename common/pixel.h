@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <complex>
+
+// Pixels of the TIFF images of 2_tiff and 6_h_a_alpha, rotated without conversion to Bitmap24Pixel
+
+struct Tiff16RGBPixel
+{
+    using ChannelType = uint16_t;
+
+    uint16_t red;
+    uint16_t green;
+    uint16_t blue;
+
+    Tiff16RGBPixel() {
+
+    }
+
+    Tiff16RGBPixel(uint16_t red, uint16_t green, uint16_t blue) {
+        this->red = red;
+        this->green = green;
+        this->blue = blue;
+    }
+
+    static uint64_t getMaxChannelValue() {
+        return UINT16_MAX;
+    }
+};
+
+// One channel of real values: intensity, amplitude, elements of coherency matrices
+struct FloatPixel
+{
+    using ChannelType = float;
+
+    float channel;
+
+    FloatPixel() {
+
+    }
+
+    FloatPixel(float value) {
+        channel = value;
+    }
+};
+
+// SAR complex sample, real and imaginary parts are interpolated independently
+#pragma pack(push, 1)
+struct Complex16Pixel
+{
+    using ChannelType = double;
+
+    double real;
+    double imag;
+
+    Complex16Pixel() {
+
+    }
+
+    Complex16Pixel(std::complex<double> value) {
+        real = value.real();
+        imag = value.imag();
+    }
+
+    Complex16Pixel(double real, double imag) {
+        this->real = real;
+        this->imag = imag;
+    }
+};
+#pragma pack(pop)
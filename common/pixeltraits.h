@@ -0,0 +1,160 @@
+#pragma once
+
+#include "kerneltables.h"
+#include "pixel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Interpolation of any pixel type channel by channel in double. Traits provide CHANNELS_COUNT,
+// getChannels(pixel, values) and makePixel(values), which converts interpolated values back to channels.
+template <typename PixelType, typename Traits>
+struct PixelInterpolation {
+    static PixelType interpolateBilinear(const PixelType& parPixel1, const PixelType& parPixel2,
+                                         const PixelType& parPixel3, const PixelType& parPixel4,
+                                         double parDx, double parDy) {
+        double channels1[Traits::CHANNELS_COUNT];
+        double channels2[Traits::CHANNELS_COUNT];
+        double channels3[Traits::CHANNELS_COUNT];
+        double channels4[Traits::CHANNELS_COUNT];
+        Traits::getChannels(parPixel1, channels1);
+        Traits::getChannels(parPixel2, channels2);
+        Traits::getChannels(parPixel3, channels3);
+        Traits::getChannels(parPixel4, channels4);
+
+        double values[Traits::CHANNELS_COUNT];
+        for (int64_t c = 0; c < Traits::CHANNELS_COUNT; c++) {
+            values[c] = (1 - parDx) * (1 - parDy) * channels1[c] +
+                        parDx * (1 - parDy) * channels2[c] +
+                        (1 - parDx) * parDy * channels3[c] +
+                        parDx * parDy * channels4[c];
+        }
+        return Traits::makePixel(values);
+    }
+
+    static double cubicWeight(double parX, double parA = -0.5) {
+        parX = std::abs(parX);
+        if (parX < 1) {
+            return (parA + 2) * parX * parX * parX - (parA + 3) * parX * parX + 1;
+        } else if (parX < 2) {
+            return parA * parX * parX * parX - 5 * parA * parX * parX + 8 * parA * parX - 4 * parA;
+        }
+        return 0.0;
+    }
+
+    static PixelType interpolateBicubic(const PixelType parPixels[4][4], double parDx, double parDy) {
+        double weightsX[4];
+        double weightsY[4];
+        for (int64_t i = 0; i < 4; i++) {
+            weightsX[i] = cubicWeight(parDx - (i - 1));
+            weightsY[i] = cubicWeight(parDy - (i - 1));
+        }
+
+        double values[Traits::CHANNELS_COUNT] = {};
+        for (int64_t j = 0; j < 4; ++j) {
+            double rowResults[Traits::CHANNELS_COUNT] = {};
+            for (int64_t i = 0; i < 4; ++i) {
+                double channels[Traits::CHANNELS_COUNT];
+                Traits::getChannels(parPixels[j][i], channels);
+                for (int64_t c = 0; c < Traits::CHANNELS_COUNT; c++) {
+                    rowResults[c] += weightsX[i] * channels[c];
+                }
+            }
+            for (int64_t c = 0; c < Traits::CHANNELS_COUNT; c++) {
+                values[c] += weightsY[j] * rowResults[c];
+            }
+        }
+        return Traits::makePixel(values);
+    }
+
+    // Weight of the pixel (i, j) is the product of one-dimensional KERNEL_TABLE rows, rows are normalized.
+    // parPixels[j][i] is the pixel (floor(y) - RADIUS + 1 + j, floor(x) - RADIUS + 1 + i), parDx = x - floor(x)
+    template<typename Kernel>
+    static PixelType interpolateKernel(const PixelType (&parPixels)[2 * Kernel::RADIUS][2 * Kernel::RADIUS], double parDx, double parDy) {
+        constexpr int64_t TAPS_COUNT = 2 * Kernel::RADIUS;
+        double weightsX[TAPS_COUNT];
+        double weightsY[TAPS_COUNT];
+        KERNEL_TABLE<Kernel>.getWeights(parDx, weightsX);
+        KERNEL_TABLE<Kernel>.getWeights(parDy, weightsY);
+
+        double values[Traits::CHANNELS_COUNT] = {};
+        for (int64_t j = 0; j < TAPS_COUNT; j++) {
+            for (int64_t i = 0; i < TAPS_COUNT; i++) {
+                double channels[Traits::CHANNELS_COUNT];
+                Traits::getChannels(parPixels[j][i], channels);
+                for (int64_t c = 0; c < Traits::CHANNELS_COUNT; c++) {
+                    values[c] += weightsX[i] * weightsY[j] * channels[c];
+                }
+            }
+        }
+        return Traits::makePixel(values);
+    }
+};
+
+// Pixels with red, green and blue integer channels (Bitmap24Pixel, Tiff16RGBPixel): white outside of the image,
+// interpolated values are clamped to the channel range and truncated
+template <typename PixelType>
+struct PixelTraits : PixelInterpolation<PixelType, PixelTraits<PixelType>> {
+    using ChannelType = typename PixelType::ChannelType;
+    static constexpr int64_t CHANNELS_COUNT = 3;
+
+    static PixelType getDefaultPixel() {
+        return PixelType(
+            PixelType::getMaxChannelValue(),
+            PixelType::getMaxChannelValue(),
+            PixelType::getMaxChannelValue()
+        );
+    }
+
+    static void getChannels(const PixelType& parPixel, double parValues[CHANNELS_COUNT]) {
+        parValues[0] = parPixel.red;
+        parValues[1] = parPixel.green;
+        parValues[2] = parPixel.blue;
+    }
+
+    static PixelType makePixel(const double parValues[CHANNELS_COUNT]) {
+        auto toChannel = [](double value) {
+            return static_cast<ChannelType>(std::clamp(value, 0.0, static_cast<double>(PixelType::getMaxChannelValue())));
+        };
+        return PixelType(toChannel(parValues[0]), toChannel(parValues[1]), toChannel(parValues[2]));
+    }
+};
+
+// Zero outside of the image, values are not clamped
+template <>
+struct PixelTraits<FloatPixel> : PixelInterpolation<FloatPixel, PixelTraits<FloatPixel>> {
+    using ChannelType = float;
+    static constexpr int64_t CHANNELS_COUNT = 1;
+
+    static FloatPixel getDefaultPixel() {
+        return FloatPixel(0);
+    }
+
+    static void getChannels(const FloatPixel& parPixel, double parValues[CHANNELS_COUNT]) {
+        parValues[0] = parPixel.channel;
+    }
+
+    static FloatPixel makePixel(const double parValues[CHANNELS_COUNT]) {
+        return FloatPixel(static_cast<float>(parValues[0]));
+    }
+};
+
+// Zero outside of the image, real and imaginary parts are interpolated as two channels
+template <>
+struct PixelTraits<Complex16Pixel> : PixelInterpolation<Complex16Pixel, PixelTraits<Complex16Pixel>> {
+    using ChannelType = double;
+    static constexpr int64_t CHANNELS_COUNT = 2;
+
+    static Complex16Pixel getDefaultPixel() {
+        return Complex16Pixel(0.0, 0.0);
+    }
+
+    static void getChannels(const Complex16Pixel& parPixel, double parValues[CHANNELS_COUNT]) {
+        parValues[0] = parPixel.real;
+        parValues[1] = parPixel.imag;
+    }
+
+    static Complex16Pixel makePixel(const double parValues[CHANNELS_COUNT]) {
+        return Complex16Pixel(parValues[0], parValues[1]);
+    }
+};
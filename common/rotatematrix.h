@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ROTATE_MATRIX_X86
+#endif
+
+class RotateMatrix
+{
+private:
+    double _phi;
+    double _deltaWidth;
+    double _deltaHeight;
+    double _zoom;
+    double _cos;
+    double _sin;
+
+#ifdef ROTATE_MATRIX_X86
+    static bool isAvx2Supported() {
+        static const bool isSupported = []() {
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+        }();
+        return isSupported;
+    }
+
+    // Without FMA, so every lane is rounded exactly as the scalar code
+    __attribute__((target("avx2")))
+    int64_t getXYReverseRowCoordinatesAvx2(int64_t parX2, int64_t parCount, double parSinY, double parCosY,
+                                           double* parX1, double* parY1) const {
+        const __m256d cosPhi = _mm256_set1_pd(_cos);
+        const __m256d sinPhi = _mm256_set1_pd(_sin);
+        const __m256d sinY = _mm256_set1_pd(parSinY);
+        const __m256d cosY = _mm256_set1_pd(parCosY);
+        const __m256d deltaWidth = _mm256_set1_pd(_deltaWidth);
+        const __m256d zoom = _mm256_set1_pd(_zoom);
+        const __m256d laneOffsets = _mm256_set_pd(3, 2, 1, 0);
+
+        int64_t k = 0;
+        for (; k + 4 <= parCount; k += 4) {
+            __m256d x2 = _mm256_add_pd(_mm256_set1_pd(static_cast<double>(parX2 + k)), laneOffsets);
+            __m256d x = _mm256_sub_pd(x2, deltaWidth);
+            _mm256_storeu_pd(parX1 + k, _mm256_div_pd(_mm256_sub_pd(_mm256_mul_pd(cosPhi, x), sinY), zoom));
+            _mm256_storeu_pd(parY1 + k, _mm256_div_pd(_mm256_add_pd(_mm256_mul_pd(sinPhi, x), cosY), zoom));
+        }
+        return k;
+    }
+#endif
+
+public:
+    // Output rows are processed in blocks of this length, coordinates of a block are calculated at once
+    static constexpr int64_t ROW_BLOCK_LENGTH = 64;
+
+    RotateMatrix(): _phi(0), _deltaWidth(0), _deltaHeight(0), _zoom(1), _cos(1), _sin(0) {}
+
+    RotateMatrix(double parPhi, double parDeltaWidth, double parDeltaHeight, double parZoom):
+        _phi(parPhi),
+        _deltaWidth(parDeltaWidth),
+        _deltaHeight(parDeltaHeight),
+        _zoom(parZoom),
+        _cos(cos(parPhi)),
+        _sin(sin(parPhi)) { }
+
+    double getPhi() const {
+        return _phi;
+    }
+
+    double getZoom() const {
+        return _zoom;
+    }
+
+    double getDeltaWidth() const {
+        return _deltaWidth;
+    }
+
+    double getDeltaHeight() const {
+        return _deltaHeight;
+    }
+
+    // Zoom without rotation, reverse coordinates of a column don't depend on the row and vice versa
+    bool isZoomOnly() const {
+        return _sin == 0 && _cos == 1;
+    }
+
+    std::pair<double, double> getNewPixelCoordinates(int64_t parX1, int64_t parY1) const {
+        double x2 = _zoom * _cos * parX1 + _zoom * _sin * parY1 + _deltaWidth;
+        double y2 = -1 * _zoom * _sin * parX1 + _zoom * _cos * parY1 + _deltaHeight;
+        return {x2, y2};
+    }
+
+    // std::pair<double, double> getXYReverseCoordinates(int64_t parX2, int64_t parY2) const {
+    //     double y1 = (parY2 - _deltaHeight + (parX2 + _deltaWidth) * tan(_phi)) * cos(_phi) / _zoom;
+    //     double x1 = (parX2 - _deltaWidth) / (_zoom * cos(_phi)) - y1 * tan(_phi);
+    //     return {x1, y1};
+    // }
+
+    std::pair<double, double> getXYReverseCoordinates(int64_t parX2, int64_t parY2) const {
+        double x = parX2 - _deltaWidth;
+        double y = parY2 - _deltaHeight;
+        double x1 = (_cos * x - _sin * y) / _zoom;
+        double y1 = (_sin * x + _cos * y) / _zoom;
+        return {x1, y1};
+    }
+
+    // Reverse coordinates of parCount pixels (parX2, parY2), (parX2 + 1, parY2), ... of one output row.
+    // Same operations as getXYReverseCoordinates with the row terms calculated once, results are bit-exact,
+    // because truncating interpolations of flat areas change with the smallest coordinate error.
+    void getXYReverseRowCoordinates(int64_t parX2, int64_t parY2, int64_t parCount, double* parX1, double* parY1) const {
+        double y = parY2 - _deltaHeight;
+        double sinY = _sin * y;
+        double cosY = _cos * y;
+        int64_t k = 0;
+#ifdef ROTATE_MATRIX_X86
+        if (isAvx2Supported()) {
+            k = getXYReverseRowCoordinatesAvx2(parX2, parCount, sinY, cosY, parX1, parY1);
+        }
+#endif
+        for (; k < parCount; k++) {
+            double x = (parX2 + k) - _deltaWidth;
+            parX1[k] = (_cos * x - sinY) / _zoom;
+            parY1[k] = (_sin * x + cosY) / _zoom;
+        }
+    }
+};
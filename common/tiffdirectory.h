@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <istream>
+#include <stdexcept>
+
+// Header and first IFD of uncompressed little-endian TIFF and BigTIFF files read by 2_tiff and 6_h_a_alpha
+
+struct TiffFileHeader
+{
+    uint16_t byteOrder;
+    uint16_t versionNumber;
+    uint32_t offsetIFD;
+};
+
+struct TiffIFDEntry {
+    uint16_t tag;
+    uint16_t fieldType;
+    uint32_t numberValues;
+    uint32_t valueOffset;
+};
+
+
+// BigTIFF (version 43): 8-byte offsets and counts
+#pragma pack(push, 1)
+struct BigTiffFileHeader
+{
+    uint16_t byteOrder;
+    uint16_t versionNumber;
+    uint16_t offsetBytesCount;
+    uint16_t reserved;
+    uint64_t offsetIFD;
+};
+
+struct BigTiffIFDEntry {
+    uint16_t tag;
+    uint16_t fieldType;
+    uint64_t numberValues;
+    uint64_t valueOffset;
+};
+#pragma pack(pop)
+
+
+struct TiffIFD {
+    uint16_t numberEntries;
+    std::unique_ptr<TiffIFDEntry[]> entries;
+    uint32_t padding;
+    TiffIFD(uint16_t numberEntries): padding(0) {
+        this->numberEntries = numberEntries;
+        entries = std::make_unique<TiffIFDEntry[]>(numberEntries);
+    }
+};
+
+enum TiffTagEnum : uint16_t {
+    ImageWidth = 256,
+    ImageLength = 257,
+    BitsPerSample = 258,
+    Compression = 259,
+    PhotometricInterpretation = 262,
+    StripOffsets = 273,
+    SamplesPerPixel = 277,
+    RowsPerStrip = 278,
+    StripByteCounts = 279,
+    PlanarConfiguration = 284,
+    TileWidth = 322,
+    TileLength = 323,
+    TileOffsets = 324,
+    TileByteCounts = 325
+};
+
+enum class FieldType : uint16_t {
+    Byte = 1,
+    Ascii = 2,
+    Short = 3,
+    Long = 4,
+    Rational = 5,
+    /* In Tiff 6.0 additionally */
+    Sbyte = 6,
+    Undefined = 7,
+    Sshort = 8,
+    Slong = 9,
+    Srational = 10,
+    Float = 11,
+    Double = 12,
+    /* BigTIFF */
+    Long8 = 16,
+    Slong8 = 17,
+    Ifd8 = 18
+};
+
+// Entries of the first IFD of a classic TIFF or BigTIFF, classic entries are widened to BigTiffIFDEntry.
+// Values of count * size <= getInlineValuesBytesCount() bytes are stored in valueOffset itself.
+struct TiffDirectory {
+    bool isBigTiff;
+    std::vector<BigTiffIFDEntry> entries;
+
+    uint64_t getInlineValuesBytesCount() const {
+        return isBigTiff ? sizeof(uint64_t) : sizeof(uint32_t);
+    }
+};
+
+inline TiffDirectory readTiffDirectory(std::istream& inputStream) {
+    TiffFileHeader tiffFileHeader;
+    inputStream.read(reinterpret_cast<char*>(&tiffFileHeader), sizeof(TiffFileHeader));
+    if (inputStream.fail() || tiffFileHeader.byteOrder != 0x4949) {
+        throw std::runtime_error("Not little-endian TIFF!");
+    }
+
+    TiffDirectory directory;
+    if (tiffFileHeader.versionNumber == 42) {
+        directory.isBigTiff = false;
+        inputStream.seekg(tiffFileHeader.offsetIFD, std::ios::beg);
+        uint16_t numberEntries = 0;
+        inputStream.read(reinterpret_cast<char*>(&numberEntries), sizeof(uint16_t));
+        TiffIFD tiffIFD(numberEntries);
+        inputStream.read(reinterpret_cast<char*>(tiffIFD.entries.get()), numberEntries * sizeof(TiffIFDEntry));
+        for (uint16_t i = 0; i < numberEntries && !inputStream.fail(); i++) {
+            const TiffIFDEntry& entry = tiffIFD.entries[i];
+            directory.entries.push_back({entry.tag, entry.fieldType, entry.numberValues, entry.valueOffset});
+        }
+    } else if (tiffFileHeader.versionNumber == 43) {
+        directory.isBigTiff = true;
+        BigTiffFileHeader bigTiffFileHeader;
+        inputStream.seekg(0, std::ios::beg);
+        inputStream.read(reinterpret_cast<char*>(&bigTiffFileHeader), sizeof(BigTiffFileHeader));
+        if (inputStream.fail() || bigTiffFileHeader.offsetBytesCount != sizeof(uint64_t)) {
+            throw std::runtime_error("Unknown BigTIFF offset size!");
+        }
+        inputStream.seekg(bigTiffFileHeader.offsetIFD, std::ios::beg);
+        uint64_t numberEntries = 0;
+        inputStream.read(reinterpret_cast<char*>(&numberEntries), sizeof(uint64_t));
+        directory.entries.resize(inputStream.fail() ? 0 : numberEntries);
+        inputStream.read(reinterpret_cast<char*>(directory.entries.data()), directory.entries.size() * sizeof(BigTiffIFDEntry));
+    } else {
+        throw std::runtime_error("Unknown TIFF version!");
+    }
+
+    if (inputStream.fail()) {
+        throw std::runtime_error("Error reading IFD!");
+    }
+    return directory;
+}